@@ -0,0 +1,183 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+#include "../PlatformHeadless.h"
+#include "../petrobots.h"
+
+// Compiles the levels into map files of the latest version, with the
+// unit ranges and map size of the build and the level index the game
+// would otherwise build at load time.
+
+#define TIMING_ROUNDS 1000
+
+static const char* dataPath = "..";
+static const char* outputPath = ".";
+
+static uint64_t nanoseconds()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+static void write16(uint8_t*& position, uint16_t value)
+{
+    *position++ = value & 0xff;
+    *position++ = value >> 8;
+}
+
+static void write32(uint8_t*& position, uint32_t value)
+{
+    write16(position, value & 0xffff);
+    write16(position, value >> 16);
+}
+
+// Writes the unpacked level of the game to file, returning its size
+static uint32_t packMap(Game* game, uint8_t* file)
+{
+    uint8_t* position = file;
+    *position++ = 'P';
+    *position++ = 'R';
+    *position++ = 'X';
+    *position++ = MAP_EXTENDED_VERSION;
+    for (uint8_t range = 0; range != UNIT_RANGES; range++) {
+        *position++ = UNIT_RANGE_START[range + 1] - UNIT_RANGE_START[range];
+    }
+    write16(position, PLATFORM_MAP_WIDTH);
+    write16(position, PLATFORM_MAP_HEIGHT);
+    memcpy(position, game->MAP_DATA, 8 * UNIT_COUNT + 256);
+    position += 8 * UNIT_COUNT + 256;
+    for (uint16_t y = 0; y != PLATFORM_MAP_HEIGHT; y++) {
+        for (uint16_t x = 0; x != PLATFORM_MAP_WIDTH; x++) {
+            *position++ = game->MAP[MAP_CELL(x, y)];
+        }
+    }
+
+    // Floors without an elevator at the end are left out
+    int floors = 256;
+    while (floors != 0 && game->ELEVATOR_UNIT[floors - 1] == 255) {
+        floors--;
+    }
+    *position++ = floors;
+    for (int floor = 0; floor != floors; floor++) {
+        uint8_t unit = game->ELEVATOR_UNIT[floor];
+        *position++ = unit != 255 ? unit - UNIT_DOORS : 255;
+    }
+    for (uint16_t y = 0; y != PLATFORM_MAP_HEIGHT; y++) {
+        for (uint16_t word = 0; word != PLANE_ROW_WORDS; word++) {
+            write32(position, game->HIDDEN_PLANE[y][word]);
+        }
+    }
+    return position - file;
+}
+
+static int countBits(Game* game)
+{
+    int count = 0;
+    for (uint16_t y = 0; y != PLATFORM_MAP_HEIGHT; y++) {
+        for (uint16_t word = 0; word != PLANE_ROW_WORDS; word++) {
+            count += __builtin_popcount(game->HIDDEN_PLANE[y][word]);
+        }
+    }
+    return count;
+}
+
+static bool compileMap(Game* game, char map)
+{
+    static uint8_t source[MAP_FILE_MAX_SIZE];
+    static uint8_t compiled[MAP_FILE_MAX_SIZE];
+    static uint8_t elevators[256];
+    static uint32_t hidden[PLATFORM_MAP_HEIGHT][PLANE_ROW_WORDS];
+    PlatformHeadless platformInstance(dataPath);
+
+    game->MAPNAME[6] = map;
+    uint32_t sourceSize = platformInstance.load(game->MAPNAME, source, MAP_FILE_MAX_SIZE);
+    if (sourceSize == 0) {
+        fprintf(stderr, "Couldn't load %s/PSP/%s\n", dataPath, game->MAPNAME);
+        return false;
+    }
+
+    // Unpack as the game does for a level without the index
+    if (game->UNPACK_MAP(source, sourceSize) == MAP_INVALID) {
+        fprintf(stderr, "%s isn't a valid map\n", game->MAPNAME);
+        return false;
+    }
+    game->BUILD_UNIT_SLOTS();
+    uint64_t start = nanoseconds();
+    for (int round = 0; round != TIMING_ROUNDS; round++) {
+        game->BUILD_LEVEL_INDEX();
+    }
+    uint64_t buildTime = (nanoseconds() - start) / TIMING_ROUNDS;
+    memcpy(elevators, game->ELEVATOR_UNIT, sizeof(elevators));
+    memcpy(hidden, game->HIDDEN_PLANE, sizeof(hidden));
+    uint32_t compiledSize = packMap(game, compiled);
+
+    // Read it back the way the game will
+    memset(game->ELEVATOR_UNIT, 0, sizeof(game->ELEVATOR_UNIT));
+    memset(game->HIDDEN_PLANE, 0, sizeof(game->HIDDEN_PLANE));
+    if (game->UNPACK_MAP(compiled, compiledSize) != MAP_INDEXED || memcmp(elevators, game->ELEVATOR_UNIT, sizeof(elevators)) != 0 ||
+        memcmp(hidden, game->HIDDEN_PLANE, sizeof(hidden)) != 0) {
+        fprintf(stderr, "%s doesn't read back the same\n", game->MAPNAME);
+        return false;
+    }
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", outputPath, game->MAPNAME);
+    if (platformInstance.save(path, compiled, compiledSize) != compiledSize) {
+        fprintf(stderr, "Couldn't write %s\n", path);
+        return false;
+    }
+    int floors = 0;
+    for (int floor = 0; floor != 256; floor++) {
+        floors += game->ELEVATOR_UNIT[floor] != 255;
+    }
+    printf("%s %6lu bytes, %d elevator floors, %3d hidden tiles, index built in %.2f us\n",
+        game->MAPNAME, (unsigned long)compiledSize, floors, countBits(game), buildTime / 1000.0);
+    return true;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "Usage: %s [options]\n", name);
+    fprintf(stderr, "  -d path     data directory containing PSP/level-* (default ..)\n");
+    fprintf(stderr, "  -o path     directory to write the compiled levels to (default .)\n");
+    fprintf(stderr, "  -m maps     maps to compile, for example ABC (default A-N)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    const char* maps = "ABCDEFGHIJKLMN";
+
+    int option;
+    while ((option = getopt(argc, argv, "d:o:m:h")) != -1) {
+        switch (option) {
+        case 'd':
+            dataPath = optarg;
+            break;
+        case 'o':
+            outputPath = optarg;
+            break;
+        case 'm':
+            maps = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    PlatformHeadless platformInstance(dataPath);
+    Game* game = new Game(&platformInstance);
+    bool success = true;
+    for (const char* map = maps; *map; map++) {
+        if (*map < 'A' || *map > 'N') {
+            fprintf(stderr, "Unknown map %c\n", *map);
+            return 1;
+        }
+        success &= compileMap(game, *map);
+    }
+    delete game;
+    return success ? 0 : 1;
+}
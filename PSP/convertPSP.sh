@@ -5,3 +5,10 @@ do
   psptextureconverter "${file}" "${file%.png}.psp" 3 0 1 0
 done
 
+# The tile sheets are read in 24x24 pieces, which the texture cache
+# of the GE handles better when the pixels are swizzled
+for file in tiles sprites animtiles
+do
+  ../Tiletool/Tiletool -s "${file}.psp" "${file}.psp"
+done
+
@@ -1,5 +1,6 @@
 #include <cmath>
 #include <algorithm>
+#include <cstring>
 #include "PT2.3A_replay_cia.h"
 
 /**************************************************
@@ -1650,4 +1651,221 @@ uint8_t mt_PattDelTime2 = 0;
 bool mt_Enable = false;
 uint16_t mt_PatternPos = 0;
 ChanInput mt_chaninputs[4];
+
+// ---- Save state ----
+
+// Pointers into sample data are stored as the sample number and an offset
+// into it, anything else relative to the start of the song data
+static uint32_t mt_PointerToOffset(int8_t* pointer)
+{
+    if (!pointer) {
+        return 0;
+    }
+    for (int sample = 0; sample < 31; sample++) {
+        int8_t* sampleStart = mt_SampleStarts[sample];
+        uint32_t sampleLength = getWord(mt_SongDataPtr, 20 + sample * 30 + 22) * 2;
+        if (sampleStart && pointer >= sampleStart && pointer <= sampleStart + sampleLength) {
+            return ((sample + 1) << 24) | (uint32_t)(pointer - sampleStart);
+        }
+    }
+    return 0xff000000 | (uint32_t)(pointer - (int8_t*)mt_SongDataPtr);
+}
+
+static int8_t* mt_OffsetToPointer(uint32_t offset)
+{
+    uint8_t sample = offset >> 24;
+    if (sample == 0) {
+        return 0;
+    } else if (sample == 0xff) {
+        return (int8_t*)mt_SongDataPtr + (offset & 0xffffff);
+    }
+    return mt_SampleStarts[sample - 1] + (offset & 0xffffff);
+}
+
+static uint32_t mt_FloatToLong(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float mt_LongToFloat(uint32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static uint8_t* mt_SaveChannel(uint8_t* state, AudioChannel& channel)
+{
+    putLong(state, 0, mt_PointerToOffset(channel.data));
+    putWord(state, 4, channel.length);
+    putWord(state, 6, channel.period);
+    putWord(state, 8, channel.volume);
+    putLong(state, 10, mt_PointerToOffset(channel.dmaStart));
+    putLong(state, 14, mt_FloatToLong(channel.dmaCurrent));
+    putLong(state, 18, mt_FloatToLong(channel.dmaEnd));
+    state[22] = channel.dmacon ? 1 : 0;
+    return state + 23;
+}
+
+static uint8_t* mt_RestoreChannel(uint8_t* state, AudioChannel& channel)
+{
+    channel.data = mt_OffsetToPointer(getLong(state, 0));
+    channel.length = getWord(state, 4);
+    channel.period = getWord(state, 6);
+    channel.volume = getWord(state, 8);
+    channel.dmaStart = mt_OffsetToPointer(getLong(state, 10));
+    channel.dmaCurrent = mt_LongToFloat(getLong(state, 14));
+    channel.dmaEnd = mt_LongToFloat(getLong(state, 18));
+    channel.dmacon = state[22] != 0;
+    return state + 23;
+}
+
+static uint8_t* mt_SaveChanTemp(uint8_t* state, ChanTemp& mt_chantemp)
+{
+    putWord(state, 0, mt_chantemp.n_note);
+    putWord(state, 2, mt_chantemp.n_cmd.word);
+    putLong(state, 4, mt_PointerToOffset(mt_chantemp.n_start));
+    putWord(state, 8, mt_chantemp.n_length);
+    putLong(state, 10, mt_PointerToOffset(mt_chantemp.n_loopstart));
+    putWord(state, 14, mt_chantemp.n_replen);
+    putWord(state, 16, mt_chantemp.n_period);
+    state[18] = mt_chantemp.n_finetune;
+    state[19] = mt_chantemp.n_volume;
+    putWord(state, 20, mt_chantemp.n_dmabit);
+    state[22] = mt_chantemp.n_toneportdirec;
+    state[23] = mt_chantemp.n_toneportspeed;
+    putWord(state, 24, mt_chantemp.n_wantedperiod);
+    state[26] = mt_chantemp.n_vibratocmd;
+    state[27] = mt_chantemp.n_vibratopos;
+    state[28] = mt_chantemp.n_tremolocmd;
+    state[29] = mt_chantemp.n_tremolopos;
+    state[30] = mt_chantemp.n_wavecontrol;
+    state[31] = mt_chantemp.n_glissfunk;
+    state[32] = mt_chantemp.n_sampleoffset;
+    state[33] = mt_chantemp.n_pattpos;
+    state[34] = mt_chantemp.n_loopcount;
+    state[35] = mt_chantemp.n_funkoffset;
+    putLong(state, 36, mt_PointerToOffset(mt_chantemp.n_wavestart));
+    return state + 40;
+}
+
+static uint8_t* mt_RestoreChanTemp(uint8_t* state, ChanTemp& mt_chantemp)
+{
+    mt_chantemp.n_note = getWord(state, 0);
+    mt_chantemp.n_cmd.word = getWord(state, 2);
+    mt_chantemp.n_start = mt_OffsetToPointer(getLong(state, 4));
+    mt_chantemp.n_length = getWord(state, 8);
+    mt_chantemp.n_loopstart = mt_OffsetToPointer(getLong(state, 10));
+    mt_chantemp.n_replen = getWord(state, 14);
+    mt_chantemp.n_period = getWord(state, 16);
+    mt_chantemp.n_finetune = state[18];
+    mt_chantemp.n_volume = state[19];
+    mt_chantemp.n_dmabit = getWord(state, 20);
+    mt_chantemp.n_toneportdirec = state[22];
+    mt_chantemp.n_toneportspeed = state[23];
+    mt_chantemp.n_wantedperiod = getWord(state, 24);
+    mt_chantemp.n_vibratocmd = state[26];
+    mt_chantemp.n_vibratopos = state[27];
+    mt_chantemp.n_tremolocmd = state[28];
+    mt_chantemp.n_tremolopos = state[29];
+    mt_chantemp.n_wavecontrol = state[30];
+    mt_chantemp.n_glissfunk = state[31];
+    mt_chantemp.n_sampleoffset = state[32];
+    mt_chantemp.n_pattpos = state[33];
+    mt_chantemp.n_loopcount = state[34];
+    mt_chantemp.n_funkoffset = state[35];
+    mt_chantemp.n_wavestart = mt_OffsetToPointer(getLong(state, 36));
+    return state + 40;
+}
+
+uint32_t mt_save(uint8_t* state)
+{
+    uint8_t* position = state;
+    position[0] = ciaapra ? 1 : 0;
+    putLong(position, 1, mt_FloatToLong(ciatar));
+    putLong(position, 5, mt_FloatToLong(ciataw));
+    putWord(position, 9, RealTempo);
+    putLong(position, 11, TimerValue);
+    position[15] = mt_speed;
+    position[16] = mt_counter;
+    position[17] = mt_SongPos;
+    position[18] = mt_PBreakPos;
+    position[19] = mt_PosJumpFlag;
+    position[20] = mt_PBreakFlag;
+    position[21] = mt_LowMask;
+    position[22] = mt_PattDelTime;
+    position[23] = mt_PattDelTime2;
+    position[24] = mt_Enable ? 1 : 0;
+    putWord(position, 25, mt_PatternPos);
+    for (int i = 0; i < 4; i++) {
+        putWord(position, 27 + i * 4, mt_chaninputs[i].note);
+        putWord(position, 29 + i * 4, mt_chaninputs[i].cmd);
+    }
+    position += 43;
+    position = mt_SaveChanTemp(position, mt_chan1temp);
+    position = mt_SaveChanTemp(position, mt_chan2temp);
+    position = mt_SaveChanTemp(position, mt_chan3temp);
+    position = mt_SaveChanTemp(position, mt_chan4temp);
+    position = mt_SaveChanTemp(position, mt_chan5temp);
+    position = mt_SaveChanTemp(position, mt_chan6temp);
+    position = mt_SaveChanTemp(position, mt_chan7temp);
+    position = mt_SaveChanTemp(position, mt_chan8temp);
+    position = mt_SaveChannel(position, channel0);
+    position = mt_SaveChannel(position, channel1);
+    position = mt_SaveChannel(position, channel2);
+    position = mt_SaveChannel(position, channel3);
+    position = mt_SaveChannel(position, channel4);
+    position = mt_SaveChannel(position, channel5);
+    position = mt_SaveChannel(position, channel6);
+    position = mt_SaveChannel(position, channel7);
+    return position - state;
+}
+
+void mt_restore(uint8_t* state)
+{
+    // Keep the interrupt from running on a half restored state
+    mt_Enable = false;
+
+    uint8_t* position = state + 43;
+    position = mt_RestoreChanTemp(position, mt_chan1temp);
+    position = mt_RestoreChanTemp(position, mt_chan2temp);
+    position = mt_RestoreChanTemp(position, mt_chan3temp);
+    position = mt_RestoreChanTemp(position, mt_chan4temp);
+    position = mt_RestoreChanTemp(position, mt_chan5temp);
+    position = mt_RestoreChanTemp(position, mt_chan6temp);
+    position = mt_RestoreChanTemp(position, mt_chan7temp);
+    position = mt_RestoreChanTemp(position, mt_chan8temp);
+    position = mt_RestoreChannel(position, channel0);
+    position = mt_RestoreChannel(position, channel1);
+    position = mt_RestoreChannel(position, channel2);
+    position = mt_RestoreChannel(position, channel3);
+    position = mt_RestoreChannel(position, channel4);
+    position = mt_RestoreChannel(position, channel5);
+    position = mt_RestoreChannel(position, channel6);
+    position = mt_RestoreChannel(position, channel7);
+
+    position = state;
+    ciaapra = position[0] != 0;
+    ciatar = mt_LongToFloat(getLong(position, 1));
+    ciataw = mt_LongToFloat(getLong(position, 5));
+    RealTempo = getWord(position, 9);
+    TimerValue = getLong(position, 11);
+    mt_speed = position[15];
+    mt_counter = position[16];
+    mt_SongPos = position[17];
+    mt_PBreakPos = position[18];
+    mt_PosJumpFlag = position[19];
+    mt_PBreakFlag = position[20];
+    mt_LowMask = position[21];
+    mt_PattDelTime = position[22];
+    mt_PattDelTime2 = position[23];
+    mt_PatternPos = getWord(position, 25);
+    for (int i = 0; i < 4; i++) {
+        mt_chaninputs[i].note = getWord(position, 27 + i * 4);
+        mt_chaninputs[i].cmd = getWord(position, 29 + i * 4);
+    }
+    mt_Enable = position[24] != 0;
+}
 /* End of File */
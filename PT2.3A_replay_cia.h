@@ -68,6 +68,8 @@ struct ChanInput {
     uint16_t cmd;
 };
 
+#define MT_STATE_SIZE (43 + 8 * 40 + 8 * 23)
+
 void putLong(uint8_t* array, uint32_t offset, uint32_t value);
 void putWord(uint8_t* array, uint32_t offset, uint32_t value);
 uint32_t getLong(uint8_t* array, uint32_t offset);
@@ -84,6 +86,8 @@ extern AudioChannel channel7;
 extern void processAudio(int16_t* outputBuffer, uint32_t outputLength, uint32_t sampleRate);
 
 extern void mt_init(uint8_t* songData);
+extern uint32_t mt_save(uint8_t* state);
+extern void mt_restore(uint8_t* state);
 extern void mt_music();
 extern void mt_end();
 extern void mt_start();
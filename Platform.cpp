@@ -13,6 +13,19 @@ void Platform::show()
 {
 }
 
+uint32_t Platform::microseconds()
+{
+    return 0;
+}
+
+void Platform::startProfile(uint8_t)
+{
+}
+
+void Platform::stopProfile(uint8_t)
+{
+}
+
 void Platform::chrout(uint8_t)
 {
 }
@@ -31,6 +44,20 @@ uint16_t Platform::readJoystick(bool)
     return 0;
 }
 
+void Platform::prefetch(const char*, uint8_t*, uint32_t, Module)
+{
+}
+
+uint32_t Platform::finishPrefetch(const char*)
+{
+    return 0;
+}
+
+uint32_t Platform::save(const char*, uint8_t*, uint32_t)
+{
+    return 0;
+}
+
 void Platform::displayImage(Image)
 {
 }
@@ -43,6 +70,26 @@ void Platform::renderTiles(uint8_t, uint8_t, uint16_t, uint16_t, uint8_t, uint8_
 {
 }
 
+// Returns how many background pages of the given size in pixels can be
+// kept. Between beginPage and endPage tiles are rendered into a page
+// instead of the screen.
+uint8_t Platform::backgroundPages(uint16_t, uint16_t)
+{
+    return 0;
+}
+
+void Platform::beginPage(uint8_t)
+{
+}
+
+void Platform::endPage(uint8_t)
+{
+}
+
+void Platform::renderPage(uint8_t, uint16_t, uint16_t, uint16_t, uint16_t, uint16_t, uint16_t)
+{
+}
+
 void Platform::renderItem(uint8_t, uint16_t, uint16_t)
 {
 }
@@ -67,7 +114,7 @@ void Platform::renderLiveMapTile(uint8_t*, uint8_t, uint8_t)
 {
 }
 
-void Platform::renderLiveMapUnits(uint8_t*, uint8_t*, uint8_t*, uint8_t*, uint8_t, bool)
+void Platform::renderLiveMapUnits(uint8_t*, uint8_t*, uint8_t*, uint8_t*, uint8_t, uint8_t, uint8_t, bool)
 {
 }
 
@@ -143,6 +190,16 @@ void Platform::stopSample()
 {
 }
 
+uint32_t Platform::saveAudioState(uint8_t*)
+{
+    return 0;
+}
+
+bool Platform::restoreAudioState(uint8_t*, uint32_t)
+{
+    return false;
+}
+
 void Platform::renderFrame(bool)
 {
 }
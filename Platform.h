@@ -92,9 +92,12 @@ public:
     };
 
     virtual uint8_t* standardControls() const = 0;
-    virtual void setInterrupt(void (*interrupt)(void)) = 0;
+    virtual void setInterrupt(void (*interrupt)(void* context), void* context) = 0;
     virtual void show();
     virtual int framesPerSecond() = 0;
+    virtual uint32_t microseconds();
+    virtual void startProfile(uint8_t routine);
+    virtual void stopProfile(uint8_t routine);
     virtual void chrout(uint8_t);
     virtual uint8_t readKeyboard() = 0;
     virtual void keyRepeat();
@@ -102,19 +105,26 @@ public:
     virtual bool isKeyOrJoystickPressed(bool gamepad);
     virtual uint16_t readJoystick(bool gamepad);
     virtual uint32_t load(const char* filename, uint8_t* destination, uint32_t size, uint32_t offset = 0) = 0;
+    virtual void prefetch(const char* filename, uint8_t* destination, uint32_t size, Module module);
+    virtual uint32_t finishPrefetch(const char* filename);
+    virtual uint32_t save(const char* filename, uint8_t* source, uint32_t size);
     virtual uint8_t* loadTileset(const char* filename) = 0;
     virtual void displayImage(Image image);
     virtual void generateTiles(uint8_t* tileData, uint8_t* tileAttributes) = 0;
     virtual void updateTiles(uint8_t* tileData, uint8_t* tiles, uint8_t numTiles);
     virtual void renderTile(uint8_t tile, uint16_t x, uint16_t y, uint8_t variant = 0, bool transparent = false) = 0;
     virtual void renderTiles(uint8_t backgroundTile, uint8_t foregroundTile, uint16_t x, uint16_t y, uint8_t backgroundVariant = 0, uint8_t foregroundVariant = 0);
+    virtual uint8_t backgroundPages(uint16_t width, uint16_t height);
+    virtual void beginPage(uint8_t page);
+    virtual void endPage(uint8_t page);
+    virtual void renderPage(uint8_t page, uint16_t sourceX, uint16_t sourceY, uint16_t x, uint16_t y, uint16_t width, uint16_t height);
     virtual void renderItem(uint8_t item, uint16_t x, uint16_t y);
     virtual void renderKey(uint8_t key, uint16_t x, uint16_t y);
     virtual void renderHealth(uint8_t health, uint16_t x, uint16_t y);
     virtual void renderFace(uint8_t face, uint16_t x, uint16_t y);
     virtual void renderLiveMap(uint8_t* map);
     virtual void renderLiveMapTile(uint8_t* map, uint8_t x, uint8_t y);
-    virtual void renderLiveMapUnits(uint8_t* map, uint8_t* unitTypes, uint8_t* unitX, uint8_t* unitY, uint8_t playerColor, bool showRobots);
+    virtual void renderLiveMapUnits(uint8_t* map, uint8_t* unitTypes, uint8_t* unitX, uint8_t* unitY, uint8_t robotCount, uint8_t unitCount, uint8_t playerColor, bool showRobots);
     virtual void showCursor(uint16_t x, uint16_t y);
     virtual void hideCursor();
     virtual void setCursorShape(CursorShape shape);
@@ -137,6 +147,8 @@ public:
     virtual void stopModule();
     virtual void playSample(uint8_t sample);
     virtual void stopSample();
+    virtual uint32_t saveAudioState(uint8_t* destination);
+    virtual bool restoreAudioState(uint8_t* source, uint32_t size);
     virtual void renderFrame(bool waitForNextFrame = false);
     virtual void waitForScreenMemoryAccess();
     bool quit;
@@ -0,0 +1,757 @@
+#include <cstdio>
+#include <cstring>
+#include "PlatformCapture.h"
+
+// A capture starts with a header of the magic PRC, the version, the
+// screen size and the letter of the first level loaded, or 0 if none
+// was, followed by the commands. A command is its number and
+// its arguments, little endian, laid out as in the table below, with b
+// for a byte and w for a 16-bit word. The live map is followed by its
+// 128x64 tiles and the live map units by the types, then the x and then
+// the y coordinates of the units.
+#define CAPTURE_VERSION 2
+#define MAX_ARGUMENTS 7
+#define LIVE_MAP_SIZE (128 * 64)
+
+struct CommandLayout {
+    const char* name;
+    const char* arguments;
+};
+
+static const CommandLayout commandLayouts[PlatformCapture::CommandCount] = {
+    { "renderFrame", "b" },
+    { "displayImage", "b" },
+    { "renderTile", "bwwbb" },
+    { "renderTiles", "bbwwbb" },
+    { "backgroundPages", "ww" },
+    { "beginPage", "b" },
+    { "endPage", "b" },
+    { "renderPage", "bwwwwww" },
+    { "renderItem", "bww" },
+    { "renderKey", "bww" },
+    { "renderHealth", "bww" },
+    { "renderFace", "bww" },
+    { "renderLiveMap", "" },
+    { "liveMapCell", "bbb" },
+    { "renderLiveMapTile", "bb" },
+    { "renderLiveMapUnits", "bbbb" },
+    { "showCursor", "ww" },
+    { "hideCursor", "" },
+    { "setCursorShape", "b" },
+    { "copyRect", "wwwwww" },
+    { "clearRect", "wwww" },
+    { "fillRect", "wwwwb" },
+    { "startShakeScreen", "" },
+    { "shakeScreen", "" },
+    { "stopShakeScreen", "" },
+    { "startFadeScreen", "ww" },
+    { "fadeScreen", "wb" },
+    { "stopFadeScreen", "" },
+    { "writeToScreenMemory", "wb" },
+    { "writeToScreenMemoryColor", "wbbb" }
+};
+
+static uint32_t payloadSize(uint8_t command, const uint32_t* arguments)
+{
+    switch (command) {
+    case PlatformCapture::CommandLiveMap:
+        return LIVE_MAP_SIZE;
+    case PlatformCapture::CommandLiveMapUnits:
+        return arguments[1] * 3;
+    default:
+        return 0;
+    }
+}
+
+PlatformCapture::PlatformCapture(Platform* platform, uint32_t capacity) :
+    platform(platform),
+    buffer(new uint8_t[capacity]),
+    capacity(capacity),
+    size_(CAPTURE_HEADER_SIZE),
+    frameEnd(CAPTURE_HEADER_SIZE),
+    frames_(0),
+    full(false)
+{
+    buffer[0] = 'P';
+    buffer[1] = 'R';
+    buffer[2] = 'C';
+    buffer[3] = CAPTURE_VERSION;
+    buffer[4] = PLATFORM_SCREEN_WIDTH & 0xff;
+    buffer[5] = PLATFORM_SCREEN_WIDTH >> 8;
+    buffer[6] = PLATFORM_SCREEN_HEIGHT & 0xff;
+    buffer[7] = PLATFORM_SCREEN_HEIGHT >> 8;
+    buffer[8] = 0;
+    memset(liveMap, 0, sizeof(liveMap));
+}
+
+PlatformCapture::~PlatformCapture()
+{
+    delete[] buffer;
+}
+
+void PlatformCapture::record(Command command, const uint32_t* arguments, const uint8_t* payload)
+{
+    if (full || quit) {
+        return;
+    }
+
+    const char* layout = commandLayouts[command].arguments;
+    uint32_t length = 1;
+    for (const char* argument = layout; *argument; argument++) {
+        length += *argument == 'w' ? 2 : 1;
+    }
+    uint32_t extra = arguments ? payloadSize(command, arguments) : 0;
+    if (size_ + length + extra > capacity) {
+        // Drop the frame that doesn't fit so that the capture ends on a whole one
+        full = true;
+        size_ = frameEnd;
+        return;
+    }
+
+    uint8_t* position = buffer + size_;
+    *position++ = command;
+    for (int i = 0; layout[i]; i++) {
+        *position++ = arguments[i] & 0xff;
+        if (layout[i] == 'w') {
+            *position++ = (arguments[i] >> 8) & 0xff;
+        }
+    }
+    if (extra) {
+        memcpy(position, payload, extra);
+    }
+    size_ += length + extra;
+
+    if (command == CommandFrame) {
+        frameEnd = size_;
+        if (arguments[0]) {
+            frames_++;
+        }
+    }
+}
+
+// Records the live map tiles that have changed since they were last
+// recorded
+void PlatformCapture::recordLiveMapChanges(uint8_t* map)
+{
+    for (int i = 0; i < LIVE_MAP_SIZE; i++) {
+        if (map[i] != liveMap[i]) {
+            liveMap[i] = map[i];
+            uint32_t arguments[] = { (uint32_t)(i & 127), (uint32_t)(i >> 7), map[i] };
+            record(CommandLiveMapCell, arguments);
+        }
+    }
+}
+
+// Keeps the letter of the first level loaded in the header
+void PlatformCapture::recordLevel(const char* filename)
+{
+    if (buffer[8] == 0 && filename && strncmp(filename, "level-", 6) == 0 && filename[6] != 0) {
+        char letter = filename[6];
+        buffer[8] = letter >= 'a' && letter <= 'z' ? letter - 'a' + 'A' : letter;
+    }
+}
+
+const uint8_t* PlatformCapture::data() const
+{
+    return buffer;
+}
+
+uint32_t PlatformCapture::size() const
+{
+    return size_;
+}
+
+// The frames recorded that waited for the next frame, which are the ticks
+uint32_t PlatformCapture::frames() const
+{
+    return frames_;
+}
+
+bool PlatformCapture::isFull() const
+{
+    return full;
+}
+
+// Saves the capture with the platform it records
+bool PlatformCapture::writeCapture(const char* filename)
+{
+    return platform->save(filename, buffer, size_) == size_;
+}
+
+bool PlatformCapture::isValid(const uint8_t* data, uint32_t size)
+{
+    return size >= CAPTURE_HEADER_SIZE &&
+        data[0] == 'P' && data[1] == 'R' && data[2] == 'C' && data[3] == CAPTURE_VERSION &&
+        (data[4] | (data[5] << 8)) == PLATFORM_SCREEN_WIDTH &&
+        (data[6] | (data[7] << 8)) == PLATFORM_SCREEN_HEIGHT;
+}
+
+// The letter of the first level loaded while recording, or 0 if none was
+char PlatformCapture::level(const uint8_t* data)
+{
+    return data[8];
+}
+
+// Decodes the command at the offset, returning the offset of the next
+// one, or 0 if the command is unknown or cut short
+uint32_t PlatformCapture::decode(const uint8_t* data, uint32_t size, uint32_t offset, uint8_t& command, uint32_t* arguments, const uint8_t*& payload)
+{
+    if (offset >= size || data[offset] >= CommandCount) {
+        return 0;
+    }
+    command = data[offset++];
+
+    const char* layout = commandLayouts[command].arguments;
+    for (int i = 0; layout[i]; i++) {
+        uint32_t length = layout[i] == 'w' ? 2 : 1;
+        if (offset + length > size) {
+            return 0;
+        }
+        arguments[i] = length == 2 ? data[offset] | (data[offset + 1] << 8) : data[offset];
+        offset += length;
+    }
+
+    uint32_t extra = payloadSize(command, arguments);
+    if (offset + extra > size) {
+        return 0;
+    }
+    payload = data + offset;
+    return offset + extra;
+}
+
+// Replays a capture on the platform, returning the frames replayed that
+// waited for the next frame. It stops early at the first command that
+// can't be decoded or when the platform quits.
+uint32_t PlatformCapture::replay(Platform* platform, const uint8_t* data, uint32_t size)
+{
+    if (!isValid(data, size)) {
+        return 0;
+    }
+
+    uint8_t* map = new uint8_t[LIVE_MAP_SIZE];
+    uint8_t* unitTypes = new uint8_t[3 * 256];
+    uint8_t* unitX = unitTypes + 256;
+    uint8_t* unitY = unitTypes + 512;
+    memset(map, 0, LIVE_MAP_SIZE);
+    memset(unitTypes, 0, 3 * 256);
+
+    uint32_t frames = 0;
+    uint32_t offset = CAPTURE_HEADER_SIZE;
+    while (offset < size && !platform->quit) {
+        uint8_t command;
+        uint32_t a[MAX_ARGUMENTS];
+        const uint8_t* payload;
+        offset = decode(data, size, offset, command, a, payload);
+        if (offset == 0) {
+            break;
+        }
+
+        switch (command) {
+        case CommandFrame:
+            platform->renderFrame(a[0] != 0);
+            frames += a[0] != 0 ? 1 : 0;
+            break;
+        case CommandDisplayImage:
+            platform->displayImage((Image)a[0]);
+            break;
+        case CommandRenderTile:
+            platform->renderTile(a[0], a[1], a[2], a[3], a[4] != 0);
+            break;
+        case CommandRenderTiles:
+            platform->renderTiles(a[0], a[1], a[2], a[3], a[4], a[5]);
+            break;
+        case CommandBackgroundPages:
+            platform->backgroundPages(a[0], a[1]);
+            break;
+        case CommandBeginPage:
+            platform->beginPage(a[0]);
+            break;
+        case CommandEndPage:
+            platform->endPage(a[0]);
+            break;
+        case CommandRenderPage:
+            platform->renderPage(a[0], a[1], a[2], a[3], a[4], a[5], a[6]);
+            break;
+        case CommandRenderItem:
+            platform->renderItem(a[0], a[1], a[2]);
+            break;
+        case CommandRenderKey:
+            platform->renderKey(a[0], a[1], a[2]);
+            break;
+        case CommandRenderHealth:
+            platform->renderHealth(a[0], a[1], a[2]);
+            break;
+        case CommandRenderFace:
+            platform->renderFace(a[0], a[1], a[2]);
+            break;
+        case CommandLiveMap:
+            memcpy(map, payload, LIVE_MAP_SIZE);
+            platform->renderLiveMap(map);
+            break;
+        case CommandLiveMapCell:
+            map[(a[1] << 7) + a[0]] = a[2];
+            break;
+        case CommandLiveMapTile:
+            platform->renderLiveMapTile(map, a[0], a[1]);
+            break;
+        case CommandLiveMapUnits:
+            memcpy(unitTypes, payload, a[1]);
+            memcpy(unitX, payload + a[1], a[1]);
+            memcpy(unitY, payload + 2 * a[1], a[1]);
+            platform->renderLiveMapUnits(map, unitTypes, unitX, unitY, a[0], a[1], a[2], a[3] != 0);
+            break;
+        case CommandShowCursor:
+            platform->showCursor(a[0], a[1]);
+            break;
+        case CommandHideCursor:
+            platform->hideCursor();
+            break;
+        case CommandSetCursorShape:
+            platform->setCursorShape((CursorShape)a[0]);
+            break;
+        case CommandCopyRect:
+            platform->copyRect(a[0], a[1], a[2], a[3], a[4], a[5]);
+            break;
+        case CommandClearRect:
+            platform->clearRect(a[0], a[1], a[2], a[3]);
+            break;
+        case CommandFillRect:
+            platform->fillRect(a[0], a[1], a[2], a[3], a[4]);
+            break;
+        case CommandStartShakeScreen:
+            platform->startShakeScreen();
+            break;
+        case CommandShakeScreen:
+            platform->shakeScreen();
+            break;
+        case CommandStopShakeScreen:
+            platform->stopShakeScreen();
+            break;
+        case CommandStartFadeScreen:
+            platform->startFadeScreen(a[0], a[1]);
+            break;
+        case CommandFadeScreen:
+            platform->fadeScreen(a[0], a[1] != 0);
+            break;
+        case CommandStopFadeScreen:
+            platform->stopFadeScreen();
+            break;
+        case CommandWriteToScreenMemory:
+            platform->writeToScreenMemory(a[0], a[1]);
+            break;
+        case CommandWriteToScreenMemoryColor:
+            platform->writeToScreenMemory(a[0], a[1], a[2], a[3]);
+            break;
+        }
+    }
+
+    delete[] unitTypes;
+    delete[] map;
+    return frames;
+}
+
+// Describes the command at the offset as text, its name followed by its
+// arguments, so that captures can be listed and compared line by line.
+// The live map is described by a checksum of its tiles. Returns the
+// offset of the next command, or 0 if there is none.
+uint32_t PlatformCapture::describe(const uint8_t* data, uint32_t size, uint32_t offset, char* text, uint32_t textSize)
+{
+    uint8_t command;
+    uint32_t arguments[MAX_ARGUMENTS];
+    const uint8_t* payload;
+    uint32_t next = decode(data, size, offset, command, arguments, payload);
+    if (next == 0 || textSize == 0) {
+        return 0;
+    }
+
+    uint32_t length = snprintf(text, textSize, "%s", commandLayouts[command].name);
+    for (int i = 0; commandLayouts[command].arguments[i] && length < textSize; i++) {
+        length += snprintf(text + length, textSize - length, " %lu", (unsigned long)arguments[i]);
+    }
+    if (command == CommandLiveMap && length < textSize) {
+        uint32_t checksum = 0;
+        for (int i = 0; i < LIVE_MAP_SIZE; i++) {
+            checksum = checksum * 31 + payload[i];
+        }
+        snprintf(text + length, textSize - length, " %08lx", (unsigned long)checksum);
+    } else if (command == CommandLiveMapUnits) {
+        for (uint32_t i = 0; i < arguments[1] && length < textSize; i++) {
+            length += snprintf(text + length, textSize - length, " %d:%d,%d", payload[i], payload[arguments[1] + i], payload[2 * arguments[1] + i]);
+        }
+    }
+    return next;
+}
+
+uint8_t* PlatformCapture::standardControls() const
+{
+    return platform->standardControls();
+}
+
+void PlatformCapture::setInterrupt(void (*interrupt)(void* context), void* context)
+{
+    platform->setInterrupt(interrupt, context);
+}
+
+void PlatformCapture::show()
+{
+    platform->show();
+}
+
+int PlatformCapture::framesPerSecond()
+{
+    return platform->framesPerSecond();
+}
+
+uint32_t PlatformCapture::microseconds()
+{
+    return platform->microseconds();
+}
+
+void PlatformCapture::startProfile(uint8_t routine)
+{
+    platform->startProfile(routine);
+}
+
+void PlatformCapture::stopProfile(uint8_t routine)
+{
+    platform->stopProfile(routine);
+}
+
+void PlatformCapture::chrout(uint8_t character)
+{
+    platform->chrout(character);
+}
+
+uint8_t PlatformCapture::readKeyboard()
+{
+    uint8_t key = platform->readKeyboard();
+    quit = platform->quit;
+    return key;
+}
+
+void PlatformCapture::keyRepeat()
+{
+    platform->keyRepeat();
+}
+
+void PlatformCapture::clearKeyBuffer()
+{
+    platform->clearKeyBuffer();
+}
+
+bool PlatformCapture::isKeyOrJoystickPressed(bool gamepad)
+{
+    bool pressed = platform->isKeyOrJoystickPressed(gamepad);
+    quit = platform->quit;
+    return pressed;
+}
+
+uint16_t PlatformCapture::readJoystick(bool gamepad)
+{
+    uint16_t state = platform->readJoystick(gamepad);
+    quit = platform->quit;
+    return state;
+}
+
+uint32_t PlatformCapture::load(const char* filename, uint8_t* destination, uint32_t size, uint32_t offset)
+{
+    recordLevel(filename);
+    return platform->load(filename, destination, size, offset);
+}
+
+void PlatformCapture::prefetch(const char* filename, uint8_t* destination, uint32_t size, Module module)
+{
+    recordLevel(filename);
+    platform->prefetch(filename, destination, size, module);
+}
+
+uint32_t PlatformCapture::finishPrefetch(const char* filename)
+{
+    return platform->finishPrefetch(filename);
+}
+
+uint32_t PlatformCapture::save(const char* filename, uint8_t* source, uint32_t size)
+{
+    return platform->save(filename, source, size);
+}
+
+uint8_t* PlatformCapture::loadTileset(const char* filename)
+{
+    return platform->loadTileset(filename);
+}
+
+void PlatformCapture::displayImage(Image image)
+{
+    uint32_t arguments[] = { image };
+    record(CommandDisplayImage, arguments);
+    platform->displayImage(image);
+}
+
+// The platforms draw the tiles from their own images, so the tile data
+// is not recorded
+void PlatformCapture::generateTiles(uint8_t* tileData, uint8_t* tileAttributes)
+{
+    platform->generateTiles(tileData, tileAttributes);
+}
+
+void PlatformCapture::updateTiles(uint8_t* tileData, uint8_t* tiles, uint8_t numTiles)
+{
+    platform->updateTiles(tileData, tiles, numTiles);
+}
+
+void PlatformCapture::renderTile(uint8_t tile, uint16_t x, uint16_t y, uint8_t variant, bool transparent)
+{
+    uint32_t arguments[] = { tile, x, y, variant, transparent };
+    record(CommandRenderTile, arguments);
+    platform->renderTile(tile, x, y, variant, transparent);
+}
+
+void PlatformCapture::renderTiles(uint8_t backgroundTile, uint8_t foregroundTile, uint16_t x, uint16_t y, uint8_t backgroundVariant, uint8_t foregroundVariant)
+{
+    uint32_t arguments[] = { backgroundTile, foregroundTile, x, y, backgroundVariant, foregroundVariant };
+    record(CommandRenderTiles, arguments);
+    platform->renderTiles(backgroundTile, foregroundTile, x, y, backgroundVariant, foregroundVariant);
+}
+
+uint8_t PlatformCapture::backgroundPages(uint16_t width, uint16_t height)
+{
+    uint32_t arguments[] = { width, height };
+    record(CommandBackgroundPages, arguments);
+    return platform->backgroundPages(width, height);
+}
+
+void PlatformCapture::beginPage(uint8_t page)
+{
+    uint32_t arguments[] = { page };
+    record(CommandBeginPage, arguments);
+    platform->beginPage(page);
+}
+
+void PlatformCapture::endPage(uint8_t page)
+{
+    uint32_t arguments[] = { page };
+    record(CommandEndPage, arguments);
+    platform->endPage(page);
+}
+
+void PlatformCapture::renderPage(uint8_t page, uint16_t sourceX, uint16_t sourceY, uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+    uint32_t arguments[] = { page, sourceX, sourceY, x, y, width, height };
+    record(CommandRenderPage, arguments);
+    platform->renderPage(page, sourceX, sourceY, x, y, width, height);
+}
+
+void PlatformCapture::renderItem(uint8_t item, uint16_t x, uint16_t y)
+{
+    uint32_t arguments[] = { item, x, y };
+    record(CommandRenderItem, arguments);
+    platform->renderItem(item, x, y);
+}
+
+void PlatformCapture::renderKey(uint8_t key, uint16_t x, uint16_t y)
+{
+    uint32_t arguments[] = { key, x, y };
+    record(CommandRenderKey, arguments);
+    platform->renderKey(key, x, y);
+}
+
+void PlatformCapture::renderHealth(uint8_t health, uint16_t x, uint16_t y)
+{
+    uint32_t arguments[] = { health, x, y };
+    record(CommandRenderHealth, arguments);
+    platform->renderHealth(health, x, y);
+}
+
+void PlatformCapture::renderFace(uint8_t face, uint16_t x, uint16_t y)
+{
+    uint32_t arguments[] = { face, x, y };
+    record(CommandRenderFace, arguments);
+    platform->renderFace(face, x, y);
+}
+
+void PlatformCapture::renderLiveMap(uint8_t* map)
+{
+    memcpy(liveMap, map, LIVE_MAP_SIZE);
+    uint32_t arguments[] = { 0 };
+    record(CommandLiveMap, arguments, map);
+    platform->renderLiveMap(map);
+}
+
+void PlatformCapture::renderLiveMapTile(uint8_t* map, uint8_t x, uint8_t y)
+{
+    recordLiveMapChanges(map);
+    uint32_t arguments[] = { x, y };
+    record(CommandLiveMapTile, arguments);
+    platform->renderLiveMapTile(map, x, y);
+}
+
+void PlatformCapture::renderLiveMapUnits(uint8_t* map, uint8_t* unitTypes, uint8_t* unitX, uint8_t* unitY, uint8_t robotCount, uint8_t unitCount, uint8_t playerColor, bool showRobots)
+{
+    recordLiveMapChanges(map);
+    uint8_t units[3 * 256];
+    memcpy(units, unitTypes, unitCount);
+    memcpy(units + unitCount, unitX, unitCount);
+    memcpy(units + 2 * unitCount, unitY, unitCount);
+    uint32_t arguments[] = { robotCount, unitCount, playerColor, showRobots };
+    record(CommandLiveMapUnits, arguments, units);
+    platform->renderLiveMapUnits(map, unitTypes, unitX, unitY, robotCount, unitCount, playerColor, showRobots);
+}
+
+void PlatformCapture::showCursor(uint16_t x, uint16_t y)
+{
+    uint32_t arguments[] = { x, y };
+    record(CommandShowCursor, arguments);
+    platform->showCursor(x, y);
+}
+
+void PlatformCapture::hideCursor()
+{
+    record(CommandHideCursor);
+    platform->hideCursor();
+}
+
+void PlatformCapture::setCursorShape(CursorShape shape)
+{
+    uint32_t arguments[] = { shape };
+    record(CommandSetCursorShape, arguments);
+    platform->setCursorShape(shape);
+}
+
+void PlatformCapture::copyRect(uint16_t sourceX, uint16_t sourceY, uint16_t destinationX, uint16_t destinationY, uint16_t width, uint16_t height)
+{
+    uint32_t arguments[] = { sourceX, sourceY, destinationX, destinationY, width, height };
+    record(CommandCopyRect, arguments);
+    platform->copyRect(sourceX, sourceY, destinationX, destinationY, width, height);
+}
+
+void PlatformCapture::clearRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+    uint32_t arguments[] = { x, y, width, height };
+    record(CommandClearRect, arguments);
+    platform->clearRect(x, y, width, height);
+}
+
+void PlatformCapture::fillRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint8_t color)
+{
+    uint32_t arguments[] = { x, y, width, height, color };
+    record(CommandFillRect, arguments);
+    platform->fillRect(x, y, width, height, color);
+}
+
+void PlatformCapture::startShakeScreen()
+{
+    record(CommandStartShakeScreen);
+    platform->startShakeScreen();
+}
+
+void PlatformCapture::shakeScreen()
+{
+    record(CommandShakeScreen);
+    platform->shakeScreen();
+}
+
+void PlatformCapture::stopShakeScreen()
+{
+    record(CommandStopShakeScreen);
+    platform->stopShakeScreen();
+}
+
+void PlatformCapture::startFadeScreen(uint16_t color, uint16_t intensity)
+{
+    uint32_t arguments[] = { color, intensity };
+    record(CommandStartFadeScreen, arguments);
+    platform->startFadeScreen(color, intensity);
+}
+
+// A fade that isn't immediate renders its frames in the platform, which
+// a replay does again
+void PlatformCapture::fadeScreen(uint16_t intensity, bool immediate)
+{
+    uint32_t arguments[] = { intensity, immediate };
+    record(CommandFadeScreen, arguments);
+    platform->fadeScreen(intensity, immediate);
+    quit = platform->quit;
+}
+
+void PlatformCapture::stopFadeScreen()
+{
+    record(CommandStopFadeScreen);
+    platform->stopFadeScreen();
+}
+
+void PlatformCapture::writeToScreenMemory(address_t address, uint8_t value)
+{
+    uint32_t arguments[] = { address, value };
+    record(CommandWriteToScreenMemory, arguments);
+    platform->writeToScreenMemory(address, value);
+}
+
+void PlatformCapture::writeToScreenMemory(address_t address, uint8_t value, uint8_t color, uint8_t yOffset)
+{
+    uint32_t arguments[] = { address, value, color, yOffset };
+    record(CommandWriteToScreenMemoryColor, arguments);
+    platform->writeToScreenMemory(address, value, color, yOffset);
+}
+
+void PlatformCapture::playNote(uint8_t note)
+{
+    platform->playNote(note);
+}
+
+void PlatformCapture::stopNote()
+{
+    platform->stopNote();
+}
+
+void PlatformCapture::loadModule(Module module)
+{
+    platform->loadModule(module);
+}
+
+void PlatformCapture::playModule(Module module)
+{
+    platform->playModule(module);
+}
+
+void PlatformCapture::pauseModule()
+{
+    platform->pauseModule();
+}
+
+void PlatformCapture::stopModule()
+{
+    platform->stopModule();
+}
+
+void PlatformCapture::playSample(uint8_t sample)
+{
+    platform->playSample(sample);
+}
+
+void PlatformCapture::stopSample()
+{
+    platform->stopSample();
+}
+
+uint32_t PlatformCapture::saveAudioState(uint8_t* destination)
+{
+    return platform->saveAudioState(destination);
+}
+
+bool PlatformCapture::restoreAudioState(uint8_t* source, uint32_t size)
+{
+    return platform->restoreAudioState(source, size);
+}
+
+void PlatformCapture::renderFrame(bool waitForNextFrame)
+{
+    uint32_t arguments[] = { waitForNextFrame };
+    record(CommandFrame, arguments);
+    platform->renderFrame(waitForNextFrame);
+    quit = platform->quit;
+}
+
+void PlatformCapture::waitForScreenMemoryAccess()
+{
+    platform->waitForScreenMemoryAccess();
+}
@@ -0,0 +1,146 @@
+#ifndef _PLATFORMCAPTURE_H
+#define _PLATFORMCAPTURE_H
+
+#include "Platform.h"
+
+#ifndef PLATFORM_CAPTURE_SIZE
+#define PLATFORM_CAPTURE_SIZE (4 * 1024 * 1024)
+#endif
+
+#define CAPTURE_HEADER_SIZE 9
+
+// Passes every call on to another platform and records the ones that
+// draw into a capture, so that the drawing can be replayed on any
+// platform without the game. Recording starts with the platform and
+// stops when it quits or the capture is full, at the last whole frame.
+// The live map is recorded with the tiles it is drawn from, so that a
+// replay gives the same picture, and the header keeps the letter of the
+// first level loaded, so that the frames can be named after it.
+class PlatformCapture : public Platform {
+public:
+    enum Command {
+        CommandFrame,
+        CommandDisplayImage,
+        CommandRenderTile,
+        CommandRenderTiles,
+        CommandBackgroundPages,
+        CommandBeginPage,
+        CommandEndPage,
+        CommandRenderPage,
+        CommandRenderItem,
+        CommandRenderKey,
+        CommandRenderHealth,
+        CommandRenderFace,
+        CommandLiveMap,
+        CommandLiveMapCell,
+        CommandLiveMapTile,
+        CommandLiveMapUnits,
+        CommandShowCursor,
+        CommandHideCursor,
+        CommandSetCursorShape,
+        CommandCopyRect,
+        CommandClearRect,
+        CommandFillRect,
+        CommandStartShakeScreen,
+        CommandShakeScreen,
+        CommandStopShakeScreen,
+        CommandStartFadeScreen,
+        CommandFadeScreen,
+        CommandStopFadeScreen,
+        CommandWriteToScreenMemory,
+        CommandWriteToScreenMemoryColor,
+        CommandCount
+    };
+
+    PlatformCapture(Platform* platform, uint32_t capacity = PLATFORM_CAPTURE_SIZE);
+    virtual ~PlatformCapture();
+
+    virtual uint8_t* standardControls() const;
+    virtual void setInterrupt(void (*interrupt)(void* context), void* context);
+    virtual void show();
+    virtual int framesPerSecond();
+    virtual uint32_t microseconds();
+    virtual void startProfile(uint8_t routine);
+    virtual void stopProfile(uint8_t routine);
+    virtual void chrout(uint8_t character);
+    virtual uint8_t readKeyboard();
+    virtual void keyRepeat();
+    virtual void clearKeyBuffer();
+    virtual bool isKeyOrJoystickPressed(bool gamepad);
+    virtual uint16_t readJoystick(bool gamepad);
+    virtual uint32_t load(const char* filename, uint8_t* destination, uint32_t size, uint32_t offset = 0);
+    virtual void prefetch(const char* filename, uint8_t* destination, uint32_t size, Module module);
+    virtual uint32_t finishPrefetch(const char* filename);
+    virtual uint32_t save(const char* filename, uint8_t* source, uint32_t size);
+    virtual uint8_t* loadTileset(const char* filename);
+    virtual void displayImage(Image image);
+    virtual void generateTiles(uint8_t* tileData, uint8_t* tileAttributes);
+    virtual void updateTiles(uint8_t* tileData, uint8_t* tiles, uint8_t numTiles);
+    virtual void renderTile(uint8_t tile, uint16_t x, uint16_t y, uint8_t variant = 0, bool transparent = false);
+    virtual void renderTiles(uint8_t backgroundTile, uint8_t foregroundTile, uint16_t x, uint16_t y, uint8_t backgroundVariant = 0, uint8_t foregroundVariant = 0);
+    virtual uint8_t backgroundPages(uint16_t width, uint16_t height);
+    virtual void beginPage(uint8_t page);
+    virtual void endPage(uint8_t page);
+    virtual void renderPage(uint8_t page, uint16_t sourceX, uint16_t sourceY, uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+    virtual void renderItem(uint8_t item, uint16_t x, uint16_t y);
+    virtual void renderKey(uint8_t key, uint16_t x, uint16_t y);
+    virtual void renderHealth(uint8_t health, uint16_t x, uint16_t y);
+    virtual void renderFace(uint8_t face, uint16_t x, uint16_t y);
+    virtual void renderLiveMap(uint8_t* map);
+    virtual void renderLiveMapTile(uint8_t* map, uint8_t x, uint8_t y);
+    virtual void renderLiveMapUnits(uint8_t* map, uint8_t* unitTypes, uint8_t* unitX, uint8_t* unitY, uint8_t robotCount, uint8_t unitCount, uint8_t playerColor, bool showRobots);
+    virtual void showCursor(uint16_t x, uint16_t y);
+    virtual void hideCursor();
+    virtual void setCursorShape(CursorShape shape);
+    virtual void copyRect(uint16_t sourceX, uint16_t sourceY, uint16_t destinationX, uint16_t destinationY, uint16_t width, uint16_t height);
+    virtual void clearRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+    virtual void fillRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint8_t color);
+    virtual void startShakeScreen();
+    virtual void shakeScreen();
+    virtual void stopShakeScreen();
+    virtual void startFadeScreen(uint16_t color, uint16_t intensity);
+    virtual void fadeScreen(uint16_t intensity, bool immediate = true);
+    virtual void stopFadeScreen();
+    virtual void writeToScreenMemory(address_t address, uint8_t value);
+    virtual void writeToScreenMemory(address_t address, uint8_t value, uint8_t color, uint8_t yOffset);
+    virtual void playNote(uint8_t note);
+    virtual void stopNote();
+    virtual void loadModule(Module module);
+    virtual void playModule(Module module);
+    virtual void pauseModule();
+    virtual void stopModule();
+    virtual void playSample(uint8_t sample);
+    virtual void stopSample();
+    virtual uint32_t saveAudioState(uint8_t* destination);
+    virtual bool restoreAudioState(uint8_t* source, uint32_t size);
+    virtual void renderFrame(bool waitForNextFrame = false);
+    virtual void waitForScreenMemoryAccess();
+
+    const uint8_t* data() const;
+    uint32_t size() const;
+    uint32_t frames() const;
+    bool isFull() const;
+    bool writeCapture(const char* filename);
+
+    static bool isValid(const uint8_t* data, uint32_t size);
+    static char level(const uint8_t* data);
+    static uint32_t replay(Platform* platform, const uint8_t* data, uint32_t size);
+    static uint32_t describe(const uint8_t* data, uint32_t size, uint32_t offset, char* text, uint32_t textSize);
+
+private:
+    void record(Command command, const uint32_t* arguments = 0, const uint8_t* payload = 0);
+    void recordLiveMapChanges(uint8_t* map);
+    void recordLevel(const char* filename);
+    static uint32_t decode(const uint8_t* data, uint32_t size, uint32_t offset, uint8_t& command, uint32_t* arguments, const uint8_t*& payload);
+
+    Platform* platform;
+    uint8_t* buffer;
+    uint32_t capacity;
+    uint32_t size_;
+    uint32_t frameEnd; // Size of the capture at the end of the last whole frame
+    uint32_t frames_;
+    bool full;
+    uint8_t liveMap[128 * 64]; // The live map tiles as recorded
+};
+
+#endif
@@ -0,0 +1,250 @@
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+#include <ctime>
+#include "PlatformHeadless.h"
+
+static uint8_t standardControls[] = {
+    0, // MOVE UP orig: 56 (8)
+    0, // MOVE DOWN orig: 50 (2)
+    0, // MOVE LEFT orig: 52 (4)
+    0, // MOVE RIGHT orig: 54 (6)
+    0, // FIRE UP
+    0, // FIRE DOWN
+    0, // FIRE LEFT
+    0, // FIRE RIGHT
+    0, // CYCLE WEAPONS
+    0, // CYCLE ITEMS
+    0, // USE ITEM
+    0, // SEARCH OBEJCT
+    0, // MOVE OBJECT
+    0, // LIVE MAP
+    0, // LIVE MAP ROBOTS
+    0, // PAUSE
+    0, // MUSIC
+    0, // CHEAT
+    0, // CURSOR UP
+    0, // CURSOR DOWN
+    0, // CURSOR LEFT
+    0, // CURSOR RIGHT
+    0, // SPACE
+    0, // RETURN
+    0, // YES
+    0 // NO
+};
+
+void debug(const char* message, ...)
+{
+    va_list argList;
+    va_start(argList, message);
+    vfprintf(stderr, message, argList);
+    va_end(argList);
+}
+
+PlatformHeadless::PlatformHeadless(const char* dataPath) :
+    dataPath(dataPath),
+    interrupt(0),
+    interruptContext(0),
+    inputHandler(0),
+    inputContext(0),
+    tickHandler(0),
+    tickContext(0),
+    ticks_(0),
+    joystickStateToReturn(0),
+    joystickState(0)
+{
+    memset(tileset, 0, sizeof(tileset));
+    memset(profileStart, 0, sizeof(profileStart));
+    memset(profileTime_, 0, sizeof(profileTime_));
+    memset(profileCalls_, 0, sizeof(profileCalls_));
+}
+
+PlatformHeadless::~PlatformHeadless()
+{
+}
+
+uint64_t PlatformHeadless::nanoseconds()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+uint8_t* PlatformHeadless::standardControls() const
+{
+    return ::standardControls;
+}
+
+void PlatformHeadless::setInterrupt(void (*interrupt)(void* context), void* context)
+{
+    this->interrupt = interrupt;
+    this->interruptContext = context;
+}
+
+int PlatformHeadless::framesPerSecond()
+{
+    return 60;
+}
+
+uint32_t PlatformHeadless::microseconds()
+{
+    return (uint32_t)(nanoseconds() / 1000);
+}
+
+void PlatformHeadless::startProfile(uint8_t routine)
+{
+    profileStart[routine] = nanoseconds();
+}
+
+void PlatformHeadless::stopProfile(uint8_t routine)
+{
+    profileTime_[routine] += nanoseconds() - profileStart[routine];
+    profileCalls_[routine]++;
+}
+
+uint8_t PlatformHeadless::readKeyboard()
+{
+    return 0xff;
+}
+
+void PlatformHeadless::keyRepeat()
+{
+    joystickStateToReturn = joystickState;
+}
+
+void PlatformHeadless::clearKeyBuffer()
+{
+    joystickStateToReturn = 0;
+}
+
+bool PlatformHeadless::isKeyOrJoystickPressed(bool gamepad)
+{
+    return joystickState != 0 && joystickState != JoystickPlay;
+}
+
+uint16_t PlatformHeadless::readJoystick(bool gamepad)
+{
+    uint16_t result = joystickStateToReturn;
+    joystickStateToReturn = 0;
+    return result;
+}
+
+uint32_t PlatformHeadless::load(const char* filename, uint8_t* destination, uint32_t size, uint32_t offset)
+{
+    // Levels are kept in the PSP directory, everything else in the data directory itself
+    static const char* directories[] = { "/PSP/", "/" };
+    for (int i = 0; i < 2; i++) {
+        char path[256];
+        snprintf(path, sizeof(path), "%s%s%s", dataPath, directories[i], filename);
+        FILE* file = fopen(path, "rb");
+        if (file) {
+            uint32_t loadedSize = 0;
+            if (fseek(file, offset, SEEK_SET) == 0) {
+                loadedSize = fread(destination, 1, size, file);
+            }
+            fclose(file);
+            return loadedSize;
+        }
+    }
+
+    return 0;
+}
+
+uint32_t PlatformHeadless::save(const char* filename, uint8_t* source, uint32_t size)
+{
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        return 0;
+    }
+    uint32_t savedSize = fwrite(source, 1, size, file);
+    fclose(file);
+    return savedSize;
+}
+
+uint8_t* PlatformHeadless::loadTileset(const char* filename)
+{
+    if (load("tileset.amiga", tileset, sizeof(tileset)) != sizeof(tileset)) {
+        debug("Couldn't load %s/tileset.amiga\n", dataPath);
+    }
+    return tileset;
+}
+
+void PlatformHeadless::generateTiles(uint8_t* tileData, uint8_t* tileAttributes)
+{
+}
+
+void PlatformHeadless::renderTile(uint8_t tile, uint16_t x, uint16_t y, uint8_t variant, bool transparent)
+{
+}
+
+// Nothing is drawn, but the game keeps track of its pages all the same
+uint8_t PlatformHeadless::backgroundPages(uint16_t width, uint16_t height)
+{
+    return PLATFORM_BACKGROUND_PAGES;
+}
+
+void PlatformHeadless::copyRect(uint16_t sourceX, uint16_t sourceY, uint16_t destinationX, uint16_t destinationY, uint16_t width, uint16_t height)
+{
+}
+
+void PlatformHeadless::clearRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+}
+
+void PlatformHeadless::writeToScreenMemory(address_t address, uint8_t value)
+{
+}
+
+void PlatformHeadless::writeToScreenMemory(address_t address, uint8_t value, uint8_t color, uint8_t yOffset)
+{
+}
+
+void PlatformHeadless::renderFrame(bool waitForNextFrame)
+{
+    if (!waitForNextFrame) {
+        return;
+    }
+
+    ticks_++;
+
+    // Same edge detection as the PSP joystick
+    uint16_t state = inputHandler ? (*inputHandler)(inputContext, ticks_) : 0;
+    if (joystickState != state) {
+        joystickStateToReturn = state != JoystickPlay ? state : 0;
+        joystickState = state;
+    }
+
+    if (interrupt) {
+        (*interrupt)(interruptContext);
+    }
+    if (tickHandler) {
+        (*tickHandler)(tickContext, ticks_);
+    }
+}
+
+void PlatformHeadless::setInputHandler(uint16_t (*inputHandler)(void* context, uint32_t tick), void* context)
+{
+    this->inputHandler = inputHandler;
+    this->inputContext = context;
+}
+
+void PlatformHeadless::setTickHandler(void (*tickHandler)(void* context, uint32_t tick), void* context)
+{
+    this->tickHandler = tickHandler;
+    this->tickContext = context;
+}
+
+uint32_t PlatformHeadless::ticks() const
+{
+    return ticks_;
+}
+
+uint64_t PlatformHeadless::profileTime(uint8_t routine) const
+{
+    return profileTime_[routine];
+}
+
+uint32_t PlatformHeadless::profileCalls(uint8_t routine) const
+{
+    return profileCalls_[routine];
+}
@@ -0,0 +1,71 @@
+#ifndef _PLATFORMHEADLESS_H
+#define _PLATFORMHEADLESS_H
+
+#define PlatformClass PlatformHeadless
+
+#include "Platform.h"
+
+#ifndef PLATFORM_BACKGROUND_PAGES
+#define PLATFORM_BACKGROUND_PAGES 4
+#endif
+
+extern void debug(const char *message, ...);
+
+// Runs the game logic without display, audio or real time.
+// Every renderFrame(true) is one tick: the joystick state is
+// taken from the input handler and the interrupt is run. There
+// can be one instance per thread, each running its own Game.
+class PlatformHeadless : public Platform {
+public:
+    PlatformHeadless(const char* dataPath = ".");
+    virtual ~PlatformHeadless();
+
+    virtual uint8_t* standardControls() const;
+    virtual void setInterrupt(void (*interrupt)(void* context), void* context);
+    virtual int framesPerSecond();
+    virtual uint32_t microseconds();
+    virtual void startProfile(uint8_t routine);
+    virtual void stopProfile(uint8_t routine);
+    virtual uint8_t readKeyboard();
+    virtual void keyRepeat();
+    virtual void clearKeyBuffer();
+    virtual bool isKeyOrJoystickPressed(bool gamepad);
+    virtual uint16_t readJoystick(bool gamepad);
+    virtual uint32_t load(const char* filename, uint8_t* destination, uint32_t size, uint32_t offset = 0);
+    virtual uint32_t save(const char* filename, uint8_t* source, uint32_t size);
+    virtual uint8_t* loadTileset(const char* filename);
+    virtual void generateTiles(uint8_t* tileData, uint8_t* tileAttributes);
+    virtual void renderTile(uint8_t tile, uint16_t x, uint16_t y, uint8_t variant = 0, bool transparent = false);
+    virtual uint8_t backgroundPages(uint16_t width, uint16_t height);
+    virtual void copyRect(uint16_t sourceX, uint16_t sourceY, uint16_t destinationX, uint16_t destinationY, uint16_t width, uint16_t height);
+    virtual void clearRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+    virtual void writeToScreenMemory(address_t address, uint8_t value);
+    virtual void writeToScreenMemory(address_t address, uint8_t value, uint8_t color, uint8_t yOffset);
+    virtual void renderFrame(bool waitForNextFrame);
+
+    void setInputHandler(uint16_t (*inputHandler)(void* context, uint32_t tick), void* context);
+    void setTickHandler(void (*tickHandler)(void* context, uint32_t tick), void* context);
+    uint32_t ticks() const;
+    uint64_t profileTime(uint8_t routine) const;
+    uint32_t profileCalls(uint8_t routine) const;
+
+private:
+    static uint64_t nanoseconds();
+
+    const char* dataPath;
+    void (*interrupt)(void* context);
+    void* interruptContext;
+    uint16_t (*inputHandler)(void* context, uint32_t tick);
+    void* inputContext;
+    void (*tickHandler)(void* context, uint32_t tick);
+    void* tickContext;
+    uint32_t ticks_;
+    uint16_t joystickStateToReturn;
+    uint16_t joystickState;
+    uint8_t tileset[2817];
+    uint64_t profileStart[256];
+    uint64_t profileTime_[256];
+    uint32_t profileCalls_[256];
+};
+
+#endif
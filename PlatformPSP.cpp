@@ -3,6 +3,7 @@
 #include <cstdlib>
 #include <ctime>
 #include <cstdarg>
+#include <cstdio>
 #include <errno.h>
 #include <fatms.h>
 #include <geman.h>
@@ -24,6 +25,7 @@ int sce_newlib_heap_kb_size = 18430;
 unsigned int sce_user_main_thread_stack_kb_size = 16;
 unsigned int sce_user_main_thread_attribute = SCE_KERNEL_TH_USE_VFPU;
 static const SceChar8 *SOUND_THREAD_NAME = "Sound";
+static const SceChar8 *PREFETCH_THREAD_NAME = "Prefetch";
 
 #define DISPLAYLIST_SIZE (409600 / sizeof(int))
 #define CACHE_SIZE 344064
@@ -37,6 +39,46 @@ static int cacheSize = 0;
 #define AUDIO_BUFFER_SIZE 256
 #define SAMPLERATE 44100
 
+// The rate of the game logic, which doesn't depend on the display. Up to
+// MAX_DUE_TICKS ticks are caught up after a slowdown, more are dropped.
+#ifndef PLATFORM_TICKS_PER_SECOND
+#define PLATFORM_TICKS_PER_SECOND 60
+#endif
+#define MAX_DUE_TICKS 6
+
+// PLATFORM_16BIT_FRAMEBUFFER draws and displays in RGB 565 instead of RGBA
+// 8888. The palette only has 12-bit colors, so nothing visible is lost
+// while the buffers take half the VRAM and copies and fills half the time.
+#ifdef PLATFORM_16BIT_FRAMEBUFFER
+#define FRAMEBUFFER_FORMAT SCEGU_PF5650
+#define DISPLAY_FORMAT SCE_DISPLAY_PIXEL_RGB565
+#define FRAMEBUFFER_0 SCEGU_VRAM_BP_0
+#define FRAMEBUFFER_1 SCEGU_VRAM_BP_1
+#define FRAMEBUFFER_2 SCEGU_VRAM_BP_2
+#define FRAMEBUFFER_PIXEL_SIZE 2
+#else
+#define FRAMEBUFFER_FORMAT SCEGU_PF8888
+#define DISPLAY_FORMAT SCE_DISPLAY_PIXEL_RGBA8888
+#define FRAMEBUFFER_0 SCEGU_VRAM_BP32_0
+#define FRAMEBUFFER_1 SCEGU_VRAM_BP32_1
+#define FRAMEBUFFER_2 SCEGU_VRAM_BP32_2
+#define FRAMEBUFFER_PIXEL_SIZE 4
+#endif
+#define FRAMEBUFFER_SIZE (SCEGU_VRAM_WIDTH * SCEGU_SCR_HEIGHT * FRAMEBUFFER_PIXEL_SIZE)
+#define VRAM_SIZE (2 * 1024 * 1024)
+
+// Set by Tiletool -s in the first word of the header of a texture whose
+// pixels are swizzled in blocks of 16 bytes by 8 rows for the GE
+#define TEXTURE_SWIZZLED 0x80000000
+// Set in the first word of the header of a texture in RGB 565 instead of RGBA 8888
+#define TEXTURE_5650 0x40000000
+
+// The background pages of the map kept in RAM. A 480x240 page takes
+// 480 KB with the 32-bit frame buffers and 240 KB with the 16-bit ones.
+#ifndef PLATFORM_BACKGROUND_PAGES
+#define PLATFORM_BACKGROUND_PAGES 4
+#endif
+
 extern uint8_t tileset[];
 extern uint32_t font[];
 extern uint32_t faces[];
@@ -126,6 +168,17 @@ extern int8_t soundShortBeepEnd[];
 
 uint32_t* images[] = { introScreen, gameScreen, gameOver };
 
+// The textures that can be copied to the VRAM left after the frame
+// buffers, in the order they are placed before any have been used.
+// The others are only drawn once and are read from RAM.
+#define RESIDENT_TEXTURES 8
+static uint32_t* residentTextures[RESIDENT_TEXTURES] = { tiles, sprites, animTiles, font, health, items, keys, faces };
+static uint8_t* texturePixels[RESIDENT_TEXTURES]; // In VRAM or RAM
+static uint32_t textureDraws[RESIDENT_TEXTURES];
+
+// Textures with a header like the others, rendered into by the GE
+static uint32_t* pages[PLATFORM_BACKGROUND_PAGES];
+
 static int8_t tileSpriteMap[256] = {
     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
@@ -276,16 +329,36 @@ uint8_t liveMapToPlane1[256];
 uint8_t liveMapToPlane2[256];
 uint8_t liveMapToPlane3[256];
 uint8_t liveMapToPlane4[256];
-uint8_t unitTypes[48];
-uint8_t unitX[48];
-uint8_t unitY[48];
+uint8_t unitTypes[256];
+uint8_t unitX[256];
+uint8_t unitY[256];
 
 PlatformPSP::PlatformPSP() :
     eDRAMAddress((uint8_t*)sceGeEdramGetAddr()),
     interrupt(0),
-    framesPerSecond_(60),
+    interruptContext(0),
+    framesPerSecond_(PLATFORM_TICKS_PER_SECOND),
+    tickAccumulator(0),
+    tickCheckTime(sceKernelGetSystemTimeLow()),
+    dueTicks(0),
+    lateTicks(0),
+    droppedTicks(0),
+    tickStatisticsTime(tickCheckTime),
     moduleData(new uint8_t[LARGEST_MODULE_SIZE]),
     loadedModule(ModuleSoundFX),
+    prefetchModuleData(new uint8_t[LARGEST_MODULE_SIZE]),
+    prefetchModule(ModuleSoundFX),
+    prefetchModulePending(false),
+    prefetchDestination(0),
+    prefetchSize(0),
+    prefetchLoadedSize(0),
+    prefetchTime(0),
+    prefetchThreadId(-1),
+    prefetchReady(false),
+    prefetchQueued(false),
+    queuedDestination(0),
+    queuedSize(0),
+    queuedModule(ModuleSoundFX),
     effectChannel(0),
     audioBuffer(new int16_t[AUDIO_BUFFER_SIZE]),
     audioOutputBuffer(new SceShort16[AUDIO_BUFFER_SIZE * 2 * 2]),
@@ -304,7 +377,22 @@ PlatformPSP::PlatformPSP() :
     fadeIntensity(0),
     drawToBuffer0(false),
     swapBuffers(false),
-    isDirty(false)
+    isDirty(false),
+    enabledStates(0),
+    boundTexture(0),
+    textureFilter(SCEGU_NEAREST),
+    textureMode(0),
+    boundColor(0xffffffff),
+    emittedStateChanges(0),
+    elidedStateChanges(0),
+    presentedFrames(0),
+    presentTime(0),
+    vramUsed(0),
+    boundTextureIndex(-1),
+    vramTexels(0),
+    ramTexels(0),
+    stateStatisticsTime(tickCheckTime),
+    pageCount(0)
 {
     // Clear the first two bytes of effect samples to enable the 2-byte no-loop loop
     *((uint16_t*)soundExplosion) = 0;
@@ -323,6 +411,9 @@ PlatformPSP::PlatformPSP() :
     *((uint16_t*)soundMenuBeep) = 0;
     *((uint16_t*)soundShortBeep) = 0;
 
+    prefetchFilename[0] = 0;
+    queuedFilename[0] = 0;
+
     // Increase thread priority
     sceKernelChangeThreadPriority(SCE_KERNEL_TH_SELF, 40);
 
@@ -347,9 +438,9 @@ PlatformPSP::PlatformPSP() :
 
     sceGuStart(SCEGU_IMMEDIATE, displayList, DISPLAYLIST_SIZE * sizeof(int));
 
-    sceGuDrawBuffer(SCEGU_PF8888, SCEGU_VRAM_BP32_2, SCEGU_VRAM_WIDTH);
-    sceGuDispBuffer(SCEGU_SCR_WIDTH, SCEGU_SCR_HEIGHT, SCEGU_VRAM_BP32_0, SCEGU_VRAM_WIDTH);
-    sceGuDepthBuffer(SCEGU_VRAM_BP32_2, SCEGU_VRAM_WIDTH);
+    sceGuDrawBuffer(FRAMEBUFFER_FORMAT, FRAMEBUFFER_2, SCEGU_VRAM_WIDTH);
+    sceGuDispBuffer(SCEGU_SCR_WIDTH, SCEGU_SCR_HEIGHT, FRAMEBUFFER_0, SCEGU_VRAM_WIDTH);
+    sceGuDepthBuffer(FRAMEBUFFER_2, SCEGU_VRAM_WIDTH);
 
     sceGuOffset(SCEGU_SCR_OFFSETX, SCEGU_SCR_OFFSETY);
     sceGuViewport(2048, 2048, SCEGU_SCR_WIDTH, SCEGU_SCR_HEIGHT);
@@ -382,6 +473,7 @@ PlatformPSP::PlatformPSP() :
     sceGuEnable(SCEGU_BLEND);
     sceGuDisable(SCEGU_FOG);
     sceGuDisable(SCEGU_LIGHTING);
+    sceGuDisable(SCEGU_DITHER);
     sceGuBlendFunc(SCEGU_ADD, SCEGU_SRC_ALPHA, SCEGU_ONE_MINUS_SRC_ALPHA, 0, 0);
     sceGuTexFunc(SCEGU_TEX_MODULATE, SCEGU_RGBA);
 
@@ -398,12 +490,22 @@ PlatformPSP::PlatformPSP() :
     sceGumMatrixMode(SCEGU_MATRIX_WORLD);
 
     sceGuDisplay(SCEGU_DISPLAY_ON);
+#ifdef PLATFORM_STATISTICS
+    debug("Frame buffers in %s use %lu KB of VRAM\n", FRAMEBUFFER_PIXEL_SIZE == 2 ? "RGB 565" : "RGBA 8888", (uint32_t)(3 * FRAMEBUFFER_SIZE / 1024));
+#endif
+
+    enabledStates = (1 << SCEGU_SCISSOR_TEST) | (1 << SCEGU_TEXTURE) | (1 << SCEGU_BLEND);
 
     sceGuFinish();
     sceGuSync(SCEGU_SYNC_FINISH, SCEGU_SYNC_WAIT);
 
     sceGuStart(SCEGU_IMMEDIATE, displayList, DISPLAYLIST_SIZE * sizeof(int));
 
+    for (int i = 0; i < RESIDENT_TEXTURES; i++) {
+        texturePixels[i] = (uint8_t*)(residentTextures[i] + 4);
+        textureDraws[i] = 0;
+    }
+
     platform = this;
 
     PlatformPSP* p = this;
@@ -421,6 +523,8 @@ PlatformPSP::~PlatformPSP()
 
     sceDisplaySetVblankCallback(0, 0, 0);
 
+    waitForPrefetch();
+
     if (audioThreadId != -1) {
         sceKernelWaitThreadEnd(audioThreadId, NULL);
     }
@@ -430,6 +534,7 @@ PlatformPSP::~PlatformPSP()
     delete[] displayList;
     delete[] audioOutputBuffer;
     delete[] audioBuffer;
+    delete[] prefetchModuleData;
     delete[] moduleData;
 
     sceKernelExitGame();
@@ -484,32 +589,269 @@ SceInt32 PlatformPSP::audioThread(SceSize args, SceVoid *argb)
     return 0;
 }
 
+int PlatformPSP::prefetchThread(SceSize args, void* argp)
+{
+    PlatformPSP* platform = *((PlatformPSP**)argp);
+    uint32_t start = sceKernelGetSystemTimeLow();
+
+    if (platform->prefetchDestination) {
+        platform->prefetchLoadedSize = platform->load(platform->prefetchFilename, platform->prefetchDestination, platform->prefetchSize);
+    }
+
+    if (platform->prefetchModulePending) {
+        uint32_t moduleSize = platform->load(moduleFilenames[platform->prefetchModule], platform->prefetchModuleData, LARGEST_MODULE_SIZE, 0);
+        platform->undeltaSamples(platform->prefetchModuleData, moduleSize);
+    }
+
+    platform->prefetchTime = sceKernelGetSystemTimeLow() - start;
+    platform->prefetchReady = true;
+
+    return 0;
+}
+
+void PlatformPSP::waitForPrefetch()
+{
+    if (prefetchThreadId >= 0) {
+#ifdef PLATFORM_STATISTICS
+        bool wasReady = prefetchReady;
+        uint32_t start = sceKernelGetSystemTimeLow();
+#endif
+        sceKernelWaitThreadEnd(prefetchThreadId, NULL);
+        sceKernelDeleteThread(prefetchThreadId);
+        prefetchThreadId = -1;
+#ifdef PLATFORM_STATISTICS
+        debug("Prefetch of %s took %lu us, %s %lu us\n", prefetchFilename[0] ? prefetchFilename : moduleFilenames[prefetchModule], prefetchTime, wasReady ? "ready, waited" : "not ready, waited", sceKernelGetSystemTimeLow() - start);
+#endif
+    }
+}
+
 void PlatformPSP::vblankHandler(int idx, void* cookie)
 {
     PlatformPSP* platform = (PlatformPSP*)cookie;
 
     if (idx == 0) {
         if (platform->swapBuffers) {
-            sceDisplaySetFrameBuf(platform->eDRAMAddress + (uint32_t)(platform->drawToBuffer0 ? SCEGU_VRAM_BP32_0 : SCEGU_VRAM_BP32_1), 512, SCE_DISPLAY_PIXEL_RGBA8888, SCE_DISPLAY_UPDATETIMING_NEXTHSYNC);
+            sceDisplaySetFrameBuf(platform->eDRAMAddress + (uint32_t)(platform->drawToBuffer0 ? FRAMEBUFFER_0 : FRAMEBUFFER_1), SCEGU_VRAM_WIDTH, DISPLAY_FORMAT, SCE_DISPLAY_UPDATETIMING_NEXTHSYNC);
             platform->drawToBuffer0 = !platform->drawToBuffer0;
             platform->swapBuffers = false;
         }
+    }
+}
+
+// Adds the ticks that have become due since the last call
+void PlatformPSP::updateTicks()
+{
+    uint32_t now = sceKernelGetSystemTimeLow();
+    uint32_t elapsed = now - tickCheckTime;
+    tickCheckTime = now;
+    if (elapsed > 1000000) {
+        // In whole seconds and the rest so that the product fits in 32 bits
+        uint32_t excess = elapsed - 1000000;
+        droppedTicks += excess / 1000000 * framesPerSecond_ + excess % 1000000 * framesPerSecond_ / 1000000;
+        elapsed = 1000000;
+    }
+    tickAccumulator += elapsed * framesPerSecond_;
+    while (tickAccumulator >= 1000000) {
+        tickAccumulator -= 1000000;
+        if (dueTicks != MAX_DUE_TICKS) {
+            dueTicks++;
+        } else {
+            droppedTicks++;
+        }
+    }
+}
 
-        if (platform->interrupt) {
-            (*platform->interrupt)();
+// Waits until the next tick is due and runs the interrupt for it in the
+// main thread. Ticks that are already due run at once, one per call.
+void PlatformPSP::runTick()
+{
+    updateTicks();
+    while (dueTicks == 0 && !quit) {
+        sceKernelDelayThread((1000000 - tickAccumulator) / framesPerSecond_ + 1);
+        updateTicks();
+    }
+    if (dueTicks > 1) {
+        lateTicks++;
+    }
+    if (dueTicks != 0) {
+        dueTicks--;
+    }
+#ifdef PLATFORM_STATISTICS
+    if (tickCheckTime - tickStatisticsTime >= 1000000) {
+        if (lateTicks != 0 || droppedTicks != 0) {
+            debug("%lu ticks late, %lu dropped\n", lateTicks, droppedTicks);
         }
+        lateTicks = 0;
+        droppedTicks = 0;
+        tickStatisticsTime = tickCheckTime;
+    }
+#endif
+
+    if (interrupt) {
+        (*interrupt)(interruptContext);
     }
 }
 
-void PlatformPSP::drawRectangle(uint32_t color, uint32_t* texture, uint16_t tx, uint16_t ty, uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+// The state setters only send a command to the GE when the state
+// differs from what was sent last. Callers ask for the state they
+// need instead of restoring it afterwards, so that runs of draws
+// with the same state send it only once.
+void PlatformPSP::setState(int state, bool enable)
 {
-    if (texture) {
-        sceGuEnable(SCEGU_TEXTURE);
-        sceGuTexImage(0, texture[2], texture[3], texture[2], texture + 4);
+    uint32_t bit = 1 << state;
+    if (((enabledStates & bit) != 0) == enable) {
+        elidedStateChanges++;
+        return;
+    }
+
+    if (enable) {
+        sceGuEnable(state);
+        enabledStates |= bit;
     } else {
-        sceGuDisable(SCEGU_TEXTURE);
+        sceGuDisable(state);
+        enabledStates &= ~bit;
+    }
+    emittedStateChanges++;
+}
+
+void PlatformPSP::setTexture(uint32_t* texture)
+{
+    if (boundTexture == texture) {
+        elidedStateChanges++;
+        return;
     }
+
+    boundTextureIndex = -1;
+    for (int i = 0; i < RESIDENT_TEXTURES; i++) {
+        if (residentTextures[i] == texture) {
+            boundTextureIndex = i;
+            break;
+        }
+    }
+    setTextureMode(texture[0] & (TEXTURE_SWIZZLED | TEXTURE_5650));
+    sceGuTexImage(0, texture[2], texture[3], texture[2], boundTextureIndex >= 0 ? texturePixels[boundTextureIndex] : (uint8_t*)(texture + 4));
+    boundTexture = texture;
+    emittedStateChanges++;
+}
+
+void PlatformPSP::setTextureMode(uint32_t mode)
+{
+    if (textureMode == mode) {
+        elidedStateChanges++;
+        return;
+    }
+
+    sceGuTexMode((mode & TEXTURE_5650) ? SCEGU_PF5650 : SCEGU_PF8888, 0, 0, (mode & TEXTURE_SWIZZLED) ? SCEGU_TEXBUF_FAST : SCEGU_TEXBUF_NORMAL);
+    textureMode = mode;
+    emittedStateChanges++;
+}
+
+// Counts a draw from the bound texture, for placing the textures
+// and for the statistics of where the texels were read from
+void PlatformPSP::countTextureFetch(uint32_t texels)
+{
+    if (boundTextureIndex >= 0) {
+        textureDraws[boundTextureIndex]++;
+        if (texturePixels[boundTextureIndex] != (uint8_t*)(residentTextures[boundTextureIndex] + 4)) {
+            vramTexels += texels;
+            return;
+        }
+    }
+    ramTexels += texels;
+}
+
+// Takes VRAM after the frame buffers, or returns 0 when there isn't enough
+uint8_t* PlatformPSP::allocateVRAM(uint32_t size)
+{
+    uint32_t offset = 3 * FRAMEBUFFER_SIZE + ((vramUsed + 15) & ~15);
+    if (offset + size > VRAM_SIZE) {
+        return 0;
+    }
+
+    vramUsed = offset + size - 3 * FRAMEBUFFER_SIZE;
+    return eDRAMAddress + offset;
+}
+
+void PlatformPSP::freeVRAM()
+{
+    vramUsed = 0;
+}
+
+// Copies the most drawn textures to VRAM, in order of use until it is
+// full. Those that don't fit are read from RAM. The counts are halved
+// each time so that the recent levels count the most.
+void PlatformPSP::placeTextures()
+{
+    uint8_t order[RESIDENT_TEXTURES];
+    for (int i = 0; i < RESIDENT_TEXTURES; i++) {
+        int j = i;
+        for (; j > 0 && textureDraws[order[j - 1]] < textureDraws[i]; j--) {
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+    }
+
+    // Wait for the GE to finish with the textures before they are moved
+    sceGuFinish();
+    sceGuSync(SCEGU_SYNC_FINISH, SCEGU_SYNC_WAIT);
+    sceGuStart(SCEGU_IMMEDIATE, displayList, DISPLAYLIST_SIZE * sizeof(int));
+    boundTexture = 0;
+
+    freeVRAM();
+    for (int i = 0; i < RESIDENT_TEXTURES; i++) {
+        uint32_t* texture = residentTextures[order[i]];
+        uint32_t size = texture[2] * texture[3] * 4;
+        uint8_t* pixels = allocateVRAM(size);
+        if (pixels) {
+            memcpy(pixels, texture + 4, size);
+        } else {
+            pixels = (uint8_t*)(texture + 4);
+        }
+        texturePixels[order[i]] = pixels;
+        textureDraws[order[i]] /= 2;
+    }
+    sceKernelDcacheWritebackAll();
+#ifdef PLATFORM_STATISTICS
+    debug("Textures take %lu KB of the %lu KB of VRAM left after the frame buffers\n", vramUsed / 1024, (uint32_t)(VRAM_SIZE - 3 * FRAMEBUFFER_SIZE) / 1024);
+#endif
+}
+
+void PlatformPSP::setTextureFilter(int filter)
+{
+    if (textureFilter == filter) {
+        elidedStateChanges++;
+        return;
+    }
+
+    sceGuTexFilter(filter, filter);
+    textureFilter = filter;
+    emittedStateChanges++;
+}
+
+void PlatformPSP::setColor(uint32_t color)
+{
+    if (boundColor == color) {
+        elidedStateChanges++;
+        return;
+    }
+
     sceGuColor(color);
+    boundColor = color;
+    emittedStateChanges++;
+}
+
+void PlatformPSP::drawRectangle(uint32_t color, uint32_t* texture, uint16_t tx, uint16_t ty, uint16_t x, uint16_t y, uint16_t width, uint16_t height, bool blend)
+{
+    if (texture) {
+        setState(SCEGU_TEXTURE, true);
+        setTexture(texture);
+        setTextureFilter(SCEGU_NEAREST);
+        countTextureFetch(width * height);
+    } else {
+        setState(SCEGU_TEXTURE, false);
+    }
+    setColor(color);
+    setState(SCEGU_BLEND, blend);
 
     int oldCacheSize = cacheSize;
     float* data = (float*)(cache + cacheSize);
@@ -609,8 +951,9 @@ uint8_t* PlatformPSP::standardControls() const
     return ::standardControls;
 }
 
-void PlatformPSP::setInterrupt(void (*interrupt)(void))
+void PlatformPSP::setInterrupt(void (*interrupt)(void* context), void* context)
 {
+    this->interruptContext = context;
     this->interrupt = interrupt;
 }
 
@@ -619,6 +962,11 @@ int PlatformPSP::framesPerSecond()
     return framesPerSecond_;
 }
 
+uint32_t PlatformPSP::microseconds()
+{
+    return sceKernelGetSystemTimeLow();
+}
+
 uint8_t PlatformPSP::readKeyboard()
 {
     return 0xff;
@@ -738,7 +1086,110 @@ uint32_t PlatformPSP::load(const char* filename, uint8_t* destination, uint32_t
         }
     }
 
-    return 0;
+    // Anything not linked into the executable is read from the memory stick
+    char path[64];
+    snprintf(path, sizeof(path), SCE_FATMS_ALIAS_NAME "/%s", filename);
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return 0;
+    }
+    uint32_t loadedSize = 0;
+    if (fseek(file, offset, SEEK_SET) == 0) {
+        loadedSize = fread(destination, 1, size, file);
+    }
+    fclose(file);
+    return loadedSize;
+}
+
+uint32_t PlatformPSP::save(const char* filename, uint8_t* source, uint32_t size)
+{
+    char path[64];
+    snprintf(path, sizeof(path), SCE_FATMS_ALIAS_NAME "/%s", filename);
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        return 0;
+    }
+    uint32_t savedSize = fwrite(source, 1, size, file);
+    fclose(file);
+    return savedSize;
+}
+
+// While a prefetch is loading, a new request replaces any queued one
+// instead of waiting, and is started once the loading has finished, so
+// that stepping through the maps on the intro screen doesn't block
+void PlatformPSP::prefetch(const char* filename, uint8_t* destination, uint32_t size, Module module)
+{
+    if (prefetchThreadId >= 0 && !prefetchReady) {
+        if (filename && destination) {
+            strncpy(queuedFilename, filename, sizeof(queuedFilename) - 1);
+            queuedFilename[sizeof(queuedFilename) - 1] = 0;
+        } else {
+            queuedFilename[0] = 0;
+            destination = 0;
+        }
+        queuedDestination = destination;
+        queuedSize = size;
+        queuedModule = module;
+        prefetchQueued = true;
+        return;
+    }
+
+    prefetchQueued = false;
+    startPrefetch(filename, destination, size, module);
+}
+
+// Starts the queued request once the previous one has finished, or
+// waits for it to finish if the data is needed now
+void PlatformPSP::startQueuedPrefetch()
+{
+    if (prefetchQueued) {
+        prefetchQueued = false;
+        startPrefetch(queuedFilename[0] ? queuedFilename : 0, queuedDestination, queuedSize, queuedModule);
+    }
+}
+
+void PlatformPSP::startPrefetch(const char* filename, uint8_t* destination, uint32_t size, Module module)
+{
+    waitForPrefetch();
+
+    if (filename && destination) {
+        strncpy(prefetchFilename, filename, sizeof(prefetchFilename) - 1);
+        prefetchFilename[sizeof(prefetchFilename) - 1] = 0;
+    } else {
+        prefetchFilename[0] = 0;
+        destination = 0;
+    }
+    prefetchDestination = destination;
+    prefetchSize = size;
+    prefetchLoadedSize = 0;
+    prefetchModule = module;
+    prefetchModulePending = module != loadedModule;
+    prefetchReady = false;
+
+    // Run below the main thread so that the loading only uses the time the main thread spends waiting for vblank
+    PlatformPSP* p = this;
+    prefetchThreadId = sceKernelCreateThread(PREFETCH_THREAD_NAME, prefetchThread, 48, 4096, 0, NULL);
+    if (prefetchThreadId < 0) {
+        debug("Couldn't create prefetch thread\n");
+        prefetchDestination = 0;
+        prefetchModulePending = false;
+        return;
+    }
+    sceKernelStartThread(prefetchThreadId, sizeof(PlatformPSP*), &p);
+}
+
+uint32_t PlatformPSP::finishPrefetch(const char* filename)
+{
+    startQueuedPrefetch();
+    waitForPrefetch();
+
+    if (prefetchDestination == 0 || strcmp(filename, prefetchFilename) != 0) {
+        return 0;
+    }
+
+    prefetchDestination = 0;
+    prefetchFilename[0] = 0;
+    return prefetchLoadedSize;
 }
 
 uint8_t* PlatformPSP::loadTileset(const char* filename)
@@ -755,10 +1206,13 @@ void PlatformPSP::displayImage(Image image)
     sceGuScissor(0, 0, PLATFORM_SCREEN_WIDTH, PLATFORM_SCREEN_HEIGHT);
 
     this->clearRect(0, 0, SCEGU_SCR_WIDTH, SCEGU_SCR_HEIGHT);
+    setState(SCEGU_SCISSOR_TEST, true);
 
     if (image == ImageGame) {
         palette = paletteGame;
 
+        placeTextures();
+
         drawRectangle(0xffffffff, images[image], 320 - 56, 0, PLATFORM_SCREEN_WIDTH - 56, 0, 56, 128);
 
         for (int y = 128; y < (PLATFORM_SCREEN_HEIGHT - 32); y += 40) {
@@ -796,6 +1250,8 @@ void PlatformPSP::generateTiles(uint8_t* tileData, uint8_t* tileAttributes)
 
 void PlatformPSP::renderTile(uint8_t tile, uint16_t x, uint16_t y, uint8_t variant, bool transparent)
 {
+    setState(SCEGU_SCISSOR_TEST, true);
+
     if (transparent) {
         if (tileSpriteMap[tile] >= 0) {
             renderSprite(tileSpriteMap[tile] + variant, x, y);
@@ -813,6 +1269,8 @@ void PlatformPSP::renderTile(uint8_t tile, uint16_t x, uint16_t y, uint8_t varia
 
 void PlatformPSP::renderTiles(uint8_t backgroundTile, uint8_t foregroundTile, uint16_t x, uint16_t y, uint8_t backgroundVariant, uint8_t foregroundVariant)
 {
+    setState(SCEGU_SCISSOR_TEST, true);
+
     if (animTileMap[backgroundTile] >= 0) {
         backgroundTile = animTileMap[backgroundTile] + backgroundVariant;
         drawRectangle(0xffffffff, animTiles, (backgroundTile >> 4) * 24, (backgroundTile & 15) * 24, x, y, 24, 24);
@@ -828,6 +1286,68 @@ void PlatformPSP::renderTiles(uint8_t backgroundTile, uint8_t foregroundTile, ui
     }
 }
 
+// Pages are rendered in the display buffer that isn't shown and copied
+// to RAM, so they can't be larger than the screen
+uint8_t PlatformPSP::backgroundPages(uint16_t width, uint16_t height)
+{
+    if (width > SCEGU_SCR_WIDTH || height > SCEGU_SCR_HEIGHT) {
+        return 0;
+    }
+
+    uint32_t textureWidth = 1;
+    while (textureWidth < width) {
+        textureWidth <<= 1;
+    }
+    uint32_t textureHeight = 1;
+    while (textureHeight < height) {
+        textureHeight <<= 1;
+    }
+    // Whole cache lines, so that the CPU never writes back over what the GE copied
+    uint32_t size = (16 + textureWidth * height * FRAMEBUFFER_PIXEL_SIZE + 63) & ~63;
+    while (pageCount < PLATFORM_BACKGROUND_PAGES) {
+        uint32_t* page = (uint32_t*)memalign(64, size);
+        if (!page) {
+            break;
+        }
+        page[0] = width | (FRAMEBUFFER_PIXEL_SIZE == 2 ? TEXTURE_5650 : 0);
+        page[1] = height;
+        page[2] = textureWidth;
+        page[3] = textureHeight;
+        sceKernelDcacheWritebackInvalidateRange(page, size);
+        pages[pageCount++] = page;
+    }
+#ifdef PLATFORM_STATISTICS
+    debug("%d background pages of %dx%d take %lu KB of RAM\n", pageCount, width, height, pageCount * size / 1024);
+#endif
+    return pageCount;
+}
+
+void PlatformPSP::beginPage(uint8_t page)
+{
+    while (swapBuffers);
+
+    sceGuDrawBuffer(FRAMEBUFFER_FORMAT, drawToBuffer0 ? FRAMEBUFFER_0 : FRAMEBUFFER_1, SCEGU_VRAM_WIDTH);
+    sceGuScissor(0, 0, pages[page][0] & 0xffff, pages[page][1]);
+}
+
+void PlatformPSP::endPage(uint8_t page)
+{
+    uint32_t* texture = pages[page];
+    sceGuCopyImage(FRAMEBUFFER_FORMAT, 0, 0, texture[0] & 0xffff, texture[1], SCEGU_VRAM_WIDTH, eDRAMAddress + (uint32_t)(drawToBuffer0 ? FRAMEBUFFER_0 : FRAMEBUFFER_1), 0, 0, texture[2], texture + 4);
+    sceGuTexSync();
+    sceGuTexFlush();
+
+    sceGuDrawBuffer(FRAMEBUFFER_FORMAT, FRAMEBUFFER_2, SCEGU_VRAM_WIDTH);
+    sceGuScissor(0, 0, PLATFORM_SCREEN_WIDTH - 56, PLATFORM_SCREEN_HEIGHT - 32);
+}
+
+void PlatformPSP::renderPage(uint8_t page, uint16_t sourceX, uint16_t sourceY, uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+    setState(SCEGU_SCISSOR_TEST, true);
+
+    drawRectangle(0xffffffff, pages[page], sourceX, sourceY, x, y, width, height, false);
+}
+
 void PlatformPSP::renderSprite(uint8_t sprite, uint16_t x, uint16_t y)
 {
     drawRectangle(0xffffffff, sprites, (sprite >> 4) * 24, (sprite & 15) * 24, x, y, 24, 24);
@@ -840,33 +1360,29 @@ void PlatformPSP::renderAnimTile(uint8_t animTile, uint16_t x, uint16_t y)
 
 void PlatformPSP::renderItem(uint8_t item, uint16_t x, uint16_t y)
 {
-    sceGuDisable(SCEGU_SCISSOR_TEST);
+    setState(SCEGU_SCISSOR_TEST, false);
 
     drawRectangle(0xffffffff, items, 0, item * 21, x, y, 48, 21);
-
-    sceGuEnable(SCEGU_SCISSOR_TEST);
 }
 
 void PlatformPSP::renderKey(uint8_t key, uint16_t x, uint16_t y)
 {
-    sceGuDisable(SCEGU_SCISSOR_TEST);
+    setState(SCEGU_SCISSOR_TEST, false);
 
     drawRectangle(0xffffffff, keys, 0, key * 14, x, y, 16, 14);
-
-    sceGuEnable(SCEGU_SCISSOR_TEST);
 }
 
 void PlatformPSP::renderHealth(uint8_t amount, uint16_t x, uint16_t y)
 {
-    sceGuDisable(SCEGU_SCISSOR_TEST);
+    setState(SCEGU_SCISSOR_TEST, false);
 
     drawRectangle(0xffffffff, health, 0, amount * 51, x, y, 48, 51);
-
-    sceGuEnable(SCEGU_SCISSOR_TEST);
 }
 
 void PlatformPSP::renderFace(uint8_t face, uint16_t x, uint16_t y)
 {
+    setState(SCEGU_SCISSOR_TEST, true);
+
     drawRectangle(0xffffffff, faces, 0, face * 24, x, y, 16, 24);
 }
 
@@ -877,10 +1393,13 @@ void PlatformPSP::renderLiveMap(uint8_t* map)
     clearRect(PLATFORM_SCREEN_WIDTH - 56 - LIVE_MAP_ORIGIN_X, LIVE_MAP_ORIGIN_Y, LIVE_MAP_ORIGIN_X, PLATFORM_SCREEN_HEIGHT - 32 - 2 * LIVE_MAP_ORIGIN_Y);
     clearRect(0, PLATFORM_SCREEN_HEIGHT - 32 - LIVE_MAP_ORIGIN_Y, PLATFORM_SCREEN_WIDTH - 56, LIVE_MAP_ORIGIN_Y);
 
-    sceGuEnable(SCEGU_TEXTURE);
-    sceGuTexFilter(SCEGU_LINEAR, SCEGU_LINEAR);
-    sceGuTexImage(0, tiles[2], tiles[3], tiles[2], tiles + 4);
-    sceGuColor(0xffffffff);
+    setState(SCEGU_SCISSOR_TEST, true);
+    setState(SCEGU_TEXTURE, true);
+    setState(SCEGU_BLEND, true);
+    setTexture(tiles);
+    setTextureFilter(SCEGU_LINEAR);
+    setColor(0xffffffff);
+    countTextureFetch(64 * 128 * 24 * 24);
 
     int oldCacheSize = cacheSize;
     float* dataStart = (float*)(cache + cacheSize);
@@ -912,19 +1431,22 @@ void PlatformPSP::renderLiveMap(uint8_t* map)
     sceKernelDcacheWritebackRange(dataStart, cacheSize - oldCacheSize);
     sceGumDrawArrayN(SCEGU_PRIM_RECTANGLES, SCEGU_TEXTURE_FLOAT | SCEGU_VERTEX_FLOAT, 2, 64 * 128, 0, dataStart);
 
-    for (int i = 0; i < 48; i++) {
+    for (int i = 0; i < 256; i++) {
         unitTypes[i] = 255;
     }
 
-    sceGuTexFilter(SCEGU_NEAREST, SCEGU_NEAREST);
-
     isDirty = true;
 }
 
 void PlatformPSP::renderLiveMapTile(uint8_t* map, uint8_t mapX, uint8_t mapY)
 {
-    sceGuEnable(SCEGU_TEXTURE);
-    sceGuTexFilter(SCEGU_LINEAR, SCEGU_LINEAR);
+    setState(SCEGU_SCISSOR_TEST, true);
+    setState(SCEGU_TEXTURE, true);
+    setState(SCEGU_BLEND, true);
+    setTexture(tiles);
+    setTextureFilter(SCEGU_LINEAR);
+    setColor(0xffffffff);
+    countTextureFetch(24 * 24);
 
     int tile = map[(mapY << 7) + mapX];
     int x = LIVE_MAP_ORIGIN_X + mapX * 3;
@@ -932,9 +1454,6 @@ void PlatformPSP::renderLiveMapTile(uint8_t* map, uint8_t mapX, uint8_t mapY)
     int tx = (tile & 15) * 24;
     int ty = (tile >> 4) * 24;
 
-    sceGuTexImage(0, tiles[2], tiles[3], tiles[2], tiles + 4);
-    sceGuColor(0xffffffff);
-
     int oldCacheSize = cacheSize;
     float* data = (float*)(cache + cacheSize);
     data[0 * 5 + 0] = tx / (float)tiles[2];
@@ -952,15 +1471,13 @@ void PlatformPSP::renderLiveMapTile(uint8_t* map, uint8_t mapX, uint8_t mapY)
     sceKernelDcacheWritebackRange(data, cacheSize - oldCacheSize);
     sceGumDrawArray(SCEGU_PRIM_RECTANGLES, SCEGU_TEXTURE_FLOAT | SCEGU_VERTEX_FLOAT, 2, 0, data);
 
-    sceGuTexFilter(SCEGU_NEAREST, SCEGU_NEAREST);
-
     isDirty = true;
 }
 
-void PlatformPSP::renderLiveMapUnits(uint8_t* map, uint8_t* unitTypes, uint8_t* unitX, uint8_t* unitY, uint8_t playerColor, bool showRobots)
+void PlatformPSP::renderLiveMapUnits(uint8_t* map, uint8_t* unitTypes, uint8_t* unitX, uint8_t* unitY, uint8_t robotCount, uint8_t unitCount, uint8_t playerColor, bool showRobots)
 {
-    for (int i = 0; i < 48; i++) {
-        if ((i < 28 || unitTypes[i] == 22) && (unitX[i] != ::unitX[i] || unitY[i] != ::unitY[i] || (i > 0 && (!showRobots || unitTypes[i] == 22 || unitTypes[i] != ::unitTypes[i])) || (i == 0 && playerColor != ::unitTypes[i]))) {
+    for (int i = 0; i < unitCount; i++) {
+        if ((i < robotCount || unitTypes[i] == 22) && (unitX[i] != ::unitX[i] || unitY[i] != ::unitY[i] || (i > 0 && (!showRobots || unitTypes[i] == 22 || unitTypes[i] != ::unitTypes[i])) || (i == 0 && playerColor != ::unitTypes[i]))) {
             // Remove old dot if any
             if (::unitTypes[i] != 255) {
                 renderLiveMapTile(map, ::unitX[i], ::unitY[i]);
@@ -970,16 +1487,18 @@ void PlatformPSP::renderLiveMapUnits(uint8_t* map, uint8_t* unitTypes, uint8_t*
                 }
             }
 
-            if (i == 0 ||
+            if (unitX[i] < 128 && unitY[i] < 64 && // inside the part of the map that is shown
+                (i == 0 ||
                 (unitTypes[i] == 22 && (unitX[i] != unitX[0] || unitY[i] != unitY[0])) ||
                 (showRobots &&
                  (unitTypes[i] == 1 ||
                  (unitTypes[i] >= 2 && unitTypes[i] <= 5) ||
                  (unitTypes[i] >= 17 && unitTypes[i] <= 18) ||
-                 unitTypes[i] == 9))) {
+                 unitTypes[i] == 9)))) {
                 // Render new dot
                 int x = unitX[i];
                 int y = unitY[i];
+                setState(SCEGU_SCISSOR_TEST, true);
                 drawRectangle(palette[(i > 0 || playerColor == 1) ? 1 : 0], 0, 0, 0, LIVE_MAP_ORIGIN_X + x * 3, LIVE_MAP_ORIGIN_Y + y * 3, 3, 3);
 
                 ::unitTypes[i] = i == 0 ? playerColor : unitTypes[i];
@@ -1016,23 +1535,19 @@ void PlatformPSP::setCursorShape(CursorShape shape)
 
 void PlatformPSP::copyRect(uint16_t sourceX, uint16_t sourceY, uint16_t destinationX, uint16_t destinationY, uint16_t width, uint16_t height)
 {
-    sceGuDisable(SCEGU_SCISSOR_TEST);
+    setState(SCEGU_SCISSOR_TEST, false);
 
-    sceGuCopyImage(SCEGU_PF8888, sourceX, sourceY, width, height, SCEGU_VRAM_WIDTH, eDRAMAddress + (uint32_t)SCEGU_VRAM_BP32_2, destinationX, destinationY, SCEGU_VRAM_WIDTH, eDRAMAddress + (uint32_t)SCEGU_VRAM_BP32_2);
-
-    sceGuEnable(SCEGU_SCISSOR_TEST);
+    sceGuCopyImage(FRAMEBUFFER_FORMAT, sourceX, sourceY, width, height, SCEGU_VRAM_WIDTH, eDRAMAddress + (uint32_t)FRAMEBUFFER_2, destinationX, destinationY, SCEGU_VRAM_WIDTH, eDRAMAddress + (uint32_t)FRAMEBUFFER_2);
 
     isDirty = true;
 }
 
 void PlatformPSP::clearRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
 {
-    sceGuDisable(SCEGU_SCISSOR_TEST);
+    setState(SCEGU_SCISSOR_TEST, false);
 
     drawRectangle(0xff000000, 0, 0, 0, x, y, width, height);
 
-    sceGuEnable(SCEGU_SCISSOR_TEST);
-
     isDirty = true;
 }
 
@@ -1076,51 +1591,55 @@ void PlatformPSP::stopFadeScreen()
 
 void PlatformPSP::writeToScreenMemory(address_t address, uint8_t value)
 {
-    sceGuDisable(SCEGU_SCISSOR_TEST);
-
     if (scaleX == 1.0f && (address % SCREEN_WIDTH_IN_CHARACTERS) == (SCREEN_WIDTH_IN_CHARACTERS - 7)) {
         return;
     }
 
+    setState(SCEGU_SCISSOR_TEST, false);
+
     if (value > 127) {
         value &= 127;
         drawRectangle(0xff55bb77, 0, 0, 0, (address % SCREEN_WIDTH_IN_CHARACTERS) << 3, (address / SCREEN_WIDTH_IN_CHARACTERS) << 3, 8, 8);
         drawRectangle(0xff000000, font, (value >> 3) & 0x8, (value << 3) & 0x1ff, (address % SCREEN_WIDTH_IN_CHARACTERS) << 3, (address / SCREEN_WIDTH_IN_CHARACTERS) << 3, 8, 8);
     } else {
-        sceGuDisable(SCEGU_BLEND);
-        drawRectangle(0xff55bb77, font, (value >> 3) & 0x8, (value << 3) & 0x1ff, (address % SCREEN_WIDTH_IN_CHARACTERS) << 3, (address / SCREEN_WIDTH_IN_CHARACTERS) << 3, 8, 8);
-        sceGuEnable(SCEGU_BLEND);
+        drawRectangle(0xff55bb77, font, (value >> 3) & 0x8, (value << 3) & 0x1ff, (address % SCREEN_WIDTH_IN_CHARACTERS) << 3, (address / SCREEN_WIDTH_IN_CHARACTERS) << 3, 8, 8, false);
     }
-
-    sceGuEnable(SCEGU_SCISSOR_TEST);
 }
 
 void PlatformPSP::writeToScreenMemory(address_t address, uint8_t value, uint8_t color, uint8_t yOffset)
 {
-    sceGuDisable(SCEGU_SCISSOR_TEST);
-
     if (scaleX == 1.0f && (address % SCREEN_WIDTH_IN_CHARACTERS) == (SCREEN_WIDTH_IN_CHARACTERS - 7)) {
         return;
     }
 
+    setState(SCEGU_SCISSOR_TEST, false);
+
     if (value > 127) {
         value &= 127;
         drawRectangle(palette[color], 0, 0, 0, (address % SCREEN_WIDTH_IN_CHARACTERS) << 3, ((address / SCREEN_WIDTH_IN_CHARACTERS) << 3) + yOffset, 8, 8);
         drawRectangle(0xff000000, font, (value >> 3) & 0x8, (value << 3) & 0x1ff, (address % SCREEN_WIDTH_IN_CHARACTERS) << 3, ((address / SCREEN_WIDTH_IN_CHARACTERS) << 3) + yOffset, 8, 8);
     } else {
-        sceGuDisable(SCEGU_BLEND);
-        drawRectangle(palette[color], font, (value >> 3) & 0x8, (value << 3) & 0x1ff, (address % SCREEN_WIDTH_IN_CHARACTERS) << 3, ((address / SCREEN_WIDTH_IN_CHARACTERS) << 3) + yOffset, 8, 8);
-        sceGuEnable(SCEGU_BLEND);
+        drawRectangle(palette[color], font, (value >> 3) & 0x8, (value << 3) & 0x1ff, (address % SCREEN_WIDTH_IN_CHARACTERS) << 3, ((address / SCREEN_WIDTH_IN_CHARACTERS) << 3) + yOffset, 8, 8, false);
     }
-
-    sceGuEnable(SCEGU_SCISSOR_TEST);
 }
 
 void PlatformPSP::loadModule(Module module)
 {
     if (loadedModule != module) {
-        uint32_t moduleSize = load(moduleFilenames[module], moduleData, LARGEST_MODULE_SIZE, 0);
-        undeltaSamples(moduleData, moduleSize);
+        if (prefetchQueued && queuedModule == module) {
+            startQueuedPrefetch();
+        }
+        if (prefetchModulePending && prefetchModule == module) {
+            // Take the prefetched module by swapping the buffers
+            waitForPrefetch();
+            uint8_t* data = moduleData;
+            moduleData = prefetchModuleData;
+            prefetchModuleData = data;
+            prefetchModulePending = false;
+        } else {
+            uint32_t moduleSize = load(moduleFilenames[module], moduleData, LARGEST_MODULE_SIZE, 0);
+            undeltaSamples(moduleData, moduleSize);
+        }
         setSampleData(moduleData);
         loadedModule = module;
     }
@@ -1178,17 +1697,49 @@ void PlatformPSP::stopSample()
     }
 }
 
+uint32_t PlatformPSP::saveAudioState(uint8_t* destination)
+{
+    destination[0] = loadedModule;
+    return mt_save(destination + 1) + 1;
+}
+
+bool PlatformPSP::restoreAudioState(uint8_t* source, uint32_t size)
+{
+    if (size != MT_STATE_SIZE + 1) {
+        return false;
+    }
+
+    mt_end();
+    loadModule((Module)source[0]);
+    mt_restore(source + 1);
+    return true;
+}
+
 void PlatformPSP::renderFrame(bool waitForNextFrame)
 {
-    if (!isDirty) {
-        return;
+    // While catching up, a frame that would wait for the previous one is skipped
+    updateTicks();
+    if (prefetchQueued && prefetchReady) {
+        startQueuedPrefetch();
+    }
+    if (isDirty && !(dueTicks != 0 && swapBuffers)) {
+        presentFrame();
     }
+    if (waitForNextFrame) {
+        runTick();
+    }
+}
 
+void PlatformPSP::presentFrame()
+{
     while (swapBuffers);
+#ifdef PLATFORM_STATISTICS
+    uint32_t start = sceKernelGetSystemTimeLow();
+#endif
 
-    sceGuCopyImage(SCEGU_PF8888, 0, 0, SCEGU_SCR_WIDTH, SCEGU_SCR_HEIGHT, SCEGU_VRAM_WIDTH, eDRAMAddress + (uint32_t)SCEGU_VRAM_BP32_2, 0, 0, SCEGU_VRAM_WIDTH, eDRAMAddress + (uint32_t)(drawToBuffer0 ? SCEGU_VRAM_BP32_0 : SCEGU_VRAM_BP32_1));
-    sceGuDrawBuffer(SCEGU_PF8888, drawToBuffer0 ? SCEGU_VRAM_BP32_0 : SCEGU_VRAM_BP32_1, SCEGU_VRAM_WIDTH);
-    sceGuDisable(SCEGU_SCISSOR_TEST);
+    sceGuCopyImage(FRAMEBUFFER_FORMAT, 0, 0, SCEGU_SCR_WIDTH, SCEGU_SCR_HEIGHT, SCEGU_VRAM_WIDTH, eDRAMAddress + (uint32_t)FRAMEBUFFER_2, 0, 0, SCEGU_VRAM_WIDTH, eDRAMAddress + (uint32_t)(drawToBuffer0 ? FRAMEBUFFER_0 : FRAMEBUFFER_1));
+    sceGuDrawBuffer(FRAMEBUFFER_FORMAT, drawToBuffer0 ? FRAMEBUFFER_0 : FRAMEBUFFER_1, SCEGU_VRAM_WIDTH);
+    setState(SCEGU_SCISSOR_TEST, false);
 
     if (cursorX != -1) {
         drawRectangle(0xffffffff, 0, 0, 0, cursorX, cursorY, 28, 2);
@@ -1212,8 +1763,23 @@ void PlatformPSP::renderFrame(bool waitForNextFrame)
     cacheSize = 0;
 
     sceGuStart(SCEGU_IMMEDIATE, displayList, DISPLAYLIST_SIZE * sizeof(int));
-    sceGuDrawBuffer(SCEGU_PF8888, SCEGU_VRAM_BP32_2, SCEGU_VRAM_WIDTH);
-    sceGuEnable(SCEGU_SCISSOR_TEST);
+    sceGuDrawBuffer(FRAMEBUFFER_FORMAT, FRAMEBUFFER_2, SCEGU_VRAM_WIDTH);
 
     isDirty = false;
+
+#ifdef PLATFORM_STATISTICS
+    presentedFrames++;
+    presentTime += sceKernelGetSystemTimeLow() - start;
+    if (tickCheckTime - stateStatisticsTime >= 1000000) {
+        debug("%lu us to present each frame, %lu GE state changes per frame, %lu left out\n", presentTime / presentedFrames, emittedStateChanges / presentedFrames, elidedStateChanges / presentedFrames);
+        debug("%lu texels per frame read from VRAM, %lu from RAM, %lu KB of VRAM taken by textures\n", vramTexels / presentedFrames, ramTexels / presentedFrames, vramUsed / 1024);
+        vramTexels = 0;
+        ramTexels = 0;
+        emittedStateChanges = 0;
+        elidedStateChanges = 0;
+        presentedFrames = 0;
+        presentTime = 0;
+        stateStatisticsTime = tickCheckTime;
+    }
+#endif
 }
@@ -15,26 +15,34 @@ public:
     virtual ~PlatformPSP();
 
     virtual uint8_t* standardControls() const;
-    virtual void setInterrupt(void (*interrupt)(void));
+    virtual void setInterrupt(void (*interrupt)(void* context), void* context);
     virtual int framesPerSecond();
+    virtual uint32_t microseconds();
     virtual uint8_t readKeyboard();
     virtual void keyRepeat();
     virtual void clearKeyBuffer();
     virtual bool isKeyOrJoystickPressed(bool gamepad);
     virtual uint16_t readJoystick(bool gamepad);
     virtual uint32_t load(const char* filename, uint8_t* destination, uint32_t size, uint32_t offset = 0);
+    virtual void prefetch(const char* filename, uint8_t* destination, uint32_t size, Module module);
+    virtual uint32_t finishPrefetch(const char* filename);
+    virtual uint32_t save(const char* filename, uint8_t* source, uint32_t size);
     virtual uint8_t* loadTileset(const char* filename);
     virtual void displayImage(Image image);
     virtual void generateTiles(uint8_t* tileData, uint8_t* tileAttributes);
     virtual void renderTile(uint8_t tile, uint16_t x, uint16_t y, uint8_t variant = 0, bool transparent = false);
     virtual void renderTiles(uint8_t backgroundTile, uint8_t foregroundTile, uint16_t x, uint16_t y, uint8_t backgroundVariant, uint8_t foregroundVariant);
+    virtual uint8_t backgroundPages(uint16_t width, uint16_t height);
+    virtual void beginPage(uint8_t page);
+    virtual void endPage(uint8_t page);
+    virtual void renderPage(uint8_t page, uint16_t sourceX, uint16_t sourceY, uint16_t x, uint16_t y, uint16_t width, uint16_t height);
     virtual void renderItem(uint8_t item, uint16_t x, uint16_t y);
     virtual void renderKey(uint8_t key, uint16_t x, uint16_t y);
     virtual void renderHealth(uint8_t health, uint16_t x, uint16_t y);
     virtual void renderFace(uint8_t face, uint16_t x, uint16_t y);
     virtual void renderLiveMap(uint8_t* map);
     virtual void renderLiveMapTile(uint8_t* map, uint8_t x, uint8_t y);
-    virtual void renderLiveMapUnits(uint8_t* map, uint8_t* unitTypes, uint8_t* unitX, uint8_t* unitY, uint8_t playerColor, bool showRobots);
+    virtual void renderLiveMapUnits(uint8_t* map, uint8_t* unitTypes, uint8_t* unitX, uint8_t* unitY, uint8_t robotCount, uint8_t unitCount, uint8_t playerColor, bool showRobots);
     virtual void showCursor(uint16_t x, uint16_t y);
     virtual void hideCursor();
     virtual void setCursorShape(CursorShape shape);
@@ -51,6 +59,8 @@ public:
     virtual void stopModule();
     virtual void playSample(uint8_t sample);
     virtual void stopSample();
+    virtual uint32_t saveAudioState(uint8_t* destination);
+    virtual bool restoreAudioState(uint8_t* source, uint32_t size);
     virtual void renderFrame(bool waitForNextFrame);
 
 private:
@@ -58,17 +68,55 @@ private:
     static int exitCallback(int arg1, int arg2, void* common);
     static SceInt32 audioThread(SceSize args, SceVoid* argb);
     static void vblankHandler(int idx, void* cookie);
-    void drawRectangle(uint32_t color, uint32_t* texture, uint16_t tx, uint16_t ty, uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+    void updateTicks();
+    void runTick();
+    void presentFrame();
+    static int prefetchThread(SceSize args, void* argp);
+    void waitForPrefetch();
+    void startPrefetch(const char* filename, uint8_t* destination, uint32_t size, Module module);
+    void startQueuedPrefetch();
+    void setState(int state, bool enable);
+    void setTexture(uint32_t* texture);
+    void setTextureFilter(int filter);
+    void setTextureMode(uint32_t mode);
+    void setColor(uint32_t color);
+    void countTextureFetch(uint32_t texels);
+    uint8_t* allocateVRAM(uint32_t size);
+    void freeVRAM();
+    void placeTextures();
+    void drawRectangle(uint32_t color, uint32_t* texture, uint16_t tx, uint16_t ty, uint16_t x, uint16_t y, uint16_t width, uint16_t height, bool blend = true);
     void undeltaSamples(uint8_t* module, uint32_t moduleSize);
     void setSampleData(uint8_t* module);
     void renderSprite(uint8_t sprite, uint16_t x, uint16_t y);
     void renderAnimTile(uint8_t animTile, uint16_t x, uint16_t y);
 
     uint8_t* eDRAMAddress;
-    void (*interrupt)(void);
+    void (*interrupt)(void* context);
+    void* interruptContext;
     int framesPerSecond_;
+    uint32_t tickAccumulator; // Microseconds times ticks per second towards the next tick
+    uint32_t tickCheckTime;
+    uint32_t dueTicks;
+    uint32_t lateTicks;
+    uint32_t droppedTicks;
+    uint32_t tickStatisticsTime;
     uint8_t* moduleData;
     Module loadedModule;
+    uint8_t* prefetchModuleData;
+    Module prefetchModule;
+    bool prefetchModulePending;
+    char prefetchFilename[16];
+    uint8_t* prefetchDestination;
+    uint32_t prefetchSize;
+    uint32_t prefetchLoadedSize;
+    uint32_t prefetchTime;
+    SceUID prefetchThreadId;
+    volatile bool prefetchReady;
+    bool prefetchQueued; // A request made while the previous one was still loading
+    char queuedFilename[16];
+    uint8_t* queuedDestination;
+    uint32_t queuedSize;
+    Module queuedModule;
     uint8_t effectChannel;
     int16_t *audioBuffer;
     SceShort16 *audioOutputBuffer;
@@ -86,8 +134,23 @@ private:
     uint32_t fadeBaseColor;
     uint16_t fadeIntensity;
     bool drawToBuffer0;
-    bool swapBuffers;
+    volatile bool swapBuffers;
     bool isDirty;
+    uint32_t enabledStates; // The GE state last sent, to leave out commands that change nothing
+    uint32_t* boundTexture;
+    int textureFilter;
+    uint32_t textureMode; // The TEXTURE_* flags of the texture format last sent
+    uint32_t boundColor;
+    uint32_t emittedStateChanges;
+    uint32_t elidedStateChanges;
+    uint32_t presentedFrames;
+    uint32_t presentTime;
+    uint32_t vramUsed; // Bytes taken by textures after the frame buffers
+    int boundTextureIndex;
+    uint32_t vramTexels;
+    uint32_t ramTexels;
+    uint32_t stateStatisticsTime;
+    uint8_t pageCount;
 };
 
 #endif
@@ -0,0 +1,806 @@
+#include <cstdio>
+#include <cstring>
+#include <png.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "PlatformSoftware.h"
+
+#define PNG_FILE_MAX_SIZE (256 * 1024)
+#define ROW_MAX_WIDTH 512
+
+#define LIVE_MAP_ORIGIN_X ((PLATFORM_SCREEN_WIDTH - 56 - 128 * 3) / 2)
+#define LIVE_MAP_ORIGIN_Y ((PLATFORM_SCREEN_HEIGHT - 32 - 64 * 3) / 2)
+
+static const uint32_t paletteIntro[] = {
+    0xff000000,
+    0xff443300,
+    0xff775533,
+    0xff997755,
+    0xffccaa88,
+    0xff882222,
+    0xffcc7766,
+    0xffee8888,
+    0xffaa5577,
+    0xff3311aa,
+    0xff6644cc,
+    0xff4488ee,
+    0xff33bbee,
+    0xff88eeee,
+    0xffeeeeee,
+    0xff55bb77
+};
+
+static const uint32_t paletteGame[] = {
+    0xff000000,
+    0xffffffff,
+    0xff775544,
+    0xff998877,
+    0xffccbbaa,
+    0xff993300,
+    0xffbb6633,
+    0xffffaa00,
+    0xff006655,
+    0xff009977,
+    0xff00ddaa,
+    0xff004477,
+    0xff0077bb,
+    0xff00ccff,
+    0xff99aaee,
+    0xff0000ee
+};
+
+static int8_t tileSpriteMap[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1, 49, 50, 57, 58, 59, 60, -1, -1, -1, -1, -1, -1, -1, 48,
+    -1, -1, -1, 73, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     1,  0,  3, -1, 53, 54, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, 76, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+static int8_t animTileMap[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1,  0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 16,
+    -1, -1, -1, -1,  4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1,  8, 10, -1, -1, 12, 14, -1, -1, 20, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+// The textures of the PSP, in the order of TextureName
+static const char* textureFilenames[] = {
+    "tiles.png",
+    "sprites.png",
+    "animtiles.png",
+    "c64font.png",
+    "health.png",
+    "items.png",
+    "keys.png",
+    "faces.png",
+    "introscreen.png",
+    "gamescreen.png",
+    "gameover.png"
+};
+
+// The row operations below work like the GE with the texture function
+// modulating the texture by the color and the source alpha blending
+// function. Channels are multiplied as x * y / 255 rounded to nearest,
+// the same with and without SSE2, so that both give the same picture.
+static inline uint32_t multiply(uint32_t x, uint32_t y)
+{
+    uint32_t product = x * y + 128;
+    return (product + (product >> 8)) >> 8;
+}
+
+static inline uint32_t modulate(uint32_t texel, uint32_t color)
+{
+    return multiply(texel & 0xff, color & 0xff) |
+        (multiply((texel >> 8) & 0xff, (color >> 8) & 0xff) << 8) |
+        (multiply((texel >> 16) & 0xff, (color >> 16) & 0xff) << 16) |
+        (multiply(texel >> 24, color >> 24) << 24);
+}
+
+static inline uint32_t blend(uint32_t source, uint32_t destination)
+{
+    uint32_t alpha = source >> 24;
+    uint32_t result = 0;
+    for (int shift = 0; shift != 32; shift += 8) {
+        uint32_t product = ((source >> shift) & 0xff) * alpha + ((destination >> shift) & 0xff) * (255 - alpha) + 128;
+        result |= ((product + (product >> 8)) >> 8) << shift;
+    }
+    return result;
+}
+
+#ifdef __SSE2__
+static inline __m128i divide255(__m128i x)
+{
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// Two pixels in 16-bit lanes times the color in 16-bit lanes
+static inline __m128i modulate2(__m128i pixels, __m128i color)
+{
+    return divide255(_mm_mullo_epi16(pixels, color));
+}
+
+static inline __m128i blend2(__m128i source, __m128i destination)
+{
+    __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(source, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+    return divide255(_mm_add_epi16(_mm_mullo_epi16(source, alpha), _mm_mullo_epi16(destination, inverse)));
+}
+#endif
+
+// Writes count pixels of source modulated by color
+static void copyRow(uint32_t* destination, const uint32_t* source, int count, uint32_t color)
+{
+    if (color == 0xffffffff) {
+        memcpy(destination, source, count * sizeof(uint32_t));
+        return;
+    }
+
+    int i = 0;
+#ifdef __SSE2__
+    __m128i zero = _mm_setzero_si128();
+    __m128i color16 = _mm_unpacklo_epi8(_mm_set1_epi32(color), zero);
+    for (; i + 4 <= count; i += 4) {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(source + i));
+        __m128i low = modulate2(_mm_unpacklo_epi8(pixels, zero), color16);
+        __m128i high = modulate2(_mm_unpackhi_epi8(pixels, zero), color16);
+        _mm_storeu_si128((__m128i*)(destination + i), _mm_packus_epi16(low, high));
+    }
+#endif
+    for (; i < count; i++) {
+        destination[i] = modulate(source[i], color);
+    }
+}
+
+// Blends count pixels of source modulated by color over destination
+static void blendRow(uint32_t* destination, const uint32_t* source, int count, uint32_t color)
+{
+    int i = 0;
+#ifdef __SSE2__
+    __m128i zero = _mm_setzero_si128();
+    __m128i color16 = _mm_unpacklo_epi8(_mm_set1_epi32(color), zero);
+    bool white = color == 0xffffffff;
+    for (; i + 4 <= count; i += 4) {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(source + i));
+        __m128i background = _mm_loadu_si128((const __m128i*)(destination + i));
+        __m128i low = _mm_unpacklo_epi8(pixels, zero);
+        __m128i high = _mm_unpackhi_epi8(pixels, zero);
+        if (!white) {
+            low = modulate2(low, color16);
+            high = modulate2(high, color16);
+        }
+        low = blend2(low, _mm_unpacklo_epi8(background, zero));
+        high = blend2(high, _mm_unpackhi_epi8(background, zero));
+        _mm_storeu_si128((__m128i*)(destination + i), _mm_packus_epi16(low, high));
+    }
+#endif
+    for (; i < count; i++) {
+        destination[i] = blend(color == 0xffffffff ? source[i] : modulate(source[i], color), destination[i]);
+    }
+}
+
+PlatformSoftware::PlatformSoftware(const char* dataPath) :
+    PlatformHeadless(dataPath),
+    pages(0),
+    pageCount(0),
+    screen(new uint32_t[PLATFORM_SCREEN_WIDTH * PLATFORM_SCREEN_HEIGHT]),
+    frame_(new uint32_t[PLATFORM_SCREEN_WIDTH * PLATFORM_SCREEN_HEIGHT]),
+    target(screen),
+    targetWidth(PLATFORM_SCREEN_WIDTH),
+    targetHeight(PLATFORM_SCREEN_HEIGHT),
+    scissorTest(true),
+    scissorWidth(PLATFORM_SCREEN_WIDTH),
+    scissorHeight(PLATFORM_SCREEN_HEIGHT),
+    palette(paletteIntro),
+    scaleX(1.0f),
+    scaleY(1.0f),
+    cursorX(-1),
+    cursorY(-1),
+    cursorShape(ShapeUse),
+    fadeBaseColor(0),
+    fadeIntensity(0),
+    isDirty(false),
+    presentedFrames_(0),
+    frameHandler(0),
+    frameContext(0)
+{
+    for (int i = 0; i < PLATFORM_SCREEN_WIDTH * PLATFORM_SCREEN_HEIGHT; i++) {
+        screen[i] = 0xff000000;
+        frame_[i] = 0xff000000;
+    }
+    for (int i = 0; i < TextureCount; i++) {
+        loadTexture((TextureName)i, textureFilenames[i]);
+    }
+
+    // The live map filters the tiles linearly to 3x3 pixels, which reads
+    // the four texels around the middle of each 8x8 block
+    const Texture& tiles = textures[TextureTiles];
+    for (int tile = 0; tile < 256; tile++) {
+        for (int y = 0; y < 3; y++) {
+            for (int x = 0; x < 3; x++) {
+                const uint32_t* texel = tiles.pixels + ((tile >> 4) * 24 + y * 8 + 3) * tiles.width + (tile & 15) * 24 + x * 8 + 3;
+                uint32_t dot = 0;
+                for (int shift = 0; shift != 32; shift += 8) {
+                    uint32_t sum = ((texel[0] >> shift) & 0xff) + ((texel[1] >> shift) & 0xff) +
+                        ((texel[tiles.width] >> shift) & 0xff) + ((texel[tiles.width + 1] >> shift) & 0xff);
+                    dot |= ((sum + 2) >> 2) << shift;
+                }
+                liveMapDots[tile][y * 3 + x] = dot;
+            }
+        }
+    }
+
+    memset(unitTypes, 255, sizeof(unitTypes));
+    memset(unitX, 0, sizeof(unitX));
+    memset(unitY, 0, sizeof(unitY));
+}
+
+PlatformSoftware::~PlatformSoftware()
+{
+    for (int i = 0; i < TextureCount; i++) {
+        delete[] textures[i].pixels;
+    }
+    for (int i = 0; i < pageCount; i++) {
+        delete[] pages[i].pixels;
+    }
+    delete[] pages;
+    delete[] frame_;
+    delete[] screen;
+}
+
+// A texture that can't be loaded is left as a transparent 1x1 texture,
+// so that the rest still draws
+void PlatformSoftware::loadTexture(TextureName name, const char* filename)
+{
+    Texture& texture = textures[name];
+    texture.pixels = 0;
+    uint8_t* file = new uint8_t[PNG_FILE_MAX_SIZE];
+    uint32_t size = load(filename, file, PNG_FILE_MAX_SIZE);
+    if (size != 0) {
+        png_image image;
+        memset(&image, 0, sizeof(image));
+        image.version = PNG_IMAGE_VERSION;
+        if (png_image_begin_read_from_memory(&image, file, size)) {
+            image.format = PNG_FORMAT_RGBA;
+            texture.pixels = new uint32_t[image.width * image.height];
+            texture.width = image.width;
+            texture.height = image.height;
+            if (!png_image_finish_read(&image, 0, texture.pixels, 0, 0)) {
+                delete[] texture.pixels;
+                texture.pixels = 0;
+            }
+        }
+    }
+    delete[] file;
+
+    if (!texture.pixels) {
+        debug("Couldn't load %s\n", filename);
+        texture.pixels = new uint32_t[1];
+        texture.pixels[0] = 0;
+        texture.width = 1;
+        texture.height = 1;
+    }
+}
+
+void PlatformSoftware::setTarget(uint32_t* pixels, uint16_t width, uint16_t height)
+{
+    target = pixels;
+    targetWidth = width;
+    targetHeight = height;
+}
+
+// Covers the pixels whose centers are inside the scaled rectangle and
+// samples the nearest texel, as the GE does with sprites
+void PlatformSoftware::drawRectangle(uint32_t color, const Texture* texture, uint16_t tx, uint16_t ty, uint16_t x, uint16_t y, uint16_t width, uint16_t height, bool blend)
+{
+    static uint32_t row[ROW_MAX_WIDTH];
+
+    int left = (int)(x * scaleX + 0.5f);
+    int top = (int)(y * scaleY + 0.5f);
+    int right = (int)((x + width) * scaleX + 0.5f);
+    int bottom = (int)((y + height) * scaleY + 0.5f);
+    int clipRight = scissorTest ? MIN(scissorWidth, targetWidth) : targetWidth;
+    int clipBottom = scissorTest ? MIN(scissorHeight, targetHeight) : targetHeight;
+    int firstX = MAX(left, 0);
+    int firstY = MAX(top, 0);
+    int count = MIN(right, clipRight) - firstX;
+    int lastY = MIN(bottom, clipBottom);
+    if (count <= 0 || firstY >= lastY) {
+        return;
+    }
+
+    bool scaled = scaleX != 1.0f || scaleY != 1.0f;
+    uint32_t rowColor = color;
+    if (!texture) {
+        for (int i = 0; i < count; i++) {
+            row[i] = color;
+        }
+        rowColor = 0xffffffff;
+    } else if (scaled) {
+        for (int i = 0; i < count; i++) {
+            int u = tx + (int)((firstX + i + 0.5f) / scaleX - x);
+            row[i] = (uint32_t)u < texture->width ? u : texture->width - 1;
+        }
+    }
+
+    for (int screenY = firstY; screenY < lastY; screenY++) {
+        uint32_t* destination = target + screenY * targetWidth + firstX;
+        const uint32_t* source = row;
+        if (texture) {
+            int v = scaled ? ty + (int)((screenY + 0.5f) / scaleY - y) : ty + screenY - top;
+            const uint32_t* texels = texture->pixels + MIN(v, texture->height - 1) * texture->width;
+            if (scaled) {
+                static uint32_t sampled[ROW_MAX_WIDTH];
+                for (int i = 0; i < count; i++) {
+                    sampled[i] = texels[row[i]];
+                }
+                source = sampled;
+            } else {
+                source = texels + tx + firstX - left;
+            }
+        }
+        if (blend) {
+            blendRow(destination, source, count, rowColor);
+        } else {
+            copyRow(destination, source, count, rowColor);
+        }
+    }
+
+    isDirty = true;
+}
+
+void PlatformSoftware::displayImage(Image image)
+{
+    const Texture* images[] = { &textures[TextureIntroScreen], &textures[TextureGameScreen], &textures[TextureGameOver] };
+    scaleX = 1.0f;
+    scaleY = 1.0f;
+
+    scissorWidth = PLATFORM_SCREEN_WIDTH;
+    scissorHeight = PLATFORM_SCREEN_HEIGHT;
+
+    this->clearRect(0, 0, PLATFORM_SCREEN_WIDTH, PLATFORM_SCREEN_HEIGHT);
+    scissorTest = true;
+
+    if (image == ImageGame) {
+        palette = paletteGame;
+
+        drawRectangle(0xffffffff, images[image], 320 - 56, 0, PLATFORM_SCREEN_WIDTH - 56, 0, 56, 128);
+
+        for (int y = 128; y < (PLATFORM_SCREEN_HEIGHT - 32); y += 40) {
+            drawRectangle(0xffffffff, images[image], 320 - 56, 128, PLATFORM_SCREEN_WIDTH - 56, y, 56, MIN(40, PLATFORM_SCREEN_HEIGHT - 32 - y));
+        }
+
+        drawRectangle(0xffffffff, images[image], 320 - 56, 168, PLATFORM_SCREEN_WIDTH - 56, PLATFORM_SCREEN_HEIGHT - 32, 56, 32);
+
+        drawRectangle(0xffffffff, images[image], 0, 168, 0, PLATFORM_SCREEN_HEIGHT - 32, 104, 8);
+
+        for (int x = 104; x < (PLATFORM_SCREEN_WIDTH - 56); x += 160) {
+            drawRectangle(0xffffffff, images[image], 104, 168, x, PLATFORM_SCREEN_HEIGHT - 32, MIN(160, PLATFORM_SCREEN_WIDTH - 56 - x), 8);
+        }
+
+        scissorWidth = PLATFORM_SCREEN_WIDTH - 56;
+        scissorHeight = PLATFORM_SCREEN_HEIGHT - 32;
+    } else {
+        palette = paletteIntro;
+
+        scaleX = PLATFORM_SCREEN_WIDTH / 320.0f;
+        scaleY = PLATFORM_SCREEN_HEIGHT / 200.0f;
+
+        drawRectangle(0xffffffff, images[image], 0, 0, 0, 0, images[image]->width, images[image]->height);
+    }
+}
+
+void PlatformSoftware::renderTile(uint8_t tile, uint16_t x, uint16_t y, uint8_t variant, bool transparent)
+{
+    scissorTest = true;
+
+    if (transparent) {
+        if (tileSpriteMap[tile] >= 0) {
+            renderSprite(tileSpriteMap[tile] + variant, x, y);
+            return;
+        }
+    } else {
+        if (animTileMap[tile] >= 0) {
+            renderAnimTile(animTileMap[tile] + variant, x, y);
+            return;
+        }
+    }
+
+    drawRectangle(0xffffffff, &textures[TextureTiles], (tile & 15) * 24, (tile >> 4) * 24, x, y, 24, 24);
+}
+
+void PlatformSoftware::renderTiles(uint8_t backgroundTile, uint8_t foregroundTile, uint16_t x, uint16_t y, uint8_t backgroundVariant, uint8_t foregroundVariant)
+{
+    scissorTest = true;
+
+    if (animTileMap[backgroundTile] >= 0) {
+        renderAnimTile(animTileMap[backgroundTile] + backgroundVariant, x, y);
+    } else {
+        drawRectangle(0xffffffff, &textures[TextureTiles], (backgroundTile & 15) * 24, (backgroundTile >> 4) * 24, x, y, 24, 24);
+    }
+
+    if (tileSpriteMap[foregroundTile] >= 0) {
+        renderSprite(tileSpriteMap[foregroundTile] + foregroundVariant, x, y);
+    } else {
+        drawRectangle(0xffffffff, &textures[TextureTiles], (foregroundTile & 15) * 24, (foregroundTile >> 4) * 24, x, y, 24, 24);
+    }
+}
+
+uint8_t PlatformSoftware::backgroundPages(uint16_t width, uint16_t height)
+{
+    if (!pages) {
+        pages = new Texture[PLATFORM_BACKGROUND_PAGES];
+        for (pageCount = 0; pageCount < PLATFORM_BACKGROUND_PAGES; pageCount++) {
+            pages[pageCount].pixels = new uint32_t[width * height];
+            pages[pageCount].width = width;
+            pages[pageCount].height = height;
+        }
+    }
+    return pageCount;
+}
+
+void PlatformSoftware::beginPage(uint8_t page)
+{
+    setTarget(pages[page].pixels, pages[page].width, pages[page].height);
+    scissorWidth = pages[page].width;
+    scissorHeight = pages[page].height;
+}
+
+void PlatformSoftware::endPage(uint8_t page)
+{
+    setTarget(screen, PLATFORM_SCREEN_WIDTH, PLATFORM_SCREEN_HEIGHT);
+    scissorWidth = PLATFORM_SCREEN_WIDTH - 56;
+    scissorHeight = PLATFORM_SCREEN_HEIGHT - 32;
+}
+
+void PlatformSoftware::renderPage(uint8_t page, uint16_t sourceX, uint16_t sourceY, uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+    scissorTest = true;
+
+    drawRectangle(0xffffffff, &pages[page], sourceX, sourceY, x, y, width, height, false);
+}
+
+void PlatformSoftware::renderSprite(uint8_t sprite, uint16_t x, uint16_t y)
+{
+    drawRectangle(0xffffffff, &textures[TextureSprites], (sprite >> 4) * 24, (sprite & 15) * 24, x, y, 24, 24);
+}
+
+void PlatformSoftware::renderAnimTile(uint8_t animTile, uint16_t x, uint16_t y)
+{
+    drawRectangle(0xffffffff, &textures[TextureAnimTiles], (animTile >> 4) * 24, (animTile & 15) * 24, x, y, 24, 24);
+}
+
+void PlatformSoftware::renderItem(uint8_t item, uint16_t x, uint16_t y)
+{
+    scissorTest = false;
+
+    drawRectangle(0xffffffff, &textures[TextureItems], 0, item * 21, x, y, 48, 21);
+}
+
+void PlatformSoftware::renderKey(uint8_t key, uint16_t x, uint16_t y)
+{
+    scissorTest = false;
+
+    drawRectangle(0xffffffff, &textures[TextureKeys], 0, key * 14, x, y, 16, 14);
+}
+
+void PlatformSoftware::renderHealth(uint8_t amount, uint16_t x, uint16_t y)
+{
+    scissorTest = false;
+
+    drawRectangle(0xffffffff, &textures[TextureHealth], 0, amount * 51, x, y, 48, 51);
+}
+
+void PlatformSoftware::renderFace(uint8_t face, uint16_t x, uint16_t y)
+{
+    scissorTest = true;
+
+    drawRectangle(0xffffffff, &textures[TextureFaces], 0, face * 24, x, y, 16, 24);
+}
+
+void PlatformSoftware::renderLiveMap(uint8_t* map)
+{
+    clearRect(0, 0, PLATFORM_SCREEN_WIDTH - 56, LIVE_MAP_ORIGIN_Y);
+    clearRect(0, LIVE_MAP_ORIGIN_Y, LIVE_MAP_ORIGIN_X, PLATFORM_SCREEN_HEIGHT - 32 - 2 * LIVE_MAP_ORIGIN_Y);
+    clearRect(PLATFORM_SCREEN_WIDTH - 56 - LIVE_MAP_ORIGIN_X, LIVE_MAP_ORIGIN_Y, LIVE_MAP_ORIGIN_X, PLATFORM_SCREEN_HEIGHT - 32 - 2 * LIVE_MAP_ORIGIN_Y);
+    clearRect(0, PLATFORM_SCREEN_HEIGHT - 32 - LIVE_MAP_ORIGIN_Y, PLATFORM_SCREEN_WIDTH - 56, LIVE_MAP_ORIGIN_Y);
+
+    for (int mapY = 0; mapY < 64; mapY++) {
+        for (int mapX = 0; mapX < 128; mapX++) {
+            renderLiveMapTile(map, mapX, mapY);
+        }
+    }
+
+    for (int i = 0; i < 256; i++) {
+        unitTypes[i] = 255;
+    }
+}
+
+void PlatformSoftware::renderLiveMapTile(uint8_t* map, uint8_t mapX, uint8_t mapY)
+{
+    const uint32_t* dot = liveMapDots[map[(mapY << 7) + mapX]];
+    uint32_t* destination = screen + (LIVE_MAP_ORIGIN_Y + mapY * 3) * PLATFORM_SCREEN_WIDTH + LIVE_MAP_ORIGIN_X + mapX * 3;
+    for (int y = 0; y < 3; y++, dot += 3, destination += PLATFORM_SCREEN_WIDTH) {
+        blendRow(destination, dot, 3, 0xffffffff);
+    }
+
+    isDirty = true;
+}
+
+void PlatformSoftware::renderLiveMapUnits(uint8_t* map, uint8_t* unitTypes, uint8_t* unitX, uint8_t* unitY, uint8_t robotCount, uint8_t unitCount, uint8_t playerColor, bool showRobots)
+{
+    for (int i = 0; i < unitCount; i++) {
+        if ((i < robotCount || unitTypes[i] == 22) && (unitX[i] != this->unitX[i] || unitY[i] != this->unitY[i] || (i > 0 && (!showRobots || unitTypes[i] == 22 || unitTypes[i] != this->unitTypes[i])) || (i == 0 && playerColor != this->unitTypes[i]))) {
+            // Remove old dot if any
+            if (this->unitTypes[i] != 255) {
+                renderLiveMapTile(map, this->unitX[i], this->unitY[i]);
+
+                if (i > 0 && !showRobots) {
+                    this->unitTypes[i] = 255;
+                }
+            }
+
+            if (unitX[i] < 128 && unitY[i] < 64 && // inside the part of the map that is shown
+                (i == 0 ||
+                (unitTypes[i] == 22 && (unitX[i] != unitX[0] || unitY[i] != unitY[0])) ||
+                (showRobots &&
+                 (unitTypes[i] == 1 ||
+                 (unitTypes[i] >= 2 && unitTypes[i] <= 5) ||
+                 (unitTypes[i] >= 17 && unitTypes[i] <= 18) ||
+                 unitTypes[i] == 9)))) {
+                // Render new dot
+                int x = unitX[i];
+                int y = unitY[i];
+                scissorTest = true;
+                drawRectangle(palette[(i > 0 || playerColor == 1) ? 1 : 0], 0, 0, 0, LIVE_MAP_ORIGIN_X + x * 3, LIVE_MAP_ORIGIN_Y + y * 3, 3, 3);
+
+                this->unitTypes[i] = i == 0 ? playerColor : unitTypes[i];
+                this->unitX[i] = unitX[i];
+                this->unitY[i] = unitY[i];
+            }
+        }
+    }
+
+    isDirty = true;
+}
+
+void PlatformSoftware::showCursor(uint16_t x, uint16_t y)
+{
+    cursorX = x * 24 - 2;
+    cursorY = y * 24 - 2;
+
+    isDirty = true;
+}
+
+void PlatformSoftware::hideCursor()
+{
+    if (cursorX != -1) {
+        cursorX = -1;
+
+        isDirty = true;
+    }
+}
+
+void PlatformSoftware::setCursorShape(CursorShape shape)
+{
+    cursorShape = shape;
+}
+
+void PlatformSoftware::copyRect(uint16_t sourceX, uint16_t sourceY, uint16_t destinationX, uint16_t destinationY, uint16_t width, uint16_t height)
+{
+    // Rows are copied in the order that leaves overlapping rectangles intact
+    if (destinationY <= sourceY) {
+        for (int y = 0; y < height; y++) {
+            memmove(screen + (destinationY + y) * PLATFORM_SCREEN_WIDTH + destinationX, screen + (sourceY + y) * PLATFORM_SCREEN_WIDTH + sourceX, width * sizeof(uint32_t));
+        }
+    } else {
+        for (int y = height - 1; y >= 0; y--) {
+            memmove(screen + (destinationY + y) * PLATFORM_SCREEN_WIDTH + destinationX, screen + (sourceY + y) * PLATFORM_SCREEN_WIDTH + sourceX, width * sizeof(uint32_t));
+        }
+    }
+
+    isDirty = true;
+}
+
+void PlatformSoftware::clearRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+    scissorTest = false;
+
+    drawRectangle(0xff000000, 0, 0, 0, x, y, width, height, false);
+}
+
+void PlatformSoftware::startFadeScreen(uint16_t color, uint16_t intensity)
+{
+    uint32_t r = (color & 0xf00) >> 8;
+    uint32_t g = (color & 0x0f0) << 4;
+    uint32_t b = (color & 0x00f) << 16;
+    uint32_t bgr = r | g | b;
+    fadeBaseColor = bgr | (bgr << 4);
+    fadeIntensity = intensity;
+
+    isDirty = true;
+}
+
+void PlatformSoftware::fadeScreen(uint16_t intensity, bool immediate)
+{
+    if (fadeIntensity != intensity) {
+        if (immediate) {
+            fadeIntensity = intensity;
+
+            isDirty = true;
+        } else {
+            int16_t fadeDelta = intensity > fadeIntensity ? 1 : -1;
+            do {
+                fadeIntensity += fadeDelta;
+
+                isDirty = true;
+
+                this->renderFrame(true);
+            } while (fadeIntensity != intensity);
+        }
+    }
+}
+
+void PlatformSoftware::stopFadeScreen()
+{
+    fadeIntensity = 15;
+    isDirty = true;
+}
+
+void PlatformSoftware::writeToScreenMemory(address_t address, uint8_t value)
+{
+    drawCharacter(address, value, 0xff55bb77, 0);
+}
+
+void PlatformSoftware::writeToScreenMemory(address_t address, uint8_t value, uint8_t color, uint8_t yOffset)
+{
+    drawCharacter(address, value, palette[color], yOffset);
+}
+
+void PlatformSoftware::drawCharacter(address_t address, uint8_t value, uint32_t abgr, uint8_t yOffset)
+{
+    if (scaleX == 1.0f && (address % SCREEN_WIDTH_IN_CHARACTERS) == (SCREEN_WIDTH_IN_CHARACTERS - 7)) {
+        return;
+    }
+
+    scissorTest = false;
+
+    uint16_t x = (address % SCREEN_WIDTH_IN_CHARACTERS) << 3;
+    uint16_t y = ((address / SCREEN_WIDTH_IN_CHARACTERS) << 3) + yOffset;
+    const Texture* font = &textures[TextureFont];
+    if (value > 127) {
+        value &= 127;
+        drawRectangle(abgr, 0, 0, 0, x, y, 8, 8);
+        drawRectangle(0xff000000, font, (value >> 3) & 0x8, (value << 3) & 0x1ff, x, y, 8, 8);
+    } else {
+        drawRectangle(abgr, font, (value >> 3) & 0x8, (value << 3) & 0x1ff, x, y, 8, 8, false);
+    }
+}
+
+void PlatformSoftware::renderFrame(bool waitForNextFrame)
+{
+    if (isDirty) {
+        presentFrame();
+    }
+    PlatformHeadless::renderFrame(waitForNextFrame);
+}
+
+void PlatformSoftware::setFrameHandler(void (*frameHandler)(void* context, uint32_t frame), void* context)
+{
+    this->frameHandler = frameHandler;
+    this->frameContext = context;
+}
+
+// Copies the screen to the frame with the cursor and the fade on top
+void PlatformSoftware::presentFrame()
+{
+    int pixels = PLATFORM_SCREEN_WIDTH * PLATFORM_SCREEN_HEIGHT;
+    int i = 0;
+#ifdef __SSE2__
+    __m128i opaque = _mm_set1_epi32(0xff000000);
+    for (; i + 4 <= pixels; i += 4) {
+        _mm_storeu_si128((__m128i*)(frame_ + i), _mm_or_si128(_mm_loadu_si128((const __m128i*)(screen + i)), opaque));
+    }
+#endif
+    for (; i < pixels; i++) {
+        frame_[i] = screen[i] | 0xff000000;
+    }
+
+    setTarget(frame_, PLATFORM_SCREEN_WIDTH, PLATFORM_SCREEN_HEIGHT);
+    scissorTest = false;
+
+    if (cursorX != -1) {
+        drawRectangle(0xffffffff, 0, 0, 0, cursorX, cursorY, 28, 2);
+        drawRectangle(0xffffffff, 0, 0, 0, cursorX, cursorY + 2, 2, 24);
+        drawRectangle(0xffffffff, 0, 0, 0, cursorX + 26, cursorY + 2, 2, 24);
+        drawRectangle(0xffffffff, 0, 0, 0, cursorX, cursorY + 26, 28, 2);
+        if (cursorShape != ShapeUse) {
+            renderSprite(cursorShape == ShapeSearch ? 83 : 85, cursorX + 2, cursorY + 2);
+        }
+    }
+
+    if (fadeIntensity != 15) {
+        uint32_t intensity = (15 - fadeIntensity) << 24;
+        uint32_t abgr = intensity | (intensity << 4) | fadeBaseColor;
+        drawRectangle(abgr, 0, 0, 0, 0, 0, PLATFORM_SCREEN_WIDTH, PLATFORM_SCREEN_HEIGHT);
+    }
+
+    setTarget(screen, PLATFORM_SCREEN_WIDTH, PLATFORM_SCREEN_HEIGHT);
+    isDirty = false;
+    presentedFrames_++;
+
+    if (frameHandler) {
+        (*frameHandler)(frameContext, presentedFrames_);
+    }
+}
+
+const uint32_t* PlatformSoftware::frame() const
+{
+    return frame_;
+}
+
+uint32_t PlatformSoftware::presentedFrames() const
+{
+    return presentedFrames_;
+}
+
+bool PlatformSoftware::saveFrame(const char* filename) const
+{
+    return savePNG(filename, frame_, PLATFORM_SCREEN_WIDTH, PLATFORM_SCREEN_HEIGHT);
+}
+
+// Reads a PNG file as 0xAABBGGRR pixels, which the caller deletes
+bool PlatformSoftware::loadPNG(const char* filename, uint32_t*& pixels, uint16_t& width, uint16_t& height)
+{
+    png_image image;
+    memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_file(&image, filename)) {
+        return false;
+    }
+    image.format = PNG_FORMAT_RGBA;
+    pixels = new uint32_t[image.width * image.height];
+    width = image.width;
+    height = image.height;
+    if (!png_image_finish_read(&image, 0, pixels, 0, 0)) {
+        delete[] pixels;
+        pixels = 0;
+        return false;
+    }
+    return true;
+}
+
+bool PlatformSoftware::savePNG(const char* filename, const uint32_t* pixels, uint16_t width, uint16_t height)
+{
+    png_image image;
+    memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    image.width = width;
+    image.height = height;
+    image.format = PNG_FORMAT_RGBA;
+    return png_image_write_to_file(&image, filename, 0, pixels, 0, 0) != 0;
+}
@@ -0,0 +1,108 @@
+#ifndef _PLATFORMSOFTWARE_H
+#define _PLATFORMSOFTWARE_H
+
+#include "PlatformHeadless.h"
+
+// Draws what the PSP draws into an RGBA frame buffer in memory, from
+// the images the PSP textures are converted from, for looking at and
+// timing the rendering without a PSP. As on the PSP, renderFrame
+// presents a frame when something has been drawn since the last one.
+// The pixels are 0xAABBGGRR like the PSP colors.
+class PlatformSoftware : public PlatformHeadless {
+public:
+    PlatformSoftware(const char* dataPath = ".");
+    virtual ~PlatformSoftware();
+
+    virtual void displayImage(Image image);
+    virtual void renderTile(uint8_t tile, uint16_t x, uint16_t y, uint8_t variant = 0, bool transparent = false);
+    virtual void renderTiles(uint8_t backgroundTile, uint8_t foregroundTile, uint16_t x, uint16_t y, uint8_t backgroundVariant, uint8_t foregroundVariant);
+    virtual uint8_t backgroundPages(uint16_t width, uint16_t height);
+    virtual void beginPage(uint8_t page);
+    virtual void endPage(uint8_t page);
+    virtual void renderPage(uint8_t page, uint16_t sourceX, uint16_t sourceY, uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+    virtual void renderItem(uint8_t item, uint16_t x, uint16_t y);
+    virtual void renderKey(uint8_t key, uint16_t x, uint16_t y);
+    virtual void renderHealth(uint8_t health, uint16_t x, uint16_t y);
+    virtual void renderFace(uint8_t face, uint16_t x, uint16_t y);
+    virtual void renderLiveMap(uint8_t* map);
+    virtual void renderLiveMapTile(uint8_t* map, uint8_t x, uint8_t y);
+    virtual void renderLiveMapUnits(uint8_t* map, uint8_t* unitTypes, uint8_t* unitX, uint8_t* unitY, uint8_t robotCount, uint8_t unitCount, uint8_t playerColor, bool showRobots);
+    virtual void showCursor(uint16_t x, uint16_t y);
+    virtual void hideCursor();
+    virtual void setCursorShape(CursorShape shape);
+    virtual void copyRect(uint16_t sourceX, uint16_t sourceY, uint16_t destinationX, uint16_t destinationY, uint16_t width, uint16_t height);
+    virtual void clearRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+    virtual void startFadeScreen(uint16_t color, uint16_t intensity);
+    virtual void fadeScreen(uint16_t intensity, bool immediate);
+    virtual void stopFadeScreen();
+    virtual void writeToScreenMemory(address_t address, uint8_t value);
+    virtual void writeToScreenMemory(address_t address, uint8_t value, uint8_t color, uint8_t yOffset);
+    virtual void renderFrame(bool waitForNextFrame);
+
+    void setFrameHandler(void (*frameHandler)(void* context, uint32_t frame), void* context);
+    void presentFrame();
+    const uint32_t* frame() const;
+    uint32_t presentedFrames() const;
+    bool saveFrame(const char* filename) const;
+    static bool loadPNG(const char* filename, uint32_t*& pixels, uint16_t& width, uint16_t& height);
+    static bool savePNG(const char* filename, const uint32_t* pixels, uint16_t width, uint16_t height);
+
+private:
+    enum TextureName {
+        TextureTiles,
+        TextureSprites,
+        TextureAnimTiles,
+        TextureFont,
+        TextureHealth,
+        TextureItems,
+        TextureKeys,
+        TextureFaces,
+        TextureIntroScreen,
+        TextureGameScreen,
+        TextureGameOver,
+        TextureCount
+    };
+
+    struct Texture {
+        uint32_t* pixels;
+        uint16_t width;
+        uint16_t height;
+    };
+
+    void loadTexture(TextureName name, const char* filename);
+    void drawRectangle(uint32_t color, const Texture* texture, uint16_t tx, uint16_t ty, uint16_t x, uint16_t y, uint16_t width, uint16_t height, bool blend = true);
+    void drawCharacter(address_t address, uint8_t value, uint32_t abgr, uint8_t yOffset);
+    void renderSprite(uint8_t sprite, uint16_t x, uint16_t y);
+    void renderAnimTile(uint8_t animTile, uint16_t x, uint16_t y);
+    void setTarget(uint32_t* pixels, uint16_t width, uint16_t height);
+
+    Texture textures[TextureCount];
+    uint32_t liveMapDots[256][9]; // The 3x3 pixels each tile is filtered down to on the live map
+    Texture* pages;
+    uint8_t pageCount;
+    uint32_t* screen; // What is drawn, like the third frame buffer of the PSP
+    uint32_t* frame_; // What was last presented
+    uint32_t* target; // Where is drawn, the screen or a page
+    uint16_t targetWidth;
+    uint16_t targetHeight;
+    bool scissorTest;
+    uint16_t scissorWidth;
+    uint16_t scissorHeight;
+    const uint32_t* palette;
+    float scaleX;
+    float scaleY;
+    int16_t cursorX;
+    int16_t cursorY;
+    CursorShape cursorShape;
+    uint32_t fadeBaseColor;
+    uint16_t fadeIntensity;
+    bool isDirty;
+    uint32_t presentedFrames_;
+    void (*frameHandler)(void* context, uint32_t frame);
+    void* frameContext;
+    uint8_t unitTypes[256];
+    uint8_t unitX[256];
+    uint8_t unitY[256];
+};
+
+#endif
@@ -0,0 +1,444 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+#include "../PlatformSoftware.h"
+#include "../PlatformCapture.h"
+#include "../petrobots.h"
+
+// Plays a scene, a map with an idle or scripted player for a number of
+// ticks, with the software renderer. The frames shown at the chosen
+// ticks are saved as PNG files and can be compared with golden images
+// saved earlier, and the drawing of the final screen can be timed.
+// What is drawn can also be recorded into a capture, which can then be
+// replayed without the game or listed as text.
+
+#define MAX_SCRIPT_STEPS 4096
+#define MAX_CAPTURES 64
+
+// Configuration
+static const char* dataPath = "..";
+static const char* outputPath = ".";
+static const char* goldenPath = 0;
+static uint8_t map = 0;
+static uint8_t difficulty = 1;
+static uint32_t maxTicks = 600;
+static uint32_t captureTicks[MAX_CAPTURES];
+static int captures = 0;
+static bool saveEveryFrame = false;
+static uint32_t scriptTicks[MAX_SCRIPT_STEPS];
+static uint16_t scriptInput[MAX_SCRIPT_STEPS];
+static int scriptSteps = 0;
+static const char* recordPath = 0;
+
+// State of the scene
+static PlatformSoftware* software;
+static int scriptStep = 0;
+static uint32_t inputTicksLeft = 0;
+static uint16_t input = 0;
+static int mismatches = 0;
+
+static uint64_t nanoseconds()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+static bool loadScript(const char* filename)
+{
+    FILE* file = fopen(filename, "r");
+    if (!file) {
+        return false;
+    }
+    // Each line is a tick count and a joystick mask, as for the simulator
+    unsigned long ticks;
+    long mask;
+    while (scriptSteps < MAX_SCRIPT_STEPS && fscanf(file, "%lu %li", &ticks, &mask) == 2) {
+        scriptTicks[scriptSteps] = ticks;
+        scriptInput[scriptSteps] = mask;
+        scriptSteps++;
+    }
+    fclose(file);
+    return true;
+}
+
+static bool parseCaptures(const char* list)
+{
+    while (*list && captures < MAX_CAPTURES) {
+        char* end;
+        captureTicks[captures++] = strtoul(list, &end, 10);
+        if (end == list || (*end != ',' && *end != 0)) {
+            return false;
+        }
+        list = *end ? end + 1 : end;
+    }
+    return true;
+}
+
+// Compares the frame with the golden image of the same name, counting
+// the pixels that differ in color
+static bool compareFrame(const char* name, const uint32_t* frame)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", goldenPath, name);
+    uint32_t* golden;
+    uint16_t width, height;
+    if (!PlatformSoftware::loadPNG(path, golden, width, height)) {
+        printf("%s: no golden image\n", name);
+        return false;
+    }
+    if (width != PLATFORM_SCREEN_WIDTH || height != PLATFORM_SCREEN_HEIGHT) {
+        printf("%s: golden image is %dx%d\n", name, width, height);
+        delete[] golden;
+        return false;
+    }
+
+    int different = 0;
+    int firstX = -1, firstY = -1;
+    for (int i = 0; i < PLATFORM_SCREEN_WIDTH * PLATFORM_SCREEN_HEIGHT; i++) {
+        if (((frame[i] ^ golden[i]) & 0xffffff) != 0) {
+            if (different++ == 0) {
+                firstX = i % PLATFORM_SCREEN_WIDTH;
+                firstY = i / PLATFORM_SCREEN_WIDTH;
+            }
+        }
+    }
+    delete[] golden;
+    if (different != 0) {
+        printf("%s: %d pixels differ, the first at %d,%d\n", name, different, firstX, firstY);
+        return false;
+    }
+    printf("%s: same\n", name);
+    return true;
+}
+
+static void saveFrame(const char* name)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", outputPath, name);
+    if (!software->saveFrame(path)) {
+        fprintf(stderr, "Couldn't write %s\n", path);
+    }
+}
+
+static uint16_t inputHandler(void* context, uint32_t tick)
+{
+    if (inputTicksLeft == 0) {
+        if (scriptStep < scriptSteps) {
+            input = scriptInput[scriptStep];
+            inputTicksLeft = scriptTicks[scriptStep];
+            scriptStep++;
+        } else {
+            input = 0;
+            inputTicksLeft = maxTicks;
+        }
+    }
+    inputTicksLeft--;
+    return input;
+}
+
+static void captureFrame(uint32_t tick)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%c-%06lu.png", map + 'A', (unsigned long)tick);
+    if (goldenPath) {
+        mismatches += !compareFrame(name, software->frame());
+    } else {
+        saveFrame(name);
+    }
+}
+
+static void tickHandler(void* context, uint32_t tick)
+{
+    for (int i = 0; i < captures; i++) {
+        if (captureTicks[i] == tick) {
+            captureFrame(tick);
+        }
+    }
+    if (tick >= maxTicks) {
+        software->quit = true;
+    }
+}
+
+static void frameHandler(void* context, uint32_t frame)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%c-frame-%06lu.png", map + 'A', (unsigned long)frame);
+    saveFrame(name);
+}
+
+// Redraws the map window from tiles, then from background pages, and
+// the live map, presenting each time
+static void benchmark(Game* game, int frames)
+{
+    uint8_t pageCount = game->PAGE_COUNT;
+    const char* names[] = { "map window from tiles", "map window from pages", "live map" };
+    printf("\nredraw                       frames/s\n");
+    for (int test = 0; test < 3; test++) {
+        game->PAGE_COUNT = test == 0 ? 0 : pageCount;
+        uint64_t start = nanoseconds();
+        for (int frame = 0; frame < frames; frame++) {
+            if (test < 2) {
+                game->INVALIDATE_PREVIOUS_MAP();
+                game->DRAW_MAP_WINDOW();
+            } else {
+                software->renderLiveMap(game->MAP);
+            }
+            software->presentFrame();
+        }
+        double seconds = (nanoseconds() - start) / 1e9;
+        printf("%-24s %13.0f\n", names[test], frames / seconds);
+    }
+    game->PAGE_COUNT = pageCount;
+}
+
+static uint8_t* loadCapture(const char* filename, uint32_t& size)
+{
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t* data = new uint8_t[size];
+    if (fread(data, 1, size, file) != size || !PlatformCapture::isValid(data, size)) {
+        delete[] data;
+        data = 0;
+    }
+    fclose(file);
+    return data;
+}
+
+// Prints the commands of a capture one to a line, each after the tick
+// it belongs to, so that the captures of two builds can be compared
+// with diff
+static bool listCapture(const char* filename)
+{
+    uint32_t size;
+    uint8_t* data = loadCapture(filename, size);
+    if (!data) {
+        return false;
+    }
+    uint32_t tick = 0;
+    uint32_t offset = CAPTURE_HEADER_SIZE;
+    char text[4096];
+    while (offset < size) {
+        uint32_t next = PlatformCapture::describe(data, size, offset, text, sizeof(text));
+        if (next == 0) {
+            printf("%lu invalid command at %lu\n", (unsigned long)tick, (unsigned long)offset);
+            break;
+        }
+        printf("%lu %s\n", (unsigned long)tick, text);
+        if (data[offset] == PlatformCapture::CommandFrame && data[offset + 1] != 0) {
+            tick++;
+        }
+        offset = next;
+    }
+    delete[] data;
+    return true;
+}
+
+// Replays a capture, saving or comparing the frames at the chosen ticks
+// as when it was recorded, and times replaying it again this many times.
+// Unless given, the ticks to play are all of the capture, the frame
+// captured by default is the last one, and the frames are named after
+// the level the capture was recorded on.
+static bool replayCapture(const char* filename, bool mapGiven, bool ticksGiven, int repeats)
+{
+    uint32_t size;
+    uint8_t* data = loadCapture(filename, size);
+    if (!data) {
+        return false;
+    }
+    char level = PlatformCapture::level(data);
+    if (!mapGiven && level >= 'A' && level <= 'N') {
+        map = level - 'A';
+    }
+    if (!ticksGiven) {
+        maxTicks = 0xffffffff;
+    }
+    if (captures == 0 && ticksGiven) {
+        captureTicks[captures++] = maxTicks;
+    }
+
+    PlatformSoftware platformInstance(dataPath);
+    software = &platformInstance;
+    platformInstance.setTickHandler(tickHandler, 0);
+    if (saveEveryFrame) {
+        platformInstance.setFrameHandler(frameHandler, 0);
+    }
+
+    uint64_t start = nanoseconds();
+    PlatformCapture::replay(&platformInstance, data, size);
+    double seconds = (nanoseconds() - start) / 1e9;
+    printf("%lu ticks and %lu frames replayed in %.2f s, %.0f frames per second\n", (unsigned long)platformInstance.ticks(),
+           (unsigned long)platformInstance.presentedFrames(), seconds, platformInstance.presentedFrames() / seconds);
+    if (captures == 0) {
+        captureFrame(platformInstance.ticks());
+    }
+
+    if (repeats > 0) {
+        platformInstance.quit = false;
+        platformInstance.setTickHandler(0, 0);
+        platformInstance.setFrameHandler(0, 0);
+        uint32_t presentedFrames = platformInstance.presentedFrames();
+        start = nanoseconds();
+        for (int i = 0; i < repeats; i++) {
+            PlatformCapture::replay(&platformInstance, data, size);
+        }
+        seconds = (nanoseconds() - start) / 1e9;
+        presentedFrames = platformInstance.presentedFrames() - presentedFrames;
+        printf("%lu frames replayed %d times in %.2f s, %.0f frames per second\n", (unsigned long)(presentedFrames / repeats),
+               repeats, seconds, presentedFrames / seconds);
+    }
+
+    delete[] data;
+    return true;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "Usage: %s [options]\n", name);
+    fprintf(stderr, "  -d path     data directory containing tileset.amiga, PSP/level-* and PSP/*.png (default ..)\n");
+    fprintf(stderr, "  -m map      map to play (default A)\n");
+    fprintf(stderr, "  -l level    difficulty 0-2 (default 1)\n");
+    fprintf(stderr, "  -p script   script file to play, as for the simulator (default idle)\n");
+    fprintf(stderr, "  -t ticks    ticks to play (default 600)\n");
+    fprintf(stderr, "  -c ticks    ticks to capture the frame at, for example 60,300 (default the last)\n");
+    fprintf(stderr, "  -o path     directory to write the frames to (default .)\n");
+    fprintf(stderr, "  -g path     compare the frames with the golden images in the directory instead\n");
+    fprintf(stderr, "  -e          write every frame presented\n");
+    fprintf(stderr, "  -b frames   time redrawing the final screen this many times\n");
+    fprintf(stderr, "  -r file     record what is drawn into a capture\n");
+    fprintf(stderr, "  -R file     replay a capture instead of playing, all of it unless -t is given, naming the frames after its map unless -m is given, with -b the times to replay it again for timing\n");
+    fprintf(stderr, "  -L file     list the commands of a capture\n");
+}
+
+int main(int argc, char *argv[])
+{
+    int benchmarkFrames = 0;
+    const char* replayPath = 0;
+    bool mapGiven = false;
+    bool ticksGiven = false;
+
+    int option;
+    while ((option = getopt(argc, argv, "d:m:l:p:t:c:o:g:eb:r:R:L:h")) != -1) {
+        switch (option) {
+        case 'd':
+            dataPath = optarg;
+            break;
+        case 'm':
+            if (optarg[0] < 'A' || optarg[0] > 'N') {
+                fprintf(stderr, "Unknown map %c\n", optarg[0]);
+                return 1;
+            }
+            map = optarg[0] - 'A';
+            mapGiven = true;
+            break;
+        case 'l':
+            difficulty = atoi(optarg);
+            break;
+        case 'p':
+            if (!loadScript(optarg)) {
+                fprintf(stderr, "Couldn't read script %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 't':
+            maxTicks = strtoul(optarg, 0, 10);
+            ticksGiven = true;
+            break;
+        case 'c':
+            if (!parseCaptures(optarg)) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'o':
+            outputPath = optarg;
+            break;
+        case 'g':
+            goldenPath = optarg;
+            break;
+        case 'e':
+            saveEveryFrame = true;
+            break;
+        case 'b':
+            benchmarkFrames = atoi(optarg);
+            break;
+        case 'r':
+            recordPath = optarg;
+            break;
+        case 'R':
+            replayPath = optarg;
+            break;
+        case 'L':
+            if (!listCapture(optarg)) {
+                fprintf(stderr, "Couldn't read capture %s\n", optarg);
+                return 1;
+            }
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (difficulty > 2 || maxTicks == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (replayPath) {
+        if (!replayCapture(replayPath, mapGiven, ticksGiven, benchmarkFrames)) {
+            fprintf(stderr, "Couldn't read capture %s\n", replayPath);
+            return 1;
+        }
+        return mismatches != 0 ? 1 : 0;
+    }
+    if (captures == 0) {
+        captureTicks[captures++] = maxTicks;
+    }
+
+    PlatformSoftware platformInstance(dataPath);
+    software = &platformInstance;
+    PlatformCapture* capture = recordPath ? new PlatformCapture(&platformInstance) : 0;
+    Game* game = new Game(capture ? (Platform*)capture : &platformInstance);
+    platformInstance.setInputHandler(inputHandler, 0);
+    platformInstance.setTickHandler(tickHandler, 0);
+    if (saveEveryFrame) {
+        platformInstance.setFrameHandler(frameHandler, 0);
+    }
+
+    game->INITIALIZE();
+    game->CONTROL = 2;
+    game->MUSIC_ON = 0;
+    game->DIFF_LEVEL = difficulty;
+    game->SELECTED_MAP = map;
+    game->MAPNAME[6] = game->SELECTED_MAP + 65;
+
+    uint64_t start = nanoseconds();
+    game->INIT_GAME();
+    double seconds = (nanoseconds() - start) / 1e9;
+    printf("%lu ticks and %lu frames in %.2f s, %.0f frames per second\n", (unsigned long)platformInstance.ticks(),
+           (unsigned long)platformInstance.presentedFrames(), seconds, platformInstance.presentedFrames() / seconds);
+
+    if (capture) {
+        if (capture->isFull()) {
+            printf("The capture is full after %lu ticks\n", (unsigned long)capture->frames());
+        }
+        if (!capture->writeCapture(recordPath)) {
+            fprintf(stderr, "Couldn't write %s\n", recordPath);
+        }
+    }
+
+    if (benchmarkFrames > 0) {
+        platformInstance.setFrameHandler(0, 0);
+        benchmark(game, benchmarkFrames);
+    }
+
+    delete game;
+    delete capture;
+    return mismatches != 0 ? 1 : 0;
+}
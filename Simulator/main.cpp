@@ -0,0 +1,584 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "../PlatformHeadless.h"
+#include "../petrobots.h"
+
+// Runs games with a scripted or random player on all maps. Every
+// worker thread runs one game at a time with its own Game and
+// PlatformHeadless instance.
+
+#define MAX_SCRIPT_STEPS 4096
+#define CHECKPOINT_INTERVAL 256
+#define CHECKPOINTS 64
+
+enum Policy {
+    PolicyIdle,
+    PolicyRandom,
+    PolicyScript
+};
+
+enum Outcome {
+    OutcomeCrash,
+    OutcomeWin,
+    OutcomeLoss,
+    OutcomeTimeout
+};
+
+struct Job {
+    uint8_t map;
+    uint32_t seed;
+};
+
+struct Result {
+    uint8_t outcome;
+    uint32_t ticks;
+    uint32_t robotsAtStart;
+    uint32_t robotsLeft;
+    uint64_t hash;
+    uint64_t checkpoints[CHECKPOINTS];
+    uint64_t elapsed;
+    uint32_t pageHits;
+    uint32_t pageMisses;
+    uint32_t pageRebuilds;
+    uint64_t profileTime[PROFILE_ROUTINES];
+    uint32_t profileCalls[PROFILE_ROUTINES];
+};
+
+static const char* routineNames[PROFILE_ROUTINES] = {
+    "DUMMY_ROUTINE",
+    "DUMMY_ROUTINE (player)",
+    "LEFT_RIGHT_DROID",
+    "UP_DOWN_DROID",
+    "HOVER_ATTACK",
+    "WATER_DROID",
+    "TIME_BOMB",
+    "TRANSPORTER_PAD",
+    "DEAD_ROBOT",
+    "EVILBOT",
+    "AI_DOOR",
+    "SMALL_EXPLOSION",
+    "PISTOL_FIRE_UP",
+    "PISTOL_FIRE_DOWN",
+    "PISTOL_FIRE_LEFT",
+    "PISTOL_FIRE_RIGHT",
+    "TRASH_COMPACTOR",
+    "UP_DOWN_ROLLERBOT",
+    "LEFT_RIGHT_ROLLERBOT",
+    "ELEVATOR",
+    "MAGNET",
+    "MAGNETIZED_ROBOT",
+    "WATER_RAFT_LR",
+    "DEMATERIALIZE",
+    "DRAW_MAP_WINDOW",
+    "REWIND_RECORD",
+    "CHASE_FIELD"
+};
+
+// Configuration, shared by all instances
+static const char* dataPath = "..";
+static Policy policy = PolicyRandom;
+static uint32_t maxTicks = 60 * 60 * 10;
+static uint8_t difficulty = 1;
+static uint32_t scriptTicks[MAX_SCRIPT_STEPS];
+static uint16_t scriptInput[MAX_SCRIPT_STEPS];
+static int scriptSteps = 0;
+
+// State of one running game
+struct Instance {
+    PlatformHeadless* headless;
+    Game* game;
+    Result* result;
+    uint32_t randomState;
+    uint32_t inputTicksLeft;
+    uint16_t input;
+    int scriptStep;
+    bool gameStarted;
+    uint8_t stateBuffer[GAME_STATE_MAX_SIZE];
+};
+
+static uint64_t nanoseconds()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+static uint32_t nextRandom(Instance& instance)
+{
+    // xorshift32
+    uint32_t& state = instance.randomState;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static uint64_t hashGameState(Instance& instance)
+{
+    uint32_t size = instance.game->SAVE_GAME_STATE(instance.stateBuffer);
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (uint32_t i = 0; i < size; i++) {
+        hash = (hash ^ instance.stateBuffer[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static uint32_t countRobots(Game* game)
+{
+    uint32_t robots = 0;
+    for (int X = UNIT_ROBOTS; X != UNIT_WEAPONS; X++) {
+        if (game->UNIT_TYPE[X] != 0) {
+            robots++;
+        }
+    }
+    return robots;
+}
+
+// Never presses SELECT so that the game can't be paused, saved or rewound
+static uint16_t randomInput(Instance& instance)
+{
+    static const uint16_t choices[] = {
+        Platform::JoystickUp,
+        Platform::JoystickDown,
+        Platform::JoystickLeft,
+        Platform::JoystickRight,
+        Platform::JoystickUp,
+        Platform::JoystickDown,
+        Platform::JoystickLeft,
+        Platform::JoystickRight,
+        Platform::JoystickGreen,
+        Platform::JoystickBlue,
+        Platform::JoystickYellow,
+        Platform::JoystickRed,
+        Platform::JoystickReverse,
+        Platform::JoystickForward,
+        Platform::JoystickExtra,
+        0
+    };
+    return choices[nextRandom(instance) % (sizeof(choices) / sizeof(choices[0]))];
+}
+
+static uint16_t inputHandler(void* context, uint32_t tick)
+{
+    Instance& instance = *(Instance*)context;
+    if (instance.inputTicksLeft == 0) {
+        switch (policy) {
+        case PolicyRandom:
+            instance.input = randomInput(instance);
+            instance.inputTicksLeft = 5 + nextRandom(instance) % 30;
+            break;
+        case PolicyScript:
+            if (instance.scriptStep < scriptSteps) {
+                instance.input = scriptInput[instance.scriptStep];
+                instance.inputTicksLeft = scriptTicks[instance.scriptStep];
+                instance.scriptStep++;
+            } else {
+                instance.input = 0;
+                instance.inputTicksLeft = maxTicks;
+            }
+            break;
+        default:
+            instance.input = 0;
+            instance.inputTicksLeft = maxTicks;
+            break;
+        }
+    }
+    instance.inputTicksLeft--;
+    return instance.input;
+}
+
+static void tickHandler(void* context, uint32_t tick)
+{
+    Instance& instance = *(Instance*)context;
+    Game* game = instance.game;
+    if (game->CLOCK_ACTIVE == 1 && !instance.gameStarted) {
+        instance.gameStarted = true;
+        instance.result->robotsAtStart = countRobots(game);
+    }
+    if (tick % CHECKPOINT_INTERVAL == 0 && tick / CHECKPOINT_INTERVAL <= CHECKPOINTS) {
+        instance.result->checkpoints[tick / CHECKPOINT_INTERVAL - 1] = hashGameState(instance);
+    }
+    if (instance.gameStarted && game->CLOCK_ACTIVE == 0 && game->UNIT_TYPE[0] != 1) {
+        // Game over screen reached
+        instance.headless->quit = true;
+    }
+    if (tick >= maxTicks) {
+        instance.headless->quit = true;
+    }
+}
+
+static void runJob(const Job& job, Result* result)
+{
+    PlatformHeadless platformInstance(dataPath);
+    Game* game = new Game(&platformInstance);
+    Instance* instance = new Instance();
+    instance->headless = &platformInstance;
+    instance->game = game;
+    instance->result = result;
+    instance->randomState = job.seed != 0 ? job.seed : 1;
+    platformInstance.setInputHandler(inputHandler, instance);
+    platformInstance.setTickHandler(tickHandler, instance);
+
+    game->INITIALIZE();
+    game->CONTROL = 2;
+    game->MUSIC_ON = 0;
+    game->DIFF_LEVEL = difficulty;
+    game->SELECTED_MAP = job.map;
+    game->MAPNAME[6] = game->SELECTED_MAP + 65;
+
+    uint64_t start = nanoseconds();
+    game->INIT_GAME();
+    result->elapsed = nanoseconds() - start;
+
+    result->ticks = platformInstance.ticks();
+    result->robotsLeft = countRobots(game);
+    result->hash = hashGameState(*instance);
+    if (game->UNIT_TYPE[0] == 1) {
+        result->outcome = OutcomeTimeout;
+    } else if (game->UNIT_TYPE[0] == 0) {
+        result->outcome = OutcomeLoss;
+    } else {
+        result->outcome = OutcomeWin;
+    }
+    result->pageHits = game->PAGE_HITS;
+    result->pageMisses = game->PAGE_MISSES;
+    result->pageRebuilds = game->PAGE_REBUILDS;
+    for (int i = 0; i < PROFILE_ROUTINES; i++) {
+        result->profileTime[i] = platformInstance.profileTime(i);
+        result->profileCalls[i] = platformInstance.profileCalls(i);
+    }
+
+    delete instance;
+    delete game;
+}
+
+// Fills the whole map with rooms and times looking tiles up the way
+// the game does, for comparing map sizes and layouts
+static void benchmarkMap()
+{
+    PlatformHeadless platformInstance(dataPath);
+    Game* game = new Game(&platformInstance);
+    game->TILE_LOAD_ROUTINE();
+    uint32_t random = 1;
+    for (uint32_t y = 0; y != PLATFORM_MAP_HEIGHT; y++) {
+        for (uint32_t x = 0; x != PLATFORM_MAP_WIDTH; x++) {
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            uint8_t tile = 9; // floor
+            if ((x & 15) == 0 || (y & 15) == 0) {
+                tile = ((x + y) & 15) == 8 ? 9 : 204; // walls with doorways
+            } else if (random % 16 == 0) {
+                tile = random >> 24;
+            }
+            game->MAP[MAP_CELL(x, y)] = tile;
+        }
+    }
+
+    enum { WindowPositions = 20000, Walks = 2000000, Lookups = 2000000, Builds = 20 };
+    uint32_t sum = 0;
+
+    // Every tile in the map window at random window positions
+    uint64_t start = nanoseconds();
+    for (int i = 0; i != WindowPositions; i++) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        uint32_t windowX = (random & 0xffff) % (PLATFORM_MAP_WIDTH - PLATFORM_MAP_WINDOW_TILES_WIDTH);
+        uint32_t windowY = (random >> 16) % (PLATFORM_MAP_HEIGHT - PLATFORM_MAP_WINDOW_TILES_HEIGHT);
+        for (uint32_t y = 0; y != PLATFORM_MAP_WINDOW_TILES_HEIGHT; y++) {
+            for (uint32_t x = 0; x != PLATFORM_MAP_WINDOW_TILES_WIDTH; x++) {
+                sum += game->MAP[MAP_CELL(windowX + x, windowY + y)];
+            }
+        }
+    }
+    double windowTime = (double)(nanoseconds() - start) / (WindowPositions * MAP_WINDOW_SIZE);
+
+    // The four tiles next to a unit that wanders one step at a time
+    uint32_t unitX = PLATFORM_MAP_WIDTH / 2;
+    uint32_t unitY = PLATFORM_MAP_HEIGHT / 2;
+    start = nanoseconds();
+    for (int i = 0; i != Walks; i++) {
+        static const int8_t stepX[] = { 0, 0, -1, 1 };
+        static const int8_t stepY[] = { -1, 1, 0, 0 };
+        for (int direction = 0; direction != 4; direction++) {
+            game->MAP_X = unitX + stepX[direction];
+            game->MAP_Y = unitY + stepY[direction];
+            game->GET_TILE_FROM_MAP();
+            sum += game->TILE;
+        }
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        unitX = MIN(MAX(unitX + stepX[random & 3], 1), PLATFORM_MAP_WIDTH - 2);
+        unitY = MIN(MAX(unitY + stepY[random & 3], 1), PLATFORM_MAP_HEIGHT - 2);
+    }
+    double walkTime = (double)(nanoseconds() - start) / (Walks * 4);
+
+    // Single tiles anywhere on the map
+    start = nanoseconds();
+    for (int i = 0; i != Lookups; i++) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        game->MAP_X = (random & 0xffff) % PLATFORM_MAP_WIDTH;
+        game->MAP_Y = (random >> 16) % PLATFORM_MAP_HEIGHT;
+        game->GET_TILE_FROM_MAP();
+        sum += game->TILE;
+    }
+    double lookupTime = (double)(nanoseconds() - start) / Lookups;
+
+    // The attribute planes of the whole map, as after loading a level
+    start = nanoseconds();
+    for (int i = 0; i != Builds; i++) {
+        game->BUILD_MAP_PLANES();
+    }
+    double buildTime = (double)(nanoseconds() - start) / (Builds * PLATFORM_MAP_WIDTH * PLATFORM_MAP_HEIGHT);
+
+#ifdef PLATFORM_MAP_CHUNKS
+    const char* layout = "in 16x16 chunks";
+#else
+    const char* layout = "row by row";
+#endif
+    printf("%dx%d map stored %s\n", PLATFORM_MAP_WIDTH, PLATFORM_MAP_HEIGHT, layout);
+    printf("%u bytes of tiles, %u bytes of attribute planes, %u bytes per game\n\n",
+           (unsigned)MAP_CELLS, (unsigned)sizeof(game->MAP_PLANES), (unsigned)sizeof(Game));
+    printf("lookup                 ns/tile\n");
+    printf("map window           %10.2f\n", windowTime);
+    printf("next to a unit       %10.2f\n", walkTime);
+    printf("anywhere             %10.2f\n", lookupTime);
+    printf("attribute planes     %10.2f\n", buildTime);
+    printf("\n(checksum %u)\n", sum);
+
+    delete game;
+}
+
+static bool loadScript(const char* filename)
+{
+    FILE* file = fopen(filename, "r");
+    if (!file) {
+        return false;
+    }
+    // Each line is a tick count and a joystick mask, for example "30 0x8" walks up for 30 ticks
+    unsigned long ticks;
+    long mask;
+    while (scriptSteps < MAX_SCRIPT_STEPS && fscanf(file, "%lu %li", &ticks, &mask) == 2) {
+        scriptTicks[scriptSteps] = ticks;
+        scriptInput[scriptSteps] = mask;
+        scriptSteps++;
+    }
+    fclose(file);
+    return true;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "Usage: %s [options]\n", name);
+    fprintf(stderr, "  -d path     data directory containing tileset.amiga and PSP/level-* (default ..)\n");
+    fprintf(stderr, "  -m maps     maps to run, for example ABC (default A-N)\n");
+    fprintf(stderr, "  -g games    games per map (default 16)\n");
+    fprintf(stderr, "  -j workers  worker threads (default number of cores)\n");
+    fprintf(stderr, "  -t ticks    maximum ticks per game (default 36000)\n");
+    fprintf(stderr, "  -l level    difficulty 0-2 (default 1)\n");
+    fprintf(stderr, "  -p policy   idle, random or a script file (default random)\n");
+    fprintf(stderr, "  -s seed     first random seed (default 1)\n");
+    fprintf(stderr, "  -v          run every game twice and report state hash divergences\n");
+    fprintf(stderr, "  -b          time map lookups on a synthetic map of the built size instead\n");
+}
+
+int main(int argc, char *argv[])
+{
+    const char* maps = "ABCDEFGHIJKLMN";
+    int gamesPerMap = 16;
+    int workers = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t firstSeed = 1;
+    bool verify = false;
+    bool benchmark = false;
+
+    int option;
+    while ((option = getopt(argc, argv, "d:m:g:j:t:l:p:s:vbh")) != -1) {
+        switch (option) {
+        case 'd':
+            dataPath = optarg;
+            break;
+        case 'm':
+            maps = optarg;
+            break;
+        case 'g':
+            gamesPerMap = atoi(optarg);
+            break;
+        case 'j':
+            workers = atoi(optarg);
+            break;
+        case 't':
+            maxTicks = strtoul(optarg, 0, 10);
+            break;
+        case 'l':
+            difficulty = atoi(optarg);
+            break;
+        case 'p':
+            if (strcmp(optarg, "idle") == 0) {
+                policy = PolicyIdle;
+            } else if (strcmp(optarg, "random") == 0) {
+                policy = PolicyRandom;
+            } else if (loadScript(optarg)) {
+                policy = PolicyScript;
+            } else {
+                fprintf(stderr, "Couldn't read script %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 's':
+            firstSeed = strtoul(optarg, 0, 10);
+            break;
+        case 'v':
+            verify = true;
+            break;
+        case 'b':
+            benchmark = true;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (workers < 1 || gamesPerMap < 1 || difficulty > 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (benchmark) {
+        benchmarkMap();
+        return 0;
+    }
+
+    // Build the job list, with each game twice when verifying
+    int mapCount = strlen(maps);
+    int runs = verify ? 2 : 1;
+    int jobCount = mapCount * gamesPerMap * runs;
+    Job* jobs = new Job[jobCount];
+    for (int i = 0, job = 0; i < mapCount; i++) {
+        if (maps[i] < 'A' || maps[i] > 'N') {
+            fprintf(stderr, "Unknown map %c\n", maps[i]);
+            return 1;
+        }
+        for (int game = 0; game < gamesPerMap; game++) {
+            for (int run = 0; run < runs; run++, job++) {
+                jobs[job].map = maps[i] - 'A';
+                jobs[job].seed = firstSeed + game;
+            }
+        }
+    }
+
+    Result* results = new Result[jobCount];
+    memset(results, 0, jobCount * sizeof(Result));
+
+    // The shared texts are converted before any game is started
+    Game::CONVERT_MESSAGES();
+
+    uint64_t start = nanoseconds();
+    std::atomic<int> next(0);
+    std::vector<std::thread> threads;
+    for (int worker = 0; worker < workers; worker++) {
+        threads.push_back(std::thread([&]() {
+            for (int job = next++; job < jobCount; job = next++) {
+                runJob(jobs[job], &results[job]);
+            }
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    double wallTime = (nanoseconds() - start) / 1e9;
+
+    // Outcomes per map
+    uint64_t totalTicks = 0;
+    uint64_t totalElapsed = 0;
+    printf("map  games  wins  losses  timeouts  avg ticks  robots destroyed\n");
+    for (int i = 0; i < mapCount; i++) {
+        int games = 0, wins = 0, losses = 0, timeouts = 0;
+        uint64_t ticks = 0, destroyed = 0;
+        for (int job = 0; job < jobCount; job++) {
+            Result& r = results[job];
+            if (jobs[job].map != maps[i] - 'A') {
+                continue;
+            }
+            games++;
+            ticks += r.ticks;
+            destroyed += r.robotsAtStart - r.robotsLeft;
+            totalTicks += r.ticks;
+            totalElapsed += r.elapsed;
+            if (r.outcome == OutcomeWin) {
+                wins++;
+            } else if (r.outcome == OutcomeLoss) {
+                losses++;
+            } else {
+                timeouts++;
+            }
+        }
+        printf("  %c  %5d %5d %7d %9d %10.0f %17.1f\n", maps[i], games, wins, losses, timeouts,
+               games ? (double)ticks / games : 0.0, games ? (double)destroyed / games : 0.0);
+    }
+
+    printf("\n%d games, %d workers, %.2f s\n", jobCount, workers, wallTime);
+    printf("%.0f ticks per second in total, %.0f ticks per second per instance\n",
+           totalTicks / wallTime, totalElapsed ? totalTicks / (totalElapsed / 1e9) : 0.0);
+
+    // Background pages the map window was drawn from
+    uint64_t pageHits = 0, pageMisses = 0, pageRebuilds = 0;
+    for (int job = 0; job < jobCount; job++) {
+        pageHits += results[job].pageHits;
+        pageMisses += results[job].pageMisses;
+        pageRebuilds += results[job].pageRebuilds;
+    }
+    uint64_t pageUses = pageHits + pageMisses + pageRebuilds;
+    printf("%d background pages: %.1f%% of %llu uses hit, %llu missed, %llu rebuilt\n", PLATFORM_BACKGROUND_PAGES,
+           pageUses ? pageHits * 100.0 / pageUses : 0.0, (unsigned long long)pageUses,
+           (unsigned long long)pageMisses, (unsigned long long)pageRebuilds);
+
+    // Time spent in each routine over all games
+    printf("\nroutine                       calls       total ms     ns/call\n");
+    for (int routine = 0; routine < PROFILE_ROUTINES; routine++) {
+        uint64_t time = 0;
+        uint64_t calls = 0;
+        for (int job = 0; job < jobCount; job++) {
+            time += results[job].profileTime[routine];
+            calls += results[job].profileCalls[routine];
+        }
+        if (calls != 0) {
+            printf("%-24s %10llu %14.2f %11.1f\n", routineNames[routine], (unsigned long long)calls, time / 1e6, (double)time / calls);
+        }
+    }
+
+    // The game logic is deterministic, so two runs with the same seed must match
+    int divergences = 0;
+    if (verify) {
+        for (int job = 0; job < jobCount; job += 2) {
+            Result& a = results[job];
+            Result& b = results[job + 1];
+            if (a.hash == b.hash) {
+                continue;
+            }
+            divergences++;
+            int checkpoint = 0;
+            while (checkpoint < CHECKPOINTS && a.checkpoints[checkpoint] == b.checkpoints[checkpoint]) {
+                checkpoint++;
+            }
+            if (checkpoint < CHECKPOINTS) {
+                printf("map %c seed %u diverged before tick %d\n", jobs[job].map + 'A', jobs[job].seed, (checkpoint + 1) * CHECKPOINT_INTERVAL);
+            } else {
+                printf("map %c seed %u diverged after tick %d\n", jobs[job].map + 'A', jobs[job].seed, CHECKPOINTS * CHECKPOINT_INTERVAL);
+            }
+        }
+        printf("\n%d state hash divergences\n", divergences);
+    }
+
+    delete[] results;
+    delete[] jobs;
+    return divergences != 0 ? 1 : 0;
+}
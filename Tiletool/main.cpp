@@ -7,6 +7,92 @@
 #include <cmath>
 #include <cstring>
 
+// Set in the first word of the header of a swizzled texture, must match PlatformPSP.cpp
+#define TEXTURE_SWIZZLED 0x80000000
+#define TEXTURE_HEADER_SIZE 16
+
+// The GE reads swizzled textures in blocks of 16 bytes by 8 rows, one
+// block after another, which is a better fit for its texture cache.
+static void swizzle(uchar* output, const uchar* input, int widthInBytes, int height, bool reverse)
+{
+    int blocksPerRow = widthInBytes / 16;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < widthInBytes; x++) {
+            int block = (y / 8) * blocksPerRow + x / 16;
+            int swizzled = block * 16 * 8 + (y % 8) * 16 + x % 16;
+            int linear = y * widthInBytes + x;
+            if (reverse) {
+                output[linear] = input[swizzled];
+            } else {
+                output[swizzled] = input[linear];
+            }
+        }
+    }
+}
+
+static quint32 headerWord(const QByteArray& texture, int index)
+{
+    const uchar* data = (const uchar*)texture.constData() + index * 4;
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((quint32)data[3] << 24);
+}
+
+static void setHeaderWord(QByteArray& texture, int index, quint32 value)
+{
+    for (int i = 0; i < 4; i++) {
+        texture[index * 4 + i] = (char)(value >> (i * 8));
+    }
+}
+
+// Swizzles or unswizzles a 32-bit PSP texture converted by psptextureconverter
+static int swizzleTexture(const QString& inputName, const QString& outputName, bool reverse, QTextStream& standardError)
+{
+    QFile inputFile(inputName);
+    if (!inputFile.open(QIODevice::ReadOnly)) {
+        standardError << QCoreApplication::translate("main", "Couldn't read ") << inputName << "\n";
+        return 1;
+    }
+    QByteArray input = inputFile.readAll();
+    inputFile.close();
+
+    if (input.size() < TEXTURE_HEADER_SIZE) {
+        standardError << QCoreApplication::translate("main", "Not a PSP texture") << "\n";
+        return 1;
+    }
+    quint32 flags = headerWord(input, 0);
+    int widthInBytes = headerWord(input, 2) * 4;
+    int height = headerWord(input, 3);
+    if ((widthInBytes % 16) != 0 || (height % 8) != 0 || input.size() < TEXTURE_HEADER_SIZE + widthInBytes * height) {
+        standardError << QCoreApplication::translate("main", "Not a PSP texture with a buffer of whole blocks") << "\n";
+        return 1;
+    }
+    if (((flags & TEXTURE_SWIZZLED) != 0) != reverse) {
+        standardError << QCoreApplication::translate("main", reverse ? "Not swizzled" : "Already swizzled") << "\n";
+        return 1;
+    }
+
+    QByteArray output = input;
+    swizzle((uchar*)output.data() + TEXTURE_HEADER_SIZE, (const uchar*)input.constData() + TEXTURE_HEADER_SIZE, widthInBytes, height, reverse);
+    setHeaderWord(output, 0, reverse ? flags & ~TEXTURE_SWIZZLED : flags | TEXTURE_SWIZZLED);
+
+    // Make sure it converts back to the same texture
+    QByteArray roundTrip = output;
+    swizzle((uchar*)roundTrip.data() + TEXTURE_HEADER_SIZE, (const uchar*)output.constData() + TEXTURE_HEADER_SIZE, widthInBytes, height, !reverse);
+    setHeaderWord(roundTrip, 0, flags);
+    if (roundTrip != input) {
+        standardError << QCoreApplication::translate("main", "Texture doesn't convert back to the same") << "\n";
+        return 1;
+    }
+
+    QFile outputFile(outputName);
+    if (!outputFile.open(QIODevice::WriteOnly) || outputFile.write(output) != output.size()) {
+        standardError << QCoreApplication::translate("main", "Couldn't write ") << outputName << "\n";
+        return 1;
+    }
+
+    standardError << QCoreApplication::translate("main", reverse ? "Unswizzled " : "Swizzled ") << widthInBytes / 4 << "x" << height << "\n";
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
     QCoreApplication app(argc, argv);
@@ -24,6 +110,8 @@ int main(int argc, char *argv[])
     }
     QCommandLineOption reverseOption(QStringList() << "r" << "reverse", QCoreApplication::translate("main", "Convert back to 16x16."));
     parser.addOption(reverseOption);
+    QCommandLineOption swizzleOption(QStringList() << "s" << "swizzle", QCoreApplication::translate("main", "Swizzle a PSP texture, or unswizzle it with -r."));
+    parser.addOption(swizzleOption);
     parser.addPositionalArgument("input", QCoreApplication::translate("main", "The name of the image to be converted."));
     parser.addPositionalArgument("output", QCoreApplication::translate("main", "The basename of the converted image."));
     parser.process(args);
@@ -37,6 +125,10 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    if (parser.isSet(swizzleOption)) {
+        return swizzleTexture(positionalArguments.at(0), positionalArguments.at(1), reverse, standardError);
+    }
+
     QImage inputImage(positionalArguments.first());
     if (inputImage.colorCount() == 0) {
         standardError << QCoreApplication::translate("main", "Not a paletted image") << "\n";
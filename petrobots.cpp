@@ -6,30 +6,18 @@
  * vesuri@jormas.com
  */
 
+#ifdef PLATFORM_HEADLESS
+#include "PlatformHeadless.h"
+#else
 #include "PlatformPSP.h"
+#endif
+#ifdef PLATFORM_CAPTURE
+#include "PlatformCapture.h"
+#endif
+#include <cstddef>
 #include "petrobots.h"
 
-uint8_t* DESTRUCT_PATH; // Destruct path array (256 bytes)
-uint8_t* TILE_ATTRIB;   // Tile attrib array (256 bytes)
-
-// These arrays can go anywhere in RAM
-uint8_t UNIT_TIMER_A[64];   // Primary timer for units (64 bytes)
-uint8_t UNIT_TIMER_B[64];   // Secondary timer for units (64 bytes)
-uint8_t UNIT_TILE[32];      // Current tile assigned to unit (32 bytes)
-uint8_t UNIT_DIRECTION[32]; // Movement direction of unit (32 bytes)
-uint8_t EXP_BUFFER[16];     // Explosion Buffer (16 bytes)
-uint8_t MAP_PRECALC[MAP_WINDOW_SIZE];    // Stores pre-calculated objects for map window (77 bytes)
-uint8_t MAP_PRECALC_DIRECTION[MAP_WINDOW_SIZE];    // Stores pre-calculated object directions for map window (77 bytes)
-uint8_t MAP_PRECALC_TYPE[MAP_WINDOW_SIZE];    // Stores pre-calculated object types for map window (77 bytes)
-uint8_t PREVIOUS_MAP_BACKGROUND[MAP_WINDOW_SIZE];
-uint8_t PREVIOUS_MAP_BACKGROUND_VARIANT[MAP_WINDOW_SIZE];
-uint8_t PREVIOUS_MAP_FOREGROUND[MAP_WINDOW_SIZE];
-uint8_t PREVIOUS_MAP_FOREGROUND_VARIANT[MAP_WINDOW_SIZE];
-
-// The following are the locations where the current
-// key controls are stored.  These must be set before
-// the game can start.
-uint8_t KEY_CONFIG[26];
+// Indices of the key controls in KEY_CONFIG
 enum KEYS {
     KEY_MOVE_UP,
     KEY_MOVE_DOWN,
@@ -59,46 +47,7 @@ enum KEYS {
     KEY_NO
 };
 
-// MAP FILES CONSIST OF EVERYTHING FROM THIS POINT ON
-uint8_t MAP_DATA[8960];
-uint8_t* UNIT_TYPE = MAP_DATA;
-uint8_t* UNIT_LOC_X = MAP_DATA + 1 * 64;
-uint8_t* UNIT_LOC_Y = MAP_DATA + 2 * 64;
-uint8_t* UNIT_A = MAP_DATA + 3 * 64;
-uint8_t* UNIT_B = MAP_DATA + 4 * 64;
-uint8_t* UNIT_C = MAP_DATA + 5 * 64;
-uint8_t* UNIT_D = MAP_DATA + 6 * 64;
-int8_t* UNIT_HEALTH = (int8_t*)MAP_DATA + 7 * 64;
-uint8_t* MAP = MAP_DATA + 8 * 64 + 256;
-// END OF MAP FILE
-
-uint8_t TILE;           // The tile number to be plotted
-uint8_t DIRECTION;      // The direction of the tile to be plotted
-uint8_t WALK_FRAME;     // Player walking animation frame
-uint8_t DEMATERIALIZE_FRAME; // Dematerialize animation frame
-uint8_t MAP_X;          // Current X location on map
-uint8_t MAP_Y;          // Current Y location on map
-uint8_t MAP_WINDOW_X;   // Top left location of what is displayed in map window
-uint8_t MAP_WINDOW_Y;   // Top left location of what is displayed in map window
-uint8_t DECNUM;         // a decimal number to be displayed onscreen as 3 digits.
-uint8_t ATTRIB;         // Tile attribute value
-uint8_t UNIT;           // Current unit being processed
-uint8_t TEMP_A;         // used within some routines
-uint8_t TEMP_B;         // used within some routines
-uint8_t TEMP_C;         // used within some routines
-uint8_t TEMP_D;         // used within some routines
-uint8_t CURSOR_X;       // For on-screen cursor
-uint8_t CURSOR_Y;       // For on-screen cursor
-uint8_t CURSOR_ON;      // Is cursor active or not? 1=yes 0=no
-uint8_t REDRAW_WINDOW;  // 1=yes 0=no
-uint8_t MOVE_RESULT;    // 1=Move request success, 0=fail.
-uint8_t UNIT_FIND;      // 255=no unit present.
-uint8_t MOVE_TYPE;      // %00000001=WALK %00000010=HOVER
-uint8_t* CUR_PATTERN;   // stores the memory location of the current musical pattern being played.
-
-uint8_t* MAP_SOURCE;    // $FD
-uint8_t SCREEN_MEMORY[SCREEN_WIDTH_IN_CHARACTERS * SCREEN_HEIGHT_IN_CHARACTERS]; // $8000
-
+#ifndef PLATFORM_HEADLESS
 int main(int argc, char *argv[])
 {
     PlatformClass platformInstance;
@@ -107,6 +56,60 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+#ifdef PLATFORM_CAPTURE
+    // Record what is drawn until the capture is full, and save it on exit
+    static PlatformCapture capture(platform);
+    Platform* gamePlatform = &capture;
+#else
+    Platform* gamePlatform = platform;
+#endif
+
+    // Too large for the stack of the main thread
+    static Game game(gamePlatform);
+
+    game.INITIALIZE();
+    while (!gamePlatform->quit) {
+        game.INTRO_SCREEN();
+    }
+#ifdef PLATFORM_CAPTURE
+    capture.writeCapture("capture.prc");
+#endif
+    return 0;
+}
+#endif
+
+Game::Game(Platform* platform) :
+    GameState(),
+    platform(platform)
+{
+    SET_MAP_DATA(MAP_BUFFER);
+    const char* name = "level-a";
+    for (int i = 0; i != sizeof(MAPNAME); i++) {
+        MAPNAME[i] = name[i];
+    }
+    ANIMATE = 1;
+    CONTROL = 2;
+    BORDER_COLOR = 0xf00;
+    MUSIC_ON = 1;
+    DIFF_LEVEL = 1;
+    TURBO_TICKS = PLATFORM_TURBO_TICKS;
+    FADE_IN_LEVEL = 15;
+    uint8_t PAGES = platform->backgroundPages(PLATFORM_PAGE_TILES_WIDTH * 24, PLATFORM_PAGE_TILES_HEIGHT * 24);
+    PAGE_COUNT = MIN(PAGES, MAX_PAGES);
+    RESET_PAGES();
+}
+
+bool MESSAGES_CONVERTED = false;
+
+// The texts and the map chart are shared by all games and prepared
+// only once. Call before starting games on several threads.
+void Game::CONVERT_MESSAGES()
+{
+    if (MESSAGES_CONVERTED) {
+        return;
+    }
+    MESSAGES_CONVERTED = true;
+
     convertToPETSCII(INTRO_MESSAGE);
     convertToPETSCII(MSG_CANTMOVE);
     convertToPETSCII(MSG_BLOCKED);
@@ -128,6 +131,9 @@ int main(int argc, char *argv[])
     convertToPETSCII(MSG_PAUSED);
     convertToPETSCII(MSG_MUSICON);
     convertToPETSCII(MSG_MUSICOFF);
+    convertToPETSCII(MSG_SAVED);
+    convertToPETSCII(MSG_LOADED);
+    convertToPETSCII(MSG_NOSAVE);
     convertToPETSCII(MAP_NAMES);
     convertToPETSCII(LOAD_MSG2);
     convertToPETSCII(INTRO_OPTIONS);
@@ -142,28 +148,36 @@ int main(int argc, char *argv[])
         MAP_CHART[i] = i * 3 * SCREEN_WIDTH_IN_CHARACTERS;
     }
 #endif
+}
 
+// Prepares the text and the tiles and starts the interrupt.
+// The headless simulator calls this directly instead of main().
+void Game::INITIALIZE()
+{
+    CONVERT_MESSAGES();
     platform->stopNote(); // RESET SOUND TO ZERO
     TILE_LOAD_ROUTINE();
     SETUP_INTERRUPT();
     SET_CONTROLS(); // copy initial key controls
-    while (!platform->quit) {
-        INTRO_SCREEN();
-    }
-    return 0;
 }
 
-void INIT_GAME()
+void Game::INIT_GAME()
 {
+    LOAD_START_TIME = platform->microseconds();
     SCREEN_SHAKE = 0;
     LIVE_MAP_ON = 0;
     RESET_KEYS_AMMO();
-    platform->fadeScreen(0, false);
+    FADE_OUT();
+    CLEAR_INFO_QUEUE();
     DISPLAY_GAME_SCREEN();
     DISPLAY_LOAD_MESSAGE2();
     platform->fadeScreen(15, false);
-    MAP_LOAD_ROUTINE();
+    LOAD_TIME = platform->microseconds();
+    if (!MAP_LOAD_ROUTINE()) {
+        return; // back to the intro screen
+    }
     START_IN_GAME_MUSIC();
+    LOAD_TIME = platform->microseconds() - LOAD_TIME;
     SET_DIFF_LEVEL();
     ANIMATE_PLAYER();
     CACULATE_AND_REDRAW();
@@ -172,34 +186,24 @@ void INIT_GAME()
     DISPLAY_PLAYER_HEALTH();
     DISPLAY_KEYS();
     DISPLAY_WEAPON();
-    UNIT_TYPE[0] = 1;
+    SET_UNIT_TYPE(0, 1);
     SET_INITIAL_TIMERS();
     PRINT_INTRO_MESSAGE();
     KEYTIMER = 30;
+#if PLATFORM_REWIND_SECONDS > 0
+    REWIND_RESET();
+#endif
+    TURBO_COUNT = 0;
+    TURBO_MAP_CHANGED = 0;
+    TURBO_TICK_COUNT = 0;
+    TURBO_REPORT_TIME = platform->microseconds();
+    PAGE_HITS = 0;
+    PAGE_MISSES = 0;
+    PAGE_REBUILDS = 0;
     MAIN_GAME_LOOP();
 }
 
 #define TILENAME 0
-char MAPNAME[] = "level-a";
-uint8_t KEYS = 0; // bit0=spade bit2=heart bit3=star
-uint8_t AMMO_PISTOL = 0; // how much ammo for the pistol
-uint8_t AMMO_PLASMA = 0; // how many shots of the plasmagun
-uint8_t INV_BOMBS = 0; // How many bombs do we have
-uint8_t INV_EMP = 0; // How many EMPs do we have
-uint8_t INV_MEDKIT = 0; // How many medkits do we have?
-uint8_t INV_MAGNET = 0; // How many magnets do we have?
-uint8_t SELECTED_WEAPON = 0; // 0=none 1=pistol 2=plasmagun
-uint8_t SELECTED_ITEM = 0; // 0=none 1=bomb 2=emp 3=medkit 4=magnet
-uint8_t SELECT_TIMEOUT = 0; // can only change weapons once it hits zero
-uint8_t ANIMATE = 1; // 0=DISABLED 1=ENABLED
-uint8_t BIG_EXP_ACT = 0; // 0=No explosion active 1=big explosion active
-uint8_t MAGNET_ACT = 0; // 0=no magnet active 1=magnet active
-uint8_t PLASMA_ACT = 0; // 0=No plasma fire active 1=plasma fire active
-uint8_t RANDOM = 0; // used for random number generation
-uint8_t BORDER = 0; // Used for border flash timing
-uint8_t SCREEN_SHAKE = 0; // 1=shake 0=no shake
-uint8_t CONTROL = 2; // 0=keyboard 1=custom keys 2=snes
-uint16_t BORDER_COLOR = 0xf00; // Used for border flash coloring
 char INTRO_MESSAGE[] = "welcome to psp-robots!\xff"
                        "by david murray 2021\xff"
                        "psp port by vesa halttunen";
@@ -227,7 +231,6 @@ char MSG_PAUSED[] = "game paused.\xff"
                     "exit game (y/n)";
 char MSG_MUSICON[] = "music on.";
 char MSG_MUSICOFF[] = "music off.";
-uint8_t SELECTED_MAP = 0;
 char MAP_NAMES[] = "01-research lab "
                    "02-headquarters "
                    "03-the village  "
@@ -245,10 +248,8 @@ char MAP_NAMES[] = "01-research lab "
                    ;
 #define MAP_COUNT 14
 
-uint8_t MUSIC_ON = 1; // 0=off 1=on
-
 // Displays loading message for map.
-void DISPLAY_LOAD_MESSAGE2()
+void Game::DISPLAY_LOAD_MESSAGE2()
 {
     int Y;
     for (Y = 0; Y != 12; Y++) {
@@ -262,9 +263,14 @@ void DISPLAY_LOAD_MESSAGE2()
 
 char LOAD_MSG2[] = "loading map:";
 
-void SETUP_INTERRUPT()
+void Game::SETUP_INTERRUPT()
 {
-    platform->setInterrupt(&RUNIRQ);
+    platform->setInterrupt(&INTERRUPT, this);
+}
+
+void Game::INTERRUPT(void* game)
+{
+    ((Game*)game)->RUNIRQ();
 }
 
 // This is the routine that runs every 60 seconds from the IRQ.
@@ -272,7 +278,7 @@ void SETUP_INTERRUPT()
 // program will reset it to 0 when it is done with it's work for
 // that cycle.  BGTIMER2 is a count-down to zero and then stays
 // there.
-void RUNIRQ()
+void Game::RUNIRQ()
 {
     UPDATE_GAME_CLOCK();
     ANIMATE_WATER();
@@ -287,15 +293,55 @@ void RUNIRQ()
         BORDER--;
         platform->fadeScreen(15 - BORDER);
     }
+    UPDATE_TIMELINE();
     // Back to usual IRQ routine
 }
-uint8_t BGTIMER1 = 0;
-uint8_t BGTIMER2 = 0;
-uint8_t KEYTIMER = 0; // Used for repeat of movement
+
+// Steps the effects that run along with the game instead of
+// waiting for frames of their own: one level of the fade in
+// and one line of the info window each tick.
+void Game::UPDATE_TIMELINE()
+{
+    if (FADE_IN_LEVEL != 15 && BORDER == 0) {
+        FADE_IN_LEVEL++;
+        platform->fadeScreen(FADE_IN_LEVEL);
+    }
+    if (INFO_QUEUE_COUNT != 0) {
+        SHOW_INFO();
+    }
+}
+
+// Waits for the next tick. In turbo mode a shown frame is followed
+// by the rest of its ticks at once, as if the interrupt had run.
+void Game::WAIT_FOR_TICK()
+{
+    if (BGTIMER1 == 1) {
+        return;
+    }
+    if (TURBO_COUNT != 0) {
+        TURBO_COUNT--;
+        RUNIRQ();
+    } else {
+        platform->renderFrame(true);
+        TURBO_COUNT = TURBO_TICKS - 1;
+    }
+}
+
+// Reports the ticks run each second of real time in turbo mode
+void Game::REPORT_TURBO_RATE()
+{
+    TURBO_TICK_COUNT++;
+    uint32_t TIME = platform->microseconds() - TURBO_REPORT_TIME;
+    if (TIME >= 1000000) {
+        debug("Turbo mode at %lu ticks per second\n", TURBO_TICK_COUNT * 1000 / (TIME / 1000));
+        TURBO_TICK_COUNT = 0;
+        TURBO_REPORT_TIME += TIME;
+    }
+}
 
 // Since the PET has no real-time clock, and the Jiffy clock
 // is a pain to read from assembly language, I have created my own.
-void UPDATE_GAME_CLOCK()
+void Game::UPDATE_GAME_CLOCK()
 {
     if (CLOCK_ACTIVE != 1) {
         return;
@@ -319,31 +365,26 @@ void UPDATE_GAME_CLOCK()
     HOURS++;
 }
 
-uint8_t HOURS = 0;
-uint8_t MINUTES = 0;
-uint8_t SECONDS = 0;
-uint8_t CYCLES = 0;
-uint8_t CLOCK_ACTIVE = 0;
-
 // This routine spaces out the timers so that not everything
 // is running out once. It also starts the game_clock.
-void SET_INITIAL_TIMERS()
+void Game::SET_INITIAL_TIMERS()
 {
     CLOCK_ACTIVE = 1;
-    for (int X = 1; X != 48; X++) {
+    for (int X = 1; X != UNIT_HIDDEN; X++) {
         UNIT_TIMER_A[X] = X;
         UNIT_TIMER_B[X] = 0;
     }
 }
 
-void MAIN_GAME_LOOP()
+void Game::MAIN_GAME_LOOP()
 {
     platform->renderFrame();
+#ifdef PLATFORM_STATISTICS
+    debug("Level %s loaded in %lu us, first frame after %lu us\n", MAPNAME, LOAD_TIME, platform->microseconds() - LOAD_START_TIME);
+#endif
     bool done = false;
     while (!done && !platform->quit) {
-        if (BGTIMER1 != 1) {
-            platform->renderFrame(true);
-        }
+        WAIT_FOR_TICK();
         PET_SCREEN_SHAKE();
         BACKGROUND_TASKS();
         if (UNIT_TYPE[0] != 1) { // Is player unit alive
@@ -489,6 +530,19 @@ void MAIN_GAME_LOOP()
                         TOGGLE_MUSIC();
                         CLEAR_KEY_BUFFER();
                     }
+                    if (B & Platform::JoystickYellow) {
+                        QUICK_SAVE();
+                        CLEAR_KEY_BUFFER();
+                    }
+                    if (B & Platform::JoystickGreen) {
+                        QUICK_LOAD();
+                        CLEAR_KEY_BUFFER();
+                    }
+#if PLATFORM_REWIND_SECONDS > 0
+                    if (B & Platform::JoystickUp) {
+                        REWIND();
+                    }
+#endif
                 } else {
                     if (B & Platform::JoystickGreen) {
                         FIRE_LEFT();
@@ -549,7 +603,7 @@ void MAIN_GAME_LOOP()
 
 // This routine handles things that are in common to
 // all 4 directions of movement.
-void AFTER_MOVE_SNES()
+void Game::AFTER_MOVE_SNES()
 {
     if (MOVE_RESULT == 1) {
         ANIMATE_PLAYER();
@@ -563,7 +617,7 @@ void AFTER_MOVE_SNES()
     }
 }
 
-void TOGGLE_MUSIC()
+void Game::TOGGLE_MUSIC()
 {
     if (MUSIC_ON == 1) {
         PRINT_INFO(MSG_MUSICOFF);
@@ -576,7 +630,7 @@ void TOGGLE_MUSIC()
     }
 }
 
-void START_IN_GAME_MUSIC()
+void Game::START_IN_GAME_MUSIC()
 {
     platform->playModule(MUSIC_ON == 1 ? LEVEL_MUSIC[SELECTED_MAP] : Platform::ModuleSoundFX);
 }
@@ -599,7 +653,7 @@ Platform::Module LEVEL_MUSIC[] = {
 };
 
 // TEMP ROUTINE TO GIVE ME ALL ITEMS AND WEAPONS
-void CHEATER()
+void Game::CHEATER()
 {
     PLAY_SOUND(12);
     KEYS = 7;
@@ -617,7 +671,7 @@ void CHEATER()
     DISPLAY_ITEM();
 }
 
-bool PAUSE_GAME()
+bool Game::PAUSE_GAME()
 {
     PLAY_SOUND(15);
     // pause clock
@@ -642,7 +696,7 @@ bool PAUSE_GAME()
             PLAY_SOUND(15);
             return false;
         } else if (A == KEY_CONFIG[KEY_YES] || (B & Platform::JoystickRed)) { // Y-KEY
-            UNIT_TYPE[0] = 0; // make player dead
+            RELEASE_UNIT(0); // make player dead
             PLAY_SOUND(15);
             GOM4();
             return true;
@@ -652,13 +706,13 @@ bool PAUSE_GAME()
     return false;
 }
 
-void CLEAR_KEY_BUFFER()
+void Game::CLEAR_KEY_BUFFER()
 {
     platform->clearKeyBuffer(); // CLEAR KEYBOARD BUFFER
     KEYTIMER = 20;
 }
 
-void USE_ITEM()
+void Game::USE_ITEM()
 {
     // check select timeout to prevent accidental double-tap
     if (SELECT_TIMEOUT != 0) {
@@ -683,7 +737,7 @@ void USE_ITEM()
     }
 }
 
-void USE_BOMB()
+void Game::USE_BOMB()
 {
     platform->setCursorShape(Platform::ShapeUse);
     USER_SELECT_OBJECT();
@@ -692,21 +746,19 @@ void USE_BOMB()
         // Now scan for any units at that location:
         CHECK_FOR_UNIT();
         if (UNIT_FIND == 255) { // 255 means no unit found.
-            for (int X = 28; X != 32; X++) { // Start of weapons units
-                if (UNIT_TYPE[X] == 0) {
-                    UNIT_TYPE[X] = 6; // bomb AI
-                    UNIT_TILE[X] = 130; // bomb tile
-                    UNIT_LOC_X[X] = MAP_X;
-                    UNIT_LOC_Y[X] = MAP_Y;
-                    UNIT_TIMER_A[X] = 100; // How long until explosion?
-                    UNIT_A[X] = 0;
-                    INV_BOMBS--;
-                    DISPLAY_ITEM();
-                    REDRAW_WINDOW = 1;
-                    SELECT_TIMEOUT = 3; // 3 cycles before next item can be used, pet version only
-                    PLAY_SOUND(6); // SOUND PLAY
-                    return;
-                }
+            uint8_t X = ALLOCATE_UNIT(RANGE_WEAPONS, 6); // bomb AI
+            if (X != 255) {
+                UNIT_TILE[X] = 130; // bomb tile
+                UNIT_LOC_X[X] = MAP_X;
+                UNIT_LOC_Y[X] = MAP_Y;
+                UNIT_TIMER_A[X] = 100; // How long until explosion?
+                UNIT_A[X] = 0;
+                INV_BOMBS--;
+                DISPLAY_ITEM();
+                REDRAW_WINDOW = 1;
+                SELECT_TIMEOUT = 3; // 3 cycles before next item can be used, pet version only
+                PLAY_SOUND(6); // SOUND PLAY
+                return;
             }
             return; // no slots available right now, abort.
         }
@@ -714,7 +766,7 @@ void USE_BOMB()
     BOMB_MAGNET_COMMON2();
 }
 
-void USE_MAGNET()
+void Game::USE_MAGNET()
 {
     if (MAGNET_ACT != 0) { // only one magnet active at a time.
         return;
@@ -723,29 +775,27 @@ void USE_MAGNET()
     USER_SELECT_OBJECT();
     // NOW TEST TO SEE IF THAT SPOT IS OPEN
     if (BOMB_MAGNET_COMMON1()) {
-        for (int X = 28; X != 32; X++) { // Start of weapons units
-            if (UNIT_TYPE[X] == 0) {
-                UNIT_TYPE[X] = 20; // MAGNET AI
-                UNIT_TILE[X] = 134; // MAGNET tile
-                UNIT_LOC_X[X] = MAP_X;
-                UNIT_LOC_Y[X] = MAP_Y;
-                UNIT_TIMER_A[X] = 1; // How long until ACTIVATION
-                UNIT_TIMER_B[X] = 255; // how long does it live -A
-                UNIT_A[X] = 3; // how long does it live -B
-                MAGNET_ACT = 1; // only one magnet allowed at a time.
-                INV_MAGNET--;
-                DISPLAY_ITEM();
-                REDRAW_WINDOW = 1;
-                PLAY_SOUND(6); // move sound, SOUND PLAY
-                return;
-            }
+        uint8_t X = ALLOCATE_UNIT(RANGE_WEAPONS, 20); // MAGNET AI
+        if (X != 255) {
+            UNIT_TILE[X] = 134; // MAGNET tile
+            UNIT_LOC_X[X] = MAP_X;
+            UNIT_LOC_Y[X] = MAP_Y;
+            UNIT_TIMER_A[X] = 1; // How long until ACTIVATION
+            UNIT_TIMER_B[X] = 255; // how long does it live -A
+            UNIT_A[X] = 3; // how long does it live -B
+            MAGNET_ACT = 1; // only one magnet allowed at a time.
+            INV_MAGNET--;
+            DISPLAY_ITEM();
+            REDRAW_WINDOW = 1;
+            PLAY_SOUND(6); // move sound, SOUND PLAY
+            return;
         }
         return; // no slots available right now, abort.
     }
     BOMB_MAGNET_COMMON2();
 }
 
-bool BOMB_MAGNET_COMMON1()
+bool Game::BOMB_MAGNET_COMMON1()
 {
     platform->hideCursor();
     MAP_X = CURSOR_X + MAP_WINDOW_X;
@@ -753,25 +803,24 @@ bool BOMB_MAGNET_COMMON1()
     MAP_Y = CURSOR_Y + MAP_WINDOW_Y;
     MOVTEMP_UY = MAP_Y;
     GET_TILE_FROM_MAP();
-    return (TILE_ATTRIB[TILE] & 0x01) == 0x01; // %00000001 is that spot available for something to move onto it?
+    return MAP_PLANE(PLANE_WALK, MAP_X, MAP_Y); // %00000001 is that spot available for something to move onto it?
 }
 
-void BOMB_MAGNET_COMMON2()
+void Game::BOMB_MAGNET_COMMON2()
 {
     PRINT_INFO(MSG_BLOCKED);
     PLAY_SOUND(11); // ERROR SOUND, SOUND PLAY
 }
 
-void USE_EMP()
+void Game::USE_EMP()
 {
     EMP_FLASH();
 //    REDRAW_WINDOW = 0;  // attempt to delay window redrawing (pet only)
     PLAY_SOUND(3);  // EMP sound, SOUND PLAY
     INV_EMP--;
     DISPLAY_ITEM();
-    for (int X = 1; X != 28; X++) { // start with unit#1 (skip player)
-        if (UNIT_TYPE[X] != 0 &&                    // CHECK THAT UNIT EXISTS
-            UNIT_LOC_X[X] >= MAP_WINDOW_X &&        // CHECK HORIZONTAL POSITION
+    for (uint8_t X = NEXT_UNIT(UNIT_ROBOTS, UNIT_WEAPONS); X != UNIT_WEAPONS; X = NEXT_UNIT(X + 1, UNIT_WEAPONS)) { // start with unit#1 (skip player)
+        if (UNIT_LOC_X[X] >= MAP_WINDOW_X &&        // CHECK HORIZONTAL POSITION
             UNIT_LOC_X[X] <= (MAP_WINDOW_X + PLATFORM_MAP_WINDOW_TILES_WIDTH - 1) &&  // NOW CHECK VERTICAL
             UNIT_LOC_Y[X] >= MAP_WINDOW_Y &&
             UNIT_LOC_Y[X] <= (MAP_WINDOW_Y + PLATFORM_MAP_WINDOW_TILES_HEIGHT - 1)) {
@@ -781,7 +830,7 @@ void USE_EMP()
             MAP_Y = UNIT_LOC_Y[X];
             GET_TILE_FROM_MAP();
             if (TILE == 204) {  // WATER
-                UNIT_TYPE[X] = 5;
+                SET_UNIT_TYPE(X, 5);
                 UNIT_TIMER_A[X] = 5;
                 UNIT_TIMER_B[X] = 3;
                 UNIT_A[X] = 60; // how long to show sparks.
@@ -793,7 +842,7 @@ void USE_EMP()
     SELECT_TIMEOUT = 3; // 3 cycles before next item can be used
 }
 
-void USE_MEDKIT()
+void Game::USE_MEDKIT()
 {
     if (UNIT_HEALTH[0] == 12) {    // Do we even need the medkit?
         return;
@@ -815,7 +864,7 @@ void USE_MEDKIT()
     PRINT_INFO(MSG_MUCHBET);
 }
 
-void FIRE_UP()
+void Game::FIRE_UP()
 {
     if (SELECTED_WEAPON == 0) {
         return;
@@ -827,24 +876,22 @@ void FIRE_UP()
     UNIT_DIRECTION[0] = 0;
 }
 
-void FIRE_UP_PISTOL()
+void Game::FIRE_UP_PISTOL()
 {
     if (AMMO_PISTOL == 0) {
         return;
     }
-    for (int X = 28; X != 32; X++) { // max unit for weaponsfire
-        if (UNIT_TYPE[X] == 0) {
-            UNIT_TYPE[X] = 12; // Fire pistol up AI routine
-            UNIT_TILE[X] = 244; // tile for vertical weapons fire
-            UNIT_A[X] = 3; // travel distance.
-            UNIT_B[X] = 0; // weapon-type = pistol
-            AFTER_FIRE(X);
-            return;
-        }
+    uint8_t X = ALLOCATE_UNIT(RANGE_WEAPONS, 12); // Fire pistol up AI routine
+    if (X != 255) {
+        UNIT_TILE[X] = 244; // tile for vertical weapons fire
+        UNIT_A[X] = 3; // travel distance.
+        UNIT_B[X] = 0; // weapon-type = pistol
+        AFTER_FIRE(X);
+        return;
     }
 }
 
-void FIRE_UP_PLASMA()
+void Game::FIRE_UP_PLASMA()
 {
     if (BIG_EXP_ACT == 1) {
         return;
@@ -855,20 +902,18 @@ void FIRE_UP_PLASMA()
     if (AMMO_PLASMA == 0) {
         return;
     }
-    for (int X = 28; X != 32; X++) { // max unit for weaponsfire
-        if (UNIT_TYPE[X] == 0) {
-            UNIT_TYPE[X] = 12; // Fire pistol up AI routine
-            UNIT_TILE[X] = 240; // tile for vertical plasma bolt
-            UNIT_A[X] = 3; // travel distance.
-            UNIT_B[X] = 1; // weapon-type = plasma
-            PLASMA_ACT = 1;
-            AFTER_FIRE(X);
-            return;
-        }
+    uint8_t X = ALLOCATE_UNIT(RANGE_WEAPONS, 12); // Fire pistol up AI routine
+    if (X != 255) {
+        UNIT_TILE[X] = 240; // tile for vertical plasma bolt
+        UNIT_A[X] = 3; // travel distance.
+        UNIT_B[X] = 1; // weapon-type = plasma
+        PLASMA_ACT = 1;
+        AFTER_FIRE(X);
+        return;
     }
 }
 
-void FIRE_DOWN()
+void Game::FIRE_DOWN()
 {
     if (SELECTED_WEAPON == 0) {
         return;
@@ -880,24 +925,22 @@ void FIRE_DOWN()
     UNIT_DIRECTION[0] = 1;
 }
 
-void FIRE_DOWN_PISTOL()
+void Game::FIRE_DOWN_PISTOL()
 {
     if (AMMO_PISTOL == 0) {
         return;
     }
-    for (int X = 28; X != 32; X++) { // max unit for weaponsfire
-        if (UNIT_TYPE[X] == 0) {
-            UNIT_TYPE[X] = 13; // Fire pistol DOWN AI routine
-            UNIT_TILE[X] = 244; // tile for vertical weapons fire
-            UNIT_A[X] = 3; // travel distance.
-            UNIT_B[X] = 0; // weapon-type = pistol
-            AFTER_FIRE(X);
-            return;
-        }
+    uint8_t X = ALLOCATE_UNIT(RANGE_WEAPONS, 13); // Fire pistol DOWN AI routine
+    if (X != 255) {
+        UNIT_TILE[X] = 244; // tile for vertical weapons fire
+        UNIT_A[X] = 3; // travel distance.
+        UNIT_B[X] = 0; // weapon-type = pistol
+        AFTER_FIRE(X);
+        return;
     }
 }
 
-void FIRE_DOWN_PLASMA()
+void Game::FIRE_DOWN_PLASMA()
 {
     if (BIG_EXP_ACT == 1) {
         return;
@@ -908,20 +951,18 @@ void FIRE_DOWN_PLASMA()
     if (AMMO_PLASMA == 0) {
         return;
     }
-    for (int X = 28; X != 32; X++) { // max unit for weaponsfire
-        if (UNIT_TYPE[X] == 0) {
-            UNIT_TYPE[X] = 13; // Fire pistol DOWN AI routine
-            UNIT_TILE[X] = 240; // tile for vertical plasma bolt
-            UNIT_A[X] = 3; // travel distance.
-            UNIT_B[X] = 1; // weapon-type = plasma
-            PLASMA_ACT = 1;
-            AFTER_FIRE(X);
-            return;
-        }
+    uint8_t X = ALLOCATE_UNIT(RANGE_WEAPONS, 13); // Fire pistol DOWN AI routine
+    if (X != 255) {
+        UNIT_TILE[X] = 240; // tile for vertical plasma bolt
+        UNIT_A[X] = 3; // travel distance.
+        UNIT_B[X] = 1; // weapon-type = plasma
+        PLASMA_ACT = 1;
+        AFTER_FIRE(X);
+        return;
     }
 }
 
-void FIRE_LEFT()
+void Game::FIRE_LEFT()
 {
     if (SELECTED_WEAPON == 0) {
         return;
@@ -933,24 +974,22 @@ void FIRE_LEFT()
     UNIT_DIRECTION[0] = 2;
 }
 
-void FIRE_LEFT_PISTOL()
+void Game::FIRE_LEFT_PISTOL()
 {
     if (AMMO_PISTOL == 0) {
         return;
     }
-    for (int X = 28; X != 32; X++) { // max unit for weaponsfire
-        if (UNIT_TYPE[X] == 0) {
-            UNIT_TYPE[X] = 14; // Fire pistol LEFT AI routine
-            UNIT_TILE[X] = 245; // tile for horizontal weapons fire
-            UNIT_A[X] = 5; // travel distance.
-            UNIT_B[X] = 0; // weapon-type = pistol
-            AFTER_FIRE(X);
-            return;
-        }
+    uint8_t X = ALLOCATE_UNIT(RANGE_WEAPONS, 14); // Fire pistol LEFT AI routine
+    if (X != 255) {
+        UNIT_TILE[X] = 245; // tile for horizontal weapons fire
+        UNIT_A[X] = 5; // travel distance.
+        UNIT_B[X] = 0; // weapon-type = pistol
+        AFTER_FIRE(X);
+        return;
     }
 }
 
-void FIRE_LEFT_PLASMA()
+void Game::FIRE_LEFT_PLASMA()
 {
     if (BIG_EXP_ACT == 1) {
         return;
@@ -961,20 +1000,18 @@ void FIRE_LEFT_PLASMA()
     if (AMMO_PLASMA == 0) {
         return;
     }
-    for (int X = 28; X != 32; X++) { // max unit for weaponsfire
-        if (UNIT_TYPE[X] == 0) {
-            UNIT_TYPE[X] = 14; // Fire pistol LEFT AI routine
-            UNIT_TILE[X] = 241; // tile for horizontal weapons fire
-            UNIT_A[X] = 5; // travel distance.
-            UNIT_B[X] = 1; // weapon-type = plasma
-            PLASMA_ACT = 1;
-            AFTER_FIRE(X);
-            return;
-        }
+    uint8_t X = ALLOCATE_UNIT(RANGE_WEAPONS, 14); // Fire pistol LEFT AI routine
+    if (X != 255) {
+        UNIT_TILE[X] = 241; // tile for horizontal weapons fire
+        UNIT_A[X] = 5; // travel distance.
+        UNIT_B[X] = 1; // weapon-type = plasma
+        PLASMA_ACT = 1;
+        AFTER_FIRE(X);
+        return;
     }
 }
 
-void FIRE_RIGHT()
+void Game::FIRE_RIGHT()
 {
     if (SELECTED_WEAPON == 0) {
         return;
@@ -986,24 +1023,22 @@ void FIRE_RIGHT()
     UNIT_DIRECTION[0] = 3;
 }
 
-void FIRE_RIGHT_PISTOL()
+void Game::FIRE_RIGHT_PISTOL()
 {
     if (AMMO_PISTOL == 0) {
         return;
     }
-    for (int X = 28; X != 32; X++) { // max unit for weaponsfire
-        if (UNIT_TYPE[X] == 0) {
-            UNIT_TYPE[X] = 15; // Fire pistol RIGHT AI routine
-            UNIT_TILE[X] = 245; // tile for horizontal weapons fire
-            UNIT_A[X] = 5; // travel distance.
-            UNIT_B[X] = 0; // weapon-type = pistol
-            AFTER_FIRE(X);
-            return;
-        }
+    uint8_t X = ALLOCATE_UNIT(RANGE_WEAPONS, 15); // Fire pistol RIGHT AI routine
+    if (X != 255) {
+        UNIT_TILE[X] = 245; // tile for horizontal weapons fire
+        UNIT_A[X] = 5; // travel distance.
+        UNIT_B[X] = 0; // weapon-type = pistol
+        AFTER_FIRE(X);
+        return;
     }
 }
 
-void FIRE_RIGHT_PLASMA()
+void Game::FIRE_RIGHT_PLASMA()
 {
     if (BIG_EXP_ACT == 1) {
         return;
@@ -1014,20 +1049,18 @@ void FIRE_RIGHT_PLASMA()
     if (AMMO_PLASMA == 0) {
         return;
     }
-    for (int X = 28; X != 32; X++) { // max unit for weaponsfire
-        if (UNIT_TYPE[X] == 0) {
-            UNIT_TYPE[X] = 15; // Fire pistol RIGHT AI routine
-            UNIT_TILE[X] = 241; // tile for horizontal weapons fire
-            UNIT_A[X] = 5; // travel distance.
-            UNIT_B[X] = 1; // weapon-type = plasma
-            PLASMA_ACT = 1;
-            AFTER_FIRE(X);
-            return;
-        }
+    uint8_t X = ALLOCATE_UNIT(RANGE_WEAPONS, 15); // Fire pistol RIGHT AI routine
+    if (X != 255) {
+        UNIT_TILE[X] = 241; // tile for horizontal weapons fire
+        UNIT_A[X] = 5; // travel distance.
+        UNIT_B[X] = 1; // weapon-type = plasma
+        PLASMA_ACT = 1;
+        AFTER_FIRE(X);
+        return;
     }
 }
 
-void AFTER_FIRE(int X)
+void Game::AFTER_FIRE(int X)
 {
     UNIT_TIMER_A[X] = 0;
     UNIT_LOC_X[X] = UNIT_LOC_X[0];
@@ -1048,7 +1081,7 @@ void AFTER_FIRE(int X)
 // reached zero yet.  If so, it clears the LSTX
 // variable used by the kernal, so that it will
 // register a new keypress.
-void KEY_REPEAT(bool keyDown)
+void Game::KEY_REPEAT(bool keyDown)
 {
     if (KEYTIMER != 0) {
         return;
@@ -1065,7 +1098,7 @@ void KEY_REPEAT(bool keyDown)
 
 // This routine handles things that are in common to
 // all 4 directions of movement.
-void AFTER_MOVE()
+void Game::AFTER_MOVE()
 {
     if (MOVE_RESULT == 1) {
         ANIMATE_PLAYER();
@@ -1082,11 +1115,9 @@ void AFTER_MOVE()
     }
 }
 
-uint8_t KEY_FAST = 0; // 0=DEFAULT STATE
-
 // This routine is invoked when the user presses S to search
 // an object such as a crate, chair, or plant.
-void SEARCH_OBJECT()
+void Game::SEARCH_OBJECT()
 {
     platform->setCursorShape(Platform::ShapeSearch);
     USER_SELECT_OBJECT();
@@ -1094,7 +1125,7 @@ void SEARCH_OBJECT()
     // first check of object is searchable
     CALC_COORDINATES();
     GET_TILE_FROM_MAP();
-    if ((TILE_ATTRIB[TILE] & 0x40) == 0) { // %01000000 can search attribute
+    if (!MAP_PLANE(PLANE_SEARCHABLE, MAP_X, MAP_Y)) { // %01000000 can search attribute
         platform->hideCursor();
     } else {
         // is the tile a crate?
@@ -1104,11 +1135,10 @@ void SEARCH_OBJECT()
         }
         // Now check if there is an object there.
         PRINT_INFO(MSG_SEARCHING);
+        FLUSH_INFO();
         for (SEARCHBAR = 0; SEARCHBAR != 8; SEARCHBAR++) {
             for (BGTIMER2 = 18; BGTIMER2 != 0;) { // delay time between search periods
-                if (BGTIMER1 != 1) {
-                    platform->renderFrame(true);
-                }
+                WAIT_FOR_TICK();
                 PET_SCREEN_SHAKE();
                 BACKGROUND_TASKS();
             }
@@ -1123,7 +1153,7 @@ void SEARCH_OBJECT()
         }
         TEMP_A = UNIT_TYPE[UNIT_FIND];  // store object type
         TEMP_B = UNIT_A[UNIT_FIND]; // store secondary info
-        UNIT_TYPE[UNIT_FIND] = 0; // DELETE ITEM ONCE FOUND
+        RELEASE_UNIT(UNIT_FIND); // DELETE ITEM ONCE FOUND
         // ***NOW PROCESS THE ITEM FOUND***
         PLAY_SOUND(10); // ITEM-FOUND-SOUND, SOUND PLAY
         if (TEMP_A == 128) {    // key
@@ -1169,11 +1199,9 @@ void SEARCH_OBJECT()
     }
 }
 
-uint8_t SEARCHBAR = 0; // to count how many periods to display.
-
 // combines cursor location with window location
 // to determine coordinates for MAP_X and MAP_Y
-void CALC_COORDINATES()
+void Game::CALC_COORDINATES()
 {
     MAP_X = CURSOR_X + MAP_WINDOW_X;
     MAP_Y = CURSOR_Y + MAP_WINDOW_Y;
@@ -1182,7 +1210,7 @@ void CALC_COORDINATES()
 // This routine is called by routines such as the move, search,
 // or use commands.  It displays a cursor and allows the user
 // to pick a direction of an object.
-void USER_SELECT_OBJECT()
+void Game::USER_SELECT_OBJECT()
 {
     PLAY_SOUND(16); // beep sound, SOUND PLAY
 #if (MAP_WINDOW_SIZE == 77)
@@ -1197,9 +1225,7 @@ void USER_SELECT_OBJECT()
     }
     // First ask user which object to move
     while (!platform->quit) {
-        if (BGTIMER1 != 1) {
-            platform->renderFrame(true);
-        }
+        WAIT_FOR_TICK();
         PET_SCREEN_SHAKE();
         BACKGROUND_TASKS();
         if (UNIT_TYPE[0] == 0) { // Did player die wile moving something?
@@ -1241,7 +1267,7 @@ void USER_SELECT_OBJECT()
     }
 }
 
-void MOVE_OBJECT()
+void Game::MOVE_OBJECT()
 {
     platform->setCursorShape(Platform::ShapeMove);
     USER_SELECT_OBJECT();
@@ -1252,7 +1278,7 @@ void MOVE_OBJECT()
     CHECK_FOR_HIDDEN_UNIT();
     MOVTEMP_U = UNIT_FIND;
     GET_TILE_FROM_MAP();
-    if ((TILE_ATTRIB[TILE] & 0x04) == 0) { // can it be moved?
+    if (!MAP_PLANE(PLANE_MOVABLE, MAP_X, MAP_Y)) { // can it be moved?
         PRINT_INFO(MSG_CANTMOVE);
         PLAY_SOUND(11); // ERROR SOUND, SOUND PLAY
         return;
@@ -1265,9 +1291,7 @@ void MOVE_OBJECT()
     }
     // NOW ASK THE USER WHICH DIRECTION TO MOVE IT TO
     while (!platform->quit) {
-        if (BGTIMER1 != 1) {
-            platform->renderFrame(true);
-        }
+        WAIT_FOR_TICK();
         PET_SCREEN_SHAKE();
         BACKGROUND_TASKS();
         if (UNIT_TYPE[0] == 0) { // Did player die wile moving something?
@@ -1301,13 +1325,13 @@ void MOVE_OBJECT()
     MAP_Y = CURSOR_Y + MAP_WINDOW_Y;
     MOVTEMP_UY = MAP_Y;
     GET_TILE_FROM_MAP();
-    if (TILE_ATTRIB[TILE] & 0x20) { // %00100000 is that spot available for something to move onto it?
+    if (MAP_PLANE(PLANE_PLACEABLE, MAP_X, MAP_Y)) { // %00100000 is that spot available for something to move onto it?
         // Now scan for any units at that location:
         CHECK_FOR_UNIT();
         if (UNIT_FIND == 255) { // 255 means no unit found.
             PLAY_SOUND(6); // move sound, SOUND PLAY
             MOVTEMP_D = MAP_SOURCE[0]; // Grab current object
-            MAP_SOURCE[0] = MOVTEMP_O; // replace with obect we are moving
+            WRITE_MAP_TILE(MAP_X, MAP_Y, MOVTEMP_O); // replace with obect we are moving
             MAP_X = MOVTEMP_X; // RETRIEVE original location of object
             MAP_Y = MOVTEMP_Y;
             GET_TILE_FROM_MAP();
@@ -1315,17 +1339,14 @@ void MOVE_OBJECT()
             if (A == 148) { // trash compactor tile
                 A = 9; // Floor tile
             }
-            MAP_SOURCE[0] = A; // Replace former location
+            WRITE_MAP_TILE(MAP_X, MAP_Y, A); // Replace former location
             REDRAW_WINDOW = 1; // See the result
             if (MOVTEMP_U == 255) {
-                if (LIVE_MAP_ON == 1) {
-                    platform->renderLiveMapTile(MAP, MOVTEMP_X, MOVTEMP_Y);
-                    platform->renderLiveMapTile(MAP, MOVTEMP_UX, MOVTEMP_UY);
-                }
                 return;
             }
             UNIT_LOC_X[MOVTEMP_U] = MOVTEMP_UX;
             UNIT_LOC_Y[MOVTEMP_U] = MOVTEMP_UY;
+            MARK_HIDDEN_UNIT(MOVTEMP_U);
             return;
         }
     }
@@ -1333,37 +1354,29 @@ void MOVE_OBJECT()
     PLAY_SOUND(11); // ERROR SOUND, SOUND PLAY
 }
 
-uint8_t MOVTEMP_O = 0; // origin tile
-uint8_t MOVTEMP_D = 0; // destination tile
-uint8_t MOVTEMP_X = 0; // x-coordinate
-uint8_t MOVTEMP_Y = 0; // y-coordinate
-uint8_t MOVTEMP_U = 0; // unit number (255=none)
-uint8_t MOVTEMP_UX = 0;
-uint8_t MOVTEMP_UY = 0;
-
-void CACULATE_AND_REDRAW()
+void Game::CACULATE_AND_REDRAW()
 {
 #if (MAP_WINDOW_SIZE == 77)
     MAP_WINDOW_X = UNIT_LOC_X[0] - PLATFORM_MAP_WINDOW_TILES_WIDTH / 2; // no index needed since it's player unit
     MAP_WINDOW_Y = UNIT_LOC_Y[0] - PLATFORM_MAP_WINDOW_TILES_HEIGHT / 2; // no index needed since it's player unit
 #else
-    MAP_WINDOW_X = MIN(MAX(UNIT_LOC_X[0] - PLATFORM_MAP_WINDOW_TILES_WIDTH / 2, 0), 128 - PLATFORM_MAP_WINDOW_TILES_WIDTH); // no index needed since it's player unit
-    MAP_WINDOW_Y = MIN(MAX(UNIT_LOC_Y[0] - PLATFORM_MAP_WINDOW_TILES_HEIGHT / 2, 0), 64 - PLATFORM_MAP_WINDOW_TILES_HEIGHT); // no index needed since it's player unit
+    MAP_WINDOW_X = MIN(MAX(UNIT_LOC_X[0] - PLATFORM_MAP_WINDOW_TILES_WIDTH / 2, 0), PLATFORM_MAP_WIDTH - PLATFORM_MAP_WINDOW_TILES_WIDTH); // no index needed since it's player unit
+    MAP_WINDOW_Y = MIN(MAX(UNIT_LOC_Y[0] - PLATFORM_MAP_WINDOW_TILES_HEIGHT / 2, 0), PLATFORM_MAP_HEIGHT - PLATFORM_MAP_WINDOW_TILES_HEIGHT); // no index needed since it's player unit
 #endif
     REDRAW_WINDOW = 1;
 }
 
-// This routine checks all units from 0 to 31 and figures out if it should be dislpayed
+// This routine checks all units up to the doors and figures out if it should be dislpayed
 // on screen, and then grabs that unit's tile and stores it in the MAP_PRECALC array
 // so that when the window is drawn, it does not have to search for units during the
 // draw, speeding up the display routine.
-void MAP_PRE_CALCULATE()
+void Game::MAP_PRE_CALCULATE()
 {
     // CLEAR OLD BUFFER
     for (int Y = 0; Y != MAP_WINDOW_SIZE; Y++) {
         MAP_PRECALC[Y] = 0;
     }
-    for (int X = 0; X != 32; X++) {
+    for (int X = 0; X != UNIT_DOORS; X = NEXT_UNIT(X + 1, UNIT_DOORS)) {
         if (X == 0 || // skip the check for unit zero, always draw it.
             (UNIT_TYPE[X] != 0 &&                    // CHECK THAT UNIT EXISTS
              UNIT_LOC_X[X] >= MAP_WINDOW_X &&        // CHECK HORIZONTAL POSITION
@@ -1397,135 +1410,316 @@ uint8_t PRECALC_ROWS[] = { 0,11,22,33,44,55,66 };
 #endif
 
 // This routine is where the MAP is displayed on the screen
-void INVALIDATE_PREVIOUS_MAP()
+void Game::INVALIDATE_PREVIOUS_MAP()
 {
     for (int i = 0; i < MAP_WINDOW_SIZE; i++) {
         PREVIOUS_MAP_BACKGROUND[i] = 255;
     }
+    PAGE_WINDOW_X = (map_coord_t)-1;
+}
+
+// Forgets all background pages, for when the whole map changes
+void Game::RESET_PAGES()
+{
+    for (uint8_t i = 0; i != MAX_PAGES; i++) {
+        PAGE_MAP[i] = NO_PAGE;
+        PAGE_STALE[i] = 0;
+        PAGE_USED[i] = 0;
+    }
+    PAGE_CLOCK = 0;
+    PAGE_WINDOW_X = (map_coord_t)-1;
+}
+
+// Has the background page with a changed tile rendered again when next drawn
+void Game::MARK_PAGE_STALE(uint16_t X, uint16_t Y)
+{
+    uint16_t PAGE = (Y / PLATFORM_PAGE_TILES_HEIGHT) * PAGE_COLUMNS + X / PLATFORM_PAGE_TILES_WIDTH;
+    for (uint8_t i = 0; i != PAGE_COUNT; i++) {
+        if (PAGE_MAP[i] == PAGE) {
+            PAGE_STALE[i] = 1;
+            return;
+        }
+    }
+}
+
+// Returns the background page holding a page of the map. If it isn't
+// kept or is out of date, it is rendered into the least recently used.
+uint8_t Game::FIND_PAGE(uint16_t PAGE)
+{
+    uint8_t SLOT = 0;
+    for (uint8_t i = 0; i != PAGE_COUNT; i++) {
+        if (PAGE_MAP[i] == PAGE) {
+            SLOT = i;
+            break;
+        }
+        if (PAGE_USED[i] < PAGE_USED[SLOT]) {
+            SLOT = i;
+        }
+    }
+    PAGE_USED[SLOT] = ++PAGE_CLOCK;
+    if (PAGE_MAP[SLOT] == PAGE) {
+        if (PAGE_STALE[SLOT] == 0) {
+            PAGE_HITS++;
+            return SLOT;
+        }
+        PAGE_REBUILDS++;
+    } else {
+        PAGE_MISSES++;
+    }
+    PAGE_MAP[SLOT] = PAGE;
+    PAGE_STALE[SLOT] = 0;
+    uint16_t PAGE_X = (PAGE % PAGE_COLUMNS) * PLATFORM_PAGE_TILES_WIDTH;
+    uint16_t PAGE_Y = (PAGE / PAGE_COLUMNS) * PLATFORM_PAGE_TILES_HEIGHT;
+    platform->beginPage(SLOT);
+    for (uint16_t Y = 0; Y != PLATFORM_PAGE_TILES_HEIGHT && PAGE_Y + Y < PLATFORM_MAP_HEIGHT; Y++) {
+        for (uint16_t X = 0; X != PLATFORM_PAGE_TILES_WIDTH && PAGE_X + X < PLATFORM_MAP_WIDTH; X++) {
+            platform->renderTile(MAP[MAP_CELL(PAGE_X + X, PAGE_Y + Y)], X * 24, Y * 24);
+        }
+    }
+    platform->endPage(SLOT);
+    return SLOT;
+}
+
+// Draws the whole map window from the background pages it overlaps.
+// The cells are then left as drawn with the first frame of their
+// background tile and no unit, so that the usual drawing only has
+// to go over the cells with units or animation.
+void Game::DRAW_PAGES()
+{
+    PAGE_WINDOW_X = MAP_WINDOW_X;
+    PAGE_WINDOW_Y = MAP_WINDOW_Y;
+    uint16_t RIGHT = MAP_WINDOW_X + PLATFORM_MAP_WINDOW_TILES_WIDTH;
+    uint16_t BOTTOM = MAP_WINDOW_Y + PLATFORM_MAP_WINDOW_TILES_HEIGHT;
+    for (uint16_t Y = MAP_WINDOW_Y, NEXT_Y; Y != BOTTOM; Y = NEXT_Y) {
+        NEXT_Y = MIN((Y / PLATFORM_PAGE_TILES_HEIGHT + 1) * PLATFORM_PAGE_TILES_HEIGHT, BOTTOM);
+        for (uint16_t X = MAP_WINDOW_X, NEXT_X; X != RIGHT; X = NEXT_X) {
+            NEXT_X = MIN((X / PLATFORM_PAGE_TILES_WIDTH + 1) * PLATFORM_PAGE_TILES_WIDTH, RIGHT);
+            uint8_t SLOT = FIND_PAGE((Y / PLATFORM_PAGE_TILES_HEIGHT) * PAGE_COLUMNS + X / PLATFORM_PAGE_TILES_WIDTH);
+            platform->renderPage(SLOT, (X % PLATFORM_PAGE_TILES_WIDTH) * 24, (Y % PLATFORM_PAGE_TILES_HEIGHT) * 24,
+                (X - MAP_WINDOW_X) * 24, (Y - MAP_WINDOW_Y) * 24, (NEXT_X - X) * 24, (NEXT_Y - Y) * 24);
+        }
+    }
+    for (uint16_t Y = 0, CELL = 0; Y != PLATFORM_MAP_WINDOW_TILES_HEIGHT; Y++) {
+        for (uint16_t X = 0; X != PLATFORM_MAP_WINDOW_TILES_WIDTH; X++, CELL++) {
+            uint8_t BACKGROUND = MAP[MAP_CELL(MAP_WINDOW_X + X, MAP_WINDOW_Y + Y)];
+            // The cinema screen has text drawn over it with the tile
+            PREVIOUS_MAP_BACKGROUND[CELL] = BACKGROUND >= 20 && BACKGROUND <= 22 ? 255 : BACKGROUND;
+            PREVIOUS_MAP_BACKGROUND_VARIANT[CELL] = 0;
+            PREVIOUS_MAP_FOREGROUND[CELL] = 0;
+            PREVIOUS_MAP_FOREGROUND_VARIANT[CELL] = 0;
+        }
+    }
+}
+
+void Game::REPORT_PAGES()
+{
+    uint32_t USES = PAGE_HITS + PAGE_MISSES + PAGE_REBUILDS;
+    debug("Background pages: %lu of %lux%lu tiles, %lu%% of %lu uses hit, %lu missed, %lu rebuilt after a tile changed\n",
+        (uint32_t)PAGE_COUNT, (uint32_t)PLATFORM_PAGE_TILES_WIDTH, (uint32_t)PLATFORM_PAGE_TILES_HEIGHT,
+        USES != 0 ? PAGE_HITS * 100 / USES : 0, USES, PAGE_MISSES, PAGE_REBUILDS);
 }
 
-void DRAW_MAP_WINDOW()
+void Game::DRAW_MAP_WINDOW()
 {
     MAP_PRE_CALCULATE();
+    if (PAGE_COUNT != 0 && (PAGE_WINDOW_X != MAP_WINDOW_X || PAGE_WINDOW_Y != MAP_WINDOW_Y)) {
+        DRAW_PAGES();
+    }
     REDRAW_WINDOW = 0;
-    MAP_SOURCE = MAP + ((MAP_WINDOW_Y << 7) + MAP_WINDOW_X);
+    ANIMATE_WINDOW = 0;
+    ANIMATED_CELL_COUNT = 0;
+    ANIMATED_CELLS_X = MAP_WINDOW_X;
+    ANIMATED_CELLS_Y = MAP_WINDOW_Y;
 #if (MAP_WINDOW_SIZE == 77)
-    for (uint8_t TEMP_Y = 0, PRECALC_COUNT = 0; TEMP_Y != PLATFORM_MAP_WINDOW_TILES_HEIGHT; TEMP_Y++, MAP_SOURCE += 128 - PLATFORM_MAP_WINDOW_TILES_WIDTH) {
-        for (uint8_t TEMP_X = 0; TEMP_X != PLATFORM_MAP_WINDOW_TILES_WIDTH; TEMP_X++, MAP_SOURCE++, PRECALC_COUNT++) {
+    for (uint8_t TEMP_Y = 0, PRECALC_COUNT = 0; TEMP_Y != PLATFORM_MAP_WINDOW_TILES_HEIGHT; TEMP_Y++) {
+        for (uint8_t TEMP_X = 0; TEMP_X != PLATFORM_MAP_WINDOW_TILES_WIDTH; TEMP_X++, PRECALC_COUNT++) {
 #else
-    for (uint16_t TEMP_Y = 0, PRECALC_COUNT = 0; TEMP_Y != PLATFORM_MAP_WINDOW_TILES_HEIGHT; TEMP_Y++, MAP_SOURCE += 128 - PLATFORM_MAP_WINDOW_TILES_WIDTH, PRECALC_COUNT += PLATFORM_MAP_WINDOW_TILES_WIDTH - PLATFORM_MAP_WINDOW_TILES_WIDTH) {
-        for (uint16_t TEMP_X = 0; TEMP_X != PLATFORM_MAP_WINDOW_TILES_WIDTH; TEMP_X++, MAP_SOURCE++, PRECALC_COUNT++) {
+    for (uint16_t TEMP_Y = 0, PRECALC_COUNT = 0; TEMP_Y != PLATFORM_MAP_WINDOW_TILES_HEIGHT; TEMP_Y++) {
+        for (uint16_t TEMP_X = 0; TEMP_X != PLATFORM_MAP_WINDOW_TILES_WIDTH; TEMP_X++, PRECALC_COUNT++) {
 #endif
             // NOW FIGURE OUT WHERE TO PLACE IT ON SCREEN.
+            MAP_SOURCE = MAP + MAP_CELL(MAP_WINDOW_X + TEMP_X, MAP_WINDOW_Y + TEMP_Y);
             TILE = MAP_SOURCE[0];
             uint8_t VARIANT = 0;
-            switch (TILE) {
-            case 204: // WATER
-            case 66:  // FLAG
-            case 148: // TRASH COMPACTOR
-            case 143: // SERVER
-                VARIANT = ANIM_STATE & 3;
-                break;
-            case 196: // HVAC
-            case 197:
-            case 200:
-            case 201:
-                VARIANT = ANIM_STATE & 1;
+            // The player and the transporter effect animate independently of the window
+            if (ANIMATED_TILE(VARIANT) || MAP_PRECALC[PRECALC_COUNT] == 96 || MAP_PRECALC[PRECALC_COUNT] == 243) {
+                ANIMATED_CELLS[ANIMATED_CELL_COUNT++] = PRECALC_COUNT;
+            }
+            uint8_t FG_VARIANT = 0;
+            uint8_t FG_TILE = FOREGROUND_TILE(PRECALC_COUNT, FG_VARIANT);
+            DRAW_MAP_CELL(TEMP_X, TEMP_Y, PRECALC_COUNT, VARIANT, FG_TILE, FG_VARIANT);
+        }
+    }
+}
+
+// Gets the animation frame of the background tile in TILE.
+// Returns false if the tile is not animated.
+bool Game::ANIMATED_TILE(uint8_t& VARIANT)
+{
+    switch (TILE) {
+    case 204: // WATER
+    case 66:  // FLAG
+    case 148: // TRASH COMPACTOR
+    case 143: // SERVER
+        VARIANT = ANIM_STATE & 3;
+        return true;
+    case 196: // HVAC
+    case 197:
+    case 200:
+    case 201:
+        VARIANT = ANIM_STATE & 1;
+        return true;
+    case 20: // CINEMA
+    case 21:
+    case 22:
+        VARIANT = ANIM_STATE;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Gets the unit tile to be drawn over the background of a map
+// window cell and its variant
+uint8_t Game::FOREGROUND_TILE(uint16_t CELL, uint8_t& FG_VARIANT)
+{
+    uint8_t FG_TILE = MAP_PRECALC[CELL];
+    if (FG_TILE != 0) {
+        DIRECTION = MAP_PRECALC_DIRECTION[CELL];
+        if (FG_TILE == 96 || (FG_TILE >= 100 && FG_TILE <= 103)) { // PLAYER OR EVILBOT
+            if (DIRECTION == 0) {
+                FG_VARIANT = 8;
+            } else if (DIRECTION == 2) {
+                FG_VARIANT = 12;
+            } else if (DIRECTION == 3) {
+                FG_VARIANT = 4;
+            }
+            if (FG_TILE == 96) {
+                FG_VARIANT += WALK_FRAME + (SELECTED_WEAPON << 4);
+            }
+        } else if (FG_TILE == 243) { // TRANSPORT
+            if (DEMATERIALIZE_FRAME < 7) {
+                FG_VARIANT = DEMATERIALIZE_FRAME;
+            } else {
+                FG_TILE = 0;
+            }
+        } else if (FG_TILE == 115) { // DEAD ROBOT
+            switch (MAP_PRECALC_TYPE[CELL]) {
+            case 17:
+            case 18:
+                FG_VARIANT = 1;
                 break;
-            case 20: // CINEMA
-            case 21:
-            case 22:
-                VARIANT = ANIM_STATE;
+            case 9:
+                FG_VARIANT = 2;
                 break;
             default:
                 break;
             }
-            uint8_t FG_TILE = MAP_PRECALC[PRECALC_COUNT];
-            uint8_t FG_VARIANT = 0;
-            if (FG_TILE != 0) {
-                DIRECTION = MAP_PRECALC_DIRECTION[PRECALC_COUNT];
-                if (FG_TILE == 96 || (FG_TILE >= 100 && FG_TILE <= 103)) { // PLAYER OR EVILBOT
-                    if (DIRECTION == 0) {
-                        FG_VARIANT = 8;
-                    } else if (DIRECTION == 2) {
-                        FG_VARIANT = 12;
-                    } else if (DIRECTION == 3) {
-                        FG_VARIANT = 4;
-                    }
-                    if (FG_TILE == 96) {
-                        FG_VARIANT += WALK_FRAME + (SELECTED_WEAPON << 4);
-                    }
-                } else if (FG_TILE == 243) { // TRANSPORT
-                    if (DEMATERIALIZE_FRAME < 7) {
-                        FG_VARIANT = DEMATERIALIZE_FRAME;
-                    } else {
-                        FG_TILE = 0;
-                    }
-                } else if (FG_TILE == 115) { // DEAD ROBOT
-                    switch (MAP_PRECALC_TYPE[PRECALC_COUNT]) {
-                    case 17:
-                    case 18:
-                        FG_VARIANT = 1;
-                        break;
-                    case 9:
-                        FG_VARIANT = 2;
-                        break;
-                    default:
-                        break;
-                    }
-                }
+        }
+    }
+    return FG_TILE;
+}
+
+// Draws the background tile in TILE and the foreground tile of
+// one map window cell unless the same tiles are already there
+void Game::DRAW_MAP_CELL(uint16_t X, uint16_t Y, uint16_t CELL, uint8_t VARIANT, uint8_t FG_TILE, uint8_t FG_VARIANT)
+{
+    if (TILE != PREVIOUS_MAP_BACKGROUND[CELL] ||
+        VARIANT != PREVIOUS_MAP_BACKGROUND_VARIANT[CELL] ||
+        FG_TILE != PREVIOUS_MAP_FOREGROUND[CELL] ||
+        FG_VARIANT != PREVIOUS_MAP_FOREGROUND_VARIANT[CELL]) {
+        if (FG_TILE != 0) {
+            platform->renderTiles(TILE, FG_TILE, X * 24, Y * 24, VARIANT, FG_VARIANT);
+            PREVIOUS_MAP_BACKGROUND[CELL] = TILE;
+            PREVIOUS_MAP_BACKGROUND_VARIANT[CELL] = VARIANT;
+            PREVIOUS_MAP_FOREGROUND[CELL] = FG_TILE;
+            PREVIOUS_MAP_FOREGROUND_VARIANT[CELL] = FG_VARIANT;
+        } else {
+            platform->renderTile(TILE, X * 24, Y * 24, VARIANT);
+            PREVIOUS_MAP_BACKGROUND[CELL] = TILE;
+            PREVIOUS_MAP_BACKGROUND_VARIANT[CELL] = VARIANT;
+            PREVIOUS_MAP_FOREGROUND[CELL] = FG_TILE;
+            PREVIOUS_MAP_FOREGROUND_VARIANT[CELL] = FG_VARIANT;
+
+            switch (TILE) {
+            case 20: {
+                platform->waitForScreenMemoryAccess();
+                platform->writeToScreenMemory(MAP_CHART[Y] + X + X + X + SCREEN_WIDTH_IN_CHARACTERS + 1, CINEMA_MESSAGE[CINEMA_STATE], 1, 0);
+                platform->writeToScreenMemory(MAP_CHART[Y] + X + X + X + SCREEN_WIDTH_IN_CHARACTERS + 2, CINEMA_MESSAGE[CINEMA_STATE + 1], 1, 0);
+                break;
             }
-            if (TILE != PREVIOUS_MAP_BACKGROUND[PRECALC_COUNT] ||
-                VARIANT != PREVIOUS_MAP_BACKGROUND_VARIANT[PRECALC_COUNT] ||
-                FG_TILE != PREVIOUS_MAP_FOREGROUND[PRECALC_COUNT] ||
-                FG_VARIANT != PREVIOUS_MAP_FOREGROUND_VARIANT[PRECALC_COUNT]) {
-                if (FG_TILE != 0) {
-                    platform->renderTiles(TILE, FG_TILE, TEMP_X * 24, TEMP_Y * 24, VARIANT, FG_VARIANT);
-                    PREVIOUS_MAP_BACKGROUND[PRECALC_COUNT] = TILE;
-                    PREVIOUS_MAP_BACKGROUND_VARIANT[PRECALC_COUNT] = VARIANT;
-                    PREVIOUS_MAP_FOREGROUND[PRECALC_COUNT] = FG_TILE;
-                    PREVIOUS_MAP_FOREGROUND_VARIANT[PRECALC_COUNT] = FG_VARIANT;
-                } else {
-                    platform->renderTile(TILE, TEMP_X * 24, TEMP_Y * 24, VARIANT);
-                    PREVIOUS_MAP_BACKGROUND[PRECALC_COUNT] = TILE;
-                    PREVIOUS_MAP_BACKGROUND_VARIANT[PRECALC_COUNT] = VARIANT;
-                    PREVIOUS_MAP_FOREGROUND[PRECALC_COUNT] = FG_TILE;
-                    PREVIOUS_MAP_FOREGROUND_VARIANT[PRECALC_COUNT] = FG_VARIANT;
-
-                    switch (TILE) {
-                    case 20: {
-                        platform->waitForScreenMemoryAccess();
-                        platform->writeToScreenMemory(MAP_CHART[TEMP_Y] + TEMP_X + TEMP_X + TEMP_X + SCREEN_WIDTH_IN_CHARACTERS + 1, CINEMA_MESSAGE[CINEMA_STATE], 1, 0);
-                        platform->writeToScreenMemory(MAP_CHART[TEMP_Y] + TEMP_X + TEMP_X + TEMP_X + SCREEN_WIDTH_IN_CHARACTERS + 2, CINEMA_MESSAGE[CINEMA_STATE + 1], 1, 0);
-                        break;
-                    }
-                    case 21: {
-                        platform->waitForScreenMemoryAccess();
-                        platform->writeToScreenMemory(MAP_CHART[TEMP_Y] + TEMP_X + TEMP_X + TEMP_X + SCREEN_WIDTH_IN_CHARACTERS + 0, CINEMA_MESSAGE[CINEMA_STATE + 2], 1, 0);
-                        platform->writeToScreenMemory(MAP_CHART[TEMP_Y] + TEMP_X + TEMP_X + TEMP_X + SCREEN_WIDTH_IN_CHARACTERS + 1, CINEMA_MESSAGE[CINEMA_STATE + 3], 1, 0);
-                        platform->writeToScreenMemory(MAP_CHART[TEMP_Y] + TEMP_X + TEMP_X + TEMP_X + SCREEN_WIDTH_IN_CHARACTERS + 2, CINEMA_MESSAGE[CINEMA_STATE + 4], 1, 0);
-                        break;
-                    }
-                    case 22: {
-                        platform->waitForScreenMemoryAccess();
-                        platform->writeToScreenMemory(MAP_CHART[TEMP_Y] + TEMP_X + TEMP_X + TEMP_X + SCREEN_WIDTH_IN_CHARACTERS + 0, CINEMA_MESSAGE[CINEMA_STATE + 5], 1, 0);
-                        break;
-                    }
-                    default:
-                        break;
-                    }
-                }
+            case 21: {
+                platform->waitForScreenMemoryAccess();
+                platform->writeToScreenMemory(MAP_CHART[Y] + X + X + X + SCREEN_WIDTH_IN_CHARACTERS + 0, CINEMA_MESSAGE[CINEMA_STATE + 2], 1, 0);
+                platform->writeToScreenMemory(MAP_CHART[Y] + X + X + X + SCREEN_WIDTH_IN_CHARACTERS + 1, CINEMA_MESSAGE[CINEMA_STATE + 3], 1, 0);
+                platform->writeToScreenMemory(MAP_CHART[Y] + X + X + X + SCREEN_WIDTH_IN_CHARACTERS + 2, CINEMA_MESSAGE[CINEMA_STATE + 4], 1, 0);
+                break;
+            }
+            case 22: {
+                platform->waitForScreenMemoryAccess();
+                platform->writeToScreenMemory(MAP_CHART[Y] + X + X + X + SCREEN_WIDTH_IN_CHARACTERS + 0, CINEMA_MESSAGE[CINEMA_STATE + 5], 1, 0);
+                break;
+            }
+            default:
+                break;
             }
         }
     }
 }
 
-void TOGGLE_LIVE_MAP()
+// Redraws only the cells of the map window that change without the
+// window scrolling or the units moving: the tiles written to the map
+// journal and the animated cells. The cell list is rebuilt by every
+// full redraw, which also happens when the window has scrolled since.
+void Game::DRAW_MAP_CHANGES()
+{
+    if (MAP_JOURNAL_OVERFLOW == 1 || ANIMATED_CELLS_X != MAP_WINDOW_X || ANIMATED_CELLS_Y != MAP_WINDOW_Y) {
+        DRAW_MAP_WINDOW();
+        return;
+    }
+    ANIMATE_WINDOW = 0;
+    MAP_PRE_CALCULATE();
+    bool NEW_ANIMATED_CELL = false;
+    for (uint16_t i = 0; i != MAP_JOURNAL_COUNT; i++) {
+        uint16_t X = MAP_JOURNAL[i].x - MAP_WINDOW_X;
+        uint16_t Y = MAP_JOURNAL[i].y - MAP_WINDOW_Y;
+        if (X >= PLATFORM_MAP_WINDOW_TILES_WIDTH || Y >= PLATFORM_MAP_WINDOW_TILES_HEIGHT) {
+            continue;
+        }
+        uint16_t CELL = Y * PLATFORM_MAP_WINDOW_TILES_WIDTH + X;
+        TILE = MAP[MAP_CELL(MAP_JOURNAL[i].x, MAP_JOURNAL[i].y)];
+        uint8_t VARIANT = 0;
+        if (ANIMATED_TILE(VARIANT)) {
+            NEW_ANIMATED_CELL = true;
+        }
+        uint8_t FG_VARIANT = 0;
+        uint8_t FG_TILE = FOREGROUND_TILE(CELL, FG_VARIANT);
+        DRAW_MAP_CELL(X, Y, CELL, VARIANT, FG_TILE, FG_VARIANT);
+    }
+    for (uint16_t i = 0; i != ANIMATED_CELL_COUNT; i++) {
+        uint16_t CELL = ANIMATED_CELLS[i];
+        uint16_t X = CELL % PLATFORM_MAP_WINDOW_TILES_WIDTH;
+        uint16_t Y = CELL / PLATFORM_MAP_WINDOW_TILES_WIDTH;
+        TILE = MAP[MAP_CELL(MAP_WINDOW_X + X, MAP_WINDOW_Y + Y)];
+        uint8_t VARIANT = 0;
+        ANIMATED_TILE(VARIANT);
+        // The units in the window haven't moved, or there would be a full redraw
+        uint8_t FG_VARIANT = 0;
+        uint8_t FG_TILE = FOREGROUND_TILE(CELL, FG_VARIANT);
+        DRAW_MAP_CELL(X, Y, CELL, VARIANT, FG_TILE, FG_VARIANT);
+    }
+    if (NEW_ANIMATED_CELL) {
+        // Have the animated cells collected again by the next redraw
+        ANIMATED_CELLS_X = (map_coord_t)-1;
+    }
+}
+
+void Game::TOGGLE_LIVE_MAP()
 {
     if (LIVE_MAP_ON != 1) {
         LIVE_MAP_ON = 1;
 
-        platform->renderLiveMap(MAP);
+        RENDER_LIVE_MAP();
     } else {
         LIVE_MAP_ON = 0;
 
@@ -1534,27 +1728,63 @@ void TOGGLE_LIVE_MAP()
     REDRAW_WINDOW = 1;
 }
 
-void TOGGLE_LIVE_MAP_ROBOTS()
+void Game::TOGGLE_LIVE_MAP_ROBOTS()
 {
     LIVE_MAP_ROBOTS_ON = LIVE_MAP_ROBOTS_ON == 1 ? 0 : 1;
 }
 
-void DRAW_LIVE_MAP()
+void Game::DRAW_LIVE_MAP()
 {
-    platform->renderLiveMapUnits(MAP, UNIT_TYPE, UNIT_LOC_X, UNIT_LOC_Y, LIVE_MAP_PLAYER_BLINK < 128 ? 1 : 0, LIVE_MAP_ROBOTS_ON == 1 ? true : false);
+    if (MAP_JOURNAL_OVERFLOW == 1) {
+        RENDER_LIVE_MAP();
+    } else {
+        for (uint16_t i = 0; i != MAP_JOURNAL_COUNT; i++) {
+            RENDER_LIVE_MAP_TILE(MAP_JOURNAL[i].x, MAP_JOURNAL[i].y);
+        }
+    }
+    platform->renderLiveMapUnits(LIVE_MAP_VIEW(), UNIT_TYPE, UNIT_LOC_X, UNIT_LOC_Y, UNIT_WEAPONS, UNIT_HIDDEN, LIVE_MAP_PLAYER_BLINK < 128 ? 1 : 0, LIVE_MAP_ROBOTS_ON == 1 ? true : false);
 
     LIVE_MAP_PLAYER_BLINK += 10;
 }
 
-uint8_t LIVE_MAP_ON = 0;
-uint8_t LIVE_MAP_ROBOTS_ON = 0;
-uint8_t LIVE_MAP_PLAYER_BLINK = 0;
+// The tiles shown on the live map, LIVE_MAP_WIDTH to a row
+uint8_t* Game::LIVE_MAP_VIEW()
+{
+#ifdef LIVE_MAP_COPY
+    return LIVE_MAP_TILES;
+#else
+    return MAP;
+#endif
+}
+
+void Game::RENDER_LIVE_MAP()
+{
+#ifdef LIVE_MAP_COPY
+    for (uint16_t Y = 0; Y != LIVE_MAP_HEIGHT; Y++) {
+        for (uint16_t X = 0; X != LIVE_MAP_WIDTH; X++) {
+            LIVE_MAP_TILES[Y * LIVE_MAP_WIDTH + X] = X < PLATFORM_MAP_WIDTH && Y < PLATFORM_MAP_HEIGHT ? MAP[MAP_CELL(X, Y)] : 0;
+        }
+    }
+#endif
+    platform->renderLiveMap(LIVE_MAP_VIEW());
+}
+
+void Game::RENDER_LIVE_MAP_TILE(uint16_t X, uint16_t Y)
+{
+    if (X >= LIVE_MAP_WIDTH || Y >= LIVE_MAP_HEIGHT) {
+        return;
+    }
+#ifdef LIVE_MAP_COPY
+    LIVE_MAP_TILES[Y * LIVE_MAP_WIDTH + X] = MAP[MAP_CELL(X, Y)];
+#endif
+    platform->renderLiveMapTile(LIVE_MAP_VIEW(), X, Y);
+}
 
 // This routine plots a 3x3 tile from the tile database anywhere
 // on screen.  But first you must define the tile number in the
 // TILE variable, as well as the starting screen address must
 // be defined in $FB.
-void PLOT_TILE(uint16_t destination, uint16_t x, uint16_t y)
+void Game::PLOT_TILE(uint16_t destination, uint16_t x, uint16_t y)
 {
     platform->renderTile(TILE, x * 24, y * 24);
 }
@@ -1565,7 +1795,7 @@ void PLOT_TILE(uint16_t destination, uint16_t x, uint16_t y)
 // be defined in $FB.  Also, this routine is slower than the usual
 // tile routine, so is only used for sprites.  The ":" character ($3A)
 // is not drawn.
-void PLOT_TRANSPARENT_TILE(uint16_t destination, uint16_t x, uint16_t y)
+void Game::PLOT_TRANSPARENT_TILE(uint16_t destination, uint16_t x, uint16_t y)
 {
     uint8_t variant = 0;
     if (TILE == 96 || (TILE >= 100 && TILE <= 103)) {
@@ -1586,7 +1816,7 @@ void PLOT_TRANSPARENT_TILE(uint16_t destination, uint16_t x, uint16_t y)
 // This routine checks to see if UNIT is occupying any space
 // that is currently visible in the window.  If so, the
 // flag for redrawing the window will be set.
-void CHECK_FOR_WINDOW_REDRAW()
+void Game::CHECK_FOR_WINDOW_REDRAW()
 {
     if (UNIT_LOC_X[UNIT] >= MAP_WINDOW_X && // FIRST CHECK HORIZONTAL
         UNIT_LOC_X[UNIT] <= (MAP_WINDOW_X + PLATFORM_MAP_WINDOW_TILES_WIDTH - 1) &&
@@ -1596,7 +1826,7 @@ void CHECK_FOR_WINDOW_REDRAW()
     }
 }
 
-void DECWRITE(uint16_t destination, uint8_t color)
+void Game::DECWRITE(uint16_t destination, uint8_t color)
 {
     for (int X = 2; X >= 0; X--) {
         writeToScreenMemory(destination + X, 0x30 + (DECNUM % 10), color);
@@ -1605,7 +1835,7 @@ void DECWRITE(uint16_t destination, uint8_t color)
 }
 
 // The following routine loads the tileset from disk
-void TILE_LOAD_ROUTINE()
+void Game::TILE_LOAD_ROUTINE()
 {
     uint8_t* tileset = platform->loadTileset(TILENAME);
     DESTRUCT_PATH = tileset + 2 + 0 * 256;
@@ -1613,13 +1843,155 @@ void TILE_LOAD_ROUTINE()
     platform->generateTiles(0, TILE_ATTRIB);
 }
 
-// The following routine loads the map from disk
-void MAP_LOAD_ROUTINE()
+// The following routine loads the map from disk.
+// Returns false if the map couldn't be loaded.
+bool Game::MAP_LOAD_ROUTINE()
+{
+    uint32_t size = platform->finishPrefetch(MAPNAME);
+    if (size == 0) {
+        size = platform->load(MAPNAME, MAP_FILE_BUFFER, MAP_FILE_MAX_SIZE);
+    }
+    uint8_t RESULT = UNPACK_MAP(MAP_FILE_BUFFER, size);
+    if (RESULT == MAP_INVALID) {
+        debug("Map %s couldn't be loaded\n", MAPNAME);
+        return false;
+    }
+    MAP_JOURNAL_OVERFLOW = 1; // The whole map is new
+    RESET_PAGES();
+    BUILD_MAP_PLANES();
+    BUILD_UNIT_SLOTS();
+    if (RESULT != MAP_INDEXED) {
+        BUILD_LEVEL_INDEX();
+    }
+    return true;
+}
+
+void Game::SET_MAP_DATA(uint8_t* data)
+{
+    MAP_DATA = data;
+    UNIT_TYPE = MAP_DATA;
+    UNIT_LOC_X = MAP_DATA + 1 * UNIT_COUNT;
+    UNIT_LOC_Y = MAP_DATA + 2 * UNIT_COUNT;
+    UNIT_A = MAP_DATA + 3 * UNIT_COUNT;
+    UNIT_B = MAP_DATA + 4 * UNIT_COUNT;
+    UNIT_C = MAP_DATA + 5 * UNIT_COUNT;
+    UNIT_D = MAP_DATA + 6 * UNIT_COUNT;
+    UNIT_HEALTH = (int8_t*)MAP_DATA + 7 * UNIT_COUNT;
+    MAP = MAP_DATA + 8 * UNIT_COUNT + 256;
+}
+
+// Copies the units of each range of a map file to the start of the
+// same range of the unit table. Units that don't fit are left out.
+// The map is copied to the top left corner, leaving out what doesn't fit.
+// Returns MAP_INDEXED if the level index was read from the file as well,
+// or MAP_INVALID without changing anything if the file is shorter than
+// its header says or doesn't fit.
+uint8_t Game::UNPACK_MAP(uint8_t* file, uint32_t size)
+{
+    uint8_t UNITS_IN_FILE[UNIT_RANGES] = { 27, 4, 16, 16 };
+    uint16_t FILE_WIDTH = 128;
+    uint16_t FILE_HEIGHT = 64;
+    uint8_t VERSION = 0;
+    uint8_t HEADER = 0;
+    uint8_t* END = file + size;
+    if (size >= MAP_EXTENDED_HEADER_SIZE && file[0] == 'P' && file[1] == 'R' && file[2] == 'X' &&
+        file[3] >= 1 && file[3] <= MAP_EXTENDED_VERSION) {
+        VERSION = file[3];
+        for (uint8_t RANGE = 0; RANGE != UNIT_RANGES; RANGE++) {
+            UNITS_IN_FILE[RANGE] = file[4 + RANGE];
+        }
+        if (VERSION == 1) {
+            HEADER = 8;
+        } else {
+            FILE_WIDTH = file[8] | (file[9] << 8);
+            FILE_HEIGHT = file[10] | (file[11] << 8);
+            HEADER = MAP_EXTENDED_HEADER_SIZE;
+        }
+        file += HEADER;
+    }
+    uint16_t FILE_UNITS = 1 + UNITS_IN_FILE[0] + UNITS_IN_FILE[1] + UNITS_IN_FILE[2] + UNITS_IN_FILE[3];
+    uint32_t FILE_SIZE = HEADER + 8 * FILE_UNITS + 256 + (uint32_t)FILE_WIDTH * FILE_HEIGHT;
+    if (FILE_SIZE > MAP_FILE_MAX_SIZE) {
+        debug("Map %s with %d units and %dx%d tiles doesn't fit\n", MAPNAME, FILE_UNITS, FILE_WIDTH, FILE_HEIGHT);
+        return MAP_INVALID;
+    }
+    if (FILE_SIZE > size) {
+        debug("Map %s is %lu bytes, %lu expected\n", MAPNAME, (unsigned long)size, (unsigned long)FILE_SIZE);
+        return MAP_INVALID;
+    }
+    if (FILE_WIDTH > PLATFORM_MAP_WIDTH || FILE_HEIGHT > PLATFORM_MAP_HEIGHT) {
+        debug("Map %s is %dx%d tiles, only %dx%d fit\n", MAPNAME, FILE_WIDTH, FILE_HEIGHT, PLATFORM_MAP_WIDTH, PLATFORM_MAP_HEIGHT);
+    }
+    for (uint8_t RANGE = 0; RANGE != UNIT_RANGES; RANGE++) {
+        uint8_t SLOTS = UNIT_RANGE_START[RANGE + 1] - UNIT_RANGE_START[RANGE];
+        if (UNITS_IN_FILE[RANGE] > SLOTS) {
+            debug("Map %s has %d units in range %d, only %d fit\n", MAPNAME, UNITS_IN_FILE[RANGE], RANGE, SLOTS);
+        }
+    }
+    for (uint8_t ARRAY = 0; ARRAY != 8; ARRAY++) {
+        uint8_t* FROM = file + ARRAY * FILE_UNITS;
+        uint8_t* TO = MAP_DATA + ARRAY * UNIT_COUNT;
+        TO[0] = FROM[0]; // player
+        FROM++;
+        for (uint8_t RANGE = 0; RANGE != UNIT_RANGES; RANGE++) {
+            uint8_t X = UNIT_RANGE_START[RANGE];
+            for (uint8_t I = 0; I != UNITS_IN_FILE[RANGE]; I++) {
+                if (X != UNIT_RANGE_START[RANGE + 1]) {
+                    TO[X++] = FROM[I];
+                }
+            }
+            while (X != UNIT_RANGE_START[RANGE + 1]) {
+                TO[X++] = 0;
+            }
+            FROM += UNITS_IN_FILE[RANGE];
+        }
+    }
+    uint8_t* FROM = file + 8 * FILE_UNITS;
+    for (int i = 0; i != 256; i++) {
+        MAP_DATA[8 * UNIT_COUNT + i] = FROM[i];
+    }
+    FROM += 256;
+    for (uint16_t Y = 0; Y != PLATFORM_MAP_HEIGHT; Y++) {
+        for (uint16_t X = 0; X != PLATFORM_MAP_WIDTH; X++) {
+            MAP[MAP_CELL(X, Y)] = X < FILE_WIDTH && Y < FILE_HEIGHT ? FROM[Y * FILE_WIDTH + X] : 0;
+        }
+    }
+    FROM += (uint32_t)FILE_WIDTH * FILE_HEIGHT;
+    uint16_t FILE_WORDS = (FILE_WIDTH + 31) / 32;
+    if (VERSION < 3 || FROM >= END || END - FROM < 1 + FROM[0] + 4 * FILE_WORDS * FILE_HEIGHT) {
+        return MAP_UNINDEXED;
+    }
+    for (int FLOOR = 0; FLOOR != 256; FLOOR++) {
+        ELEVATOR_UNIT[FLOOR] = 255;
+    }
+    uint8_t FLOORS = *FROM++;
+    for (uint8_t FLOOR = 0; FLOOR != FLOORS; FLOOR++) {
+        uint8_t I = *FROM++;
+        if (I != 255) {
+            if (I >= UNIT_HIDDEN - UNIT_DOORS) {
+                return MAP_UNINDEXED; // The elevator was left out
+            }
+            ELEVATOR_UNIT[FLOOR] = UNIT_DOORS + I;
+        }
+    }
+    for (uint16_t Y = 0; Y != PLATFORM_MAP_HEIGHT; Y++) {
+        for (uint16_t WORD = 0; WORD != PLANE_ROW_WORDS; WORD++) {
+            uint8_t* BYTES = FROM + 4 * (Y * FILE_WORDS + WORD);
+            HIDDEN_PLANE[Y][WORD] = Y < FILE_HEIGHT && WORD < FILE_WORDS ?
+                BYTES[0] | (BYTES[1] << 8) | (BYTES[2] << 16) | ((uint32_t)BYTES[3] << 24) : 0;
+        }
+    }
+    return MAP_INDEXED;
+}
+
+// Starts loading the selected map and its music in the background
+// while the player is still on the intro screen
+void Game::PREFETCH_LEVEL()
 {
-    platform->load(MAPNAME, UNIT_TYPE, 8960);
+    platform->prefetch(MAPNAME, MAP_FILE_BUFFER, MAP_FILE_MAX_SIZE, MUSIC_ON == 1 ? LEVEL_MUSIC[SELECTED_MAP] : Platform::ModuleSoundFX);
 }
 
-void DISPLAY_GAME_SCREEN()
+void Game::DISPLAY_GAME_SCREEN()
 {
     platform->displayImage(Platform::ImageGame);
 
@@ -1636,7 +2008,7 @@ char INTRO_OPTIONS[] = "start game"
                        "difficulty"
                        "controls  ";
 
-void DISPLAY_INTRO_SCREEN()
+void Game::DISPLAY_INTRO_SCREEN()
 {
     uint8_t* row = SCREEN_MEMORY + MENU_CHART[0];
     for (int Y = 0, i = 0; Y < 3; Y++, row += SCREEN_WIDTH_IN_CHARACTERS) {
@@ -1647,7 +2019,7 @@ void DISPLAY_INTRO_SCREEN()
     platform->displayImage(Platform::ImageIntro);
 }
 
-void DISPLAY_ENDGAME_SCREEN()
+void Game::DISPLAY_ENDGAME_SCREEN()
 {
     int X;
     platform->displayImage(Platform::ImageGameOver);
@@ -1667,20 +2039,10 @@ void DISPLAY_ENDGAME_SCREEN()
     writeToScreenMemory(9 * SCREEN_WIDTH_IN_CHARACTERS + 24, 58, 4); // COLON
     writeToScreenMemory(9 * SCREEN_WIDTH_IN_CHARACTERS + 27, 58, 4);
     // count robots remaining
-    DECNUM = 0;
-    for (X = 1; X != 28; X++) {
-        if (UNIT_TYPE[X] != 0) {
-            DECNUM++;
-        }
-    }
+    DECNUM = RANGE_UNITS[RANGE_ROBOTS];
     DECWRITE(11 * SCREEN_WIDTH_IN_CHARACTERS + 22, 4);
     // Count secrets remaining
-    DECNUM = 0;
-    for (X = 48; X != 64; X++) {
-        if (UNIT_TYPE[X] != 0) {
-            DECNUM++;
-        }
-    }
+    DECNUM = RANGE_UNITS[RANGE_HIDDEN];
     DECWRITE(13 * SCREEN_WIDTH_IN_CHARACTERS + 22, 4);
     // display difficulty level
     char* WORD = DIFF_LEVEL_WORDS + (DIFF_LEVEL * 6);
@@ -1694,7 +2056,7 @@ char DIFF_LEVEL_WORDS[] = "easy  "
                           "hard  "
 ;
 
-void DECOMPRESS_SCREEN(uint8_t* source, uint8_t color)
+void Game::DECOMPRESS_SCREEN(uint8_t* source, uint8_t color)
 {
     uint16_t destination = 0;
 
@@ -1720,9 +2082,7 @@ void DECOMPRESS_SCREEN(uint8_t* source, uint8_t color)
     }
 }
 
-uint8_t RPT = 0; // repeat value
-
-void DISPLAY_PLAYER_HEALTH()
+void Game::DISPLAY_PLAYER_HEALTH()
 {
     TEMP_A = UNIT_HEALTH[0] >> 1; // No index needed because it is the player, divide by two
     int Y = 0;
@@ -1740,7 +2100,7 @@ void DISPLAY_PLAYER_HEALTH()
     platform->renderHealth(health, PLATFORM_SCREEN_WIDTH - 48, 131 + (health >> 1));
 }
 
-void CYCLE_ITEM()
+void Game::CYCLE_ITEM()
 {
     PLAY_SOUND(13); // CHANGE-ITEM-SOUND, SOUND PLAY
     if (SELECT_TIMEOUT != 0) {
@@ -1755,7 +2115,7 @@ void CYCLE_ITEM()
     DISPLAY_ITEM();
 }
 
-void DISPLAY_ITEM()
+void Game::DISPLAY_ITEM()
 {
     PRESELECT_ITEM();
     while (SELECTED_ITEM != 0) {
@@ -1800,7 +2160,7 @@ void DISPLAY_ITEM()
 // item is zero.  And if it is, then it checks inventories
 // of other items to decide which item to automatically
 // select for the user.
-void PRESELECT_ITEM()
+void Game::PRESELECT_ITEM()
 {
     if (SELECTED_ITEM != 0) { // If item already selected, return
         return;
@@ -1827,40 +2187,40 @@ void PRESELECT_ITEM()
     DISPLAY_BLANK_ITEM();
 }
 
-void DISPLAY_TIMEBOMB()
+void Game::DISPLAY_TIMEBOMB()
 {
     platform->renderItem(5, PLATFORM_SCREEN_WIDTH - 48, 54);
     DECNUM = INV_BOMBS;
     DECWRITE(11 * SCREEN_WIDTH_IN_CHARACTERS - 3, 1);
 }
 
-void DISPLAY_EMP()
+void Game::DISPLAY_EMP()
 {
     platform->renderItem(3, PLATFORM_SCREEN_WIDTH - 48, 54);
     DECNUM = INV_EMP;
     DECWRITE(11 * SCREEN_WIDTH_IN_CHARACTERS - 3, 1);
 }
 
-void DISPLAY_MEDKIT()
+void Game::DISPLAY_MEDKIT()
 {
     platform->renderItem(2, PLATFORM_SCREEN_WIDTH - 48, 54);
     DECNUM = INV_MEDKIT;
     DECWRITE(11 * SCREEN_WIDTH_IN_CHARACTERS - 3, 1);
 }
 
-void DISPLAY_MAGNET()
+void Game::DISPLAY_MAGNET()
 {
     platform->renderItem(4, PLATFORM_SCREEN_WIDTH - 48, 54);
     DECNUM = INV_MAGNET;
     DECWRITE(11 * SCREEN_WIDTH_IN_CHARACTERS - 3, 1);
 }
 
-void DISPLAY_BLANK_ITEM()
+void Game::DISPLAY_BLANK_ITEM()
 {
     platform->clearRect(PLATFORM_SCREEN_WIDTH - 48, 48, 48, 40);
 }
 
-void CYCLE_WEAPON()
+void Game::CYCLE_WEAPON()
 {
     PLAY_SOUND(12); // CHANGE WEAPON-SOUND, SOUND PLAY
     if (SELECT_TIMEOUT != 0) {
@@ -1876,7 +2236,7 @@ void CYCLE_WEAPON()
     DISPLAY_WEAPON();
 }
 
-void DISPLAY_WEAPON()
+void Game::DISPLAY_WEAPON()
 {
     while (!platform->quit) {
         PRESELECT_WEAPON();
@@ -1905,7 +2265,7 @@ void DISPLAY_WEAPON()
 // weapon is zero.  And if it is, then it checks inventories
 // of other weapons to decide which item to automatically
 // select for the user.
-void PRESELECT_WEAPON()
+void Game::PRESELECT_WEAPON()
 {
     if (SELECTED_WEAPON != 0) { // If item already selected, return
         return;
@@ -1924,26 +2284,26 @@ void PRESELECT_WEAPON()
     DISPLAY_BLANK_WEAPON();
 }
 
-void DISPLAY_PLASMA_GUN()
+void Game::DISPLAY_PLASMA_GUN()
 {
     platform->renderItem(1, PLATFORM_SCREEN_WIDTH - 48, 13);
     DECNUM = AMMO_PLASMA;
     DECWRITE(5 * SCREEN_WIDTH_IN_CHARACTERS - 3, 1);
 }
 
-void DISPLAY_PISTOL()
+void Game::DISPLAY_PISTOL()
 {
     platform->renderItem(0, PLATFORM_SCREEN_WIDTH - 48, 13);
     DECNUM = AMMO_PISTOL;
     DECWRITE(5 * SCREEN_WIDTH_IN_CHARACTERS - 3, 1);
 }
 
-void DISPLAY_BLANK_WEAPON()
+void Game::DISPLAY_BLANK_WEAPON()
 {
     platform->clearRect(PLATFORM_SCREEN_WIDTH - 48, 8, 48, 32);
 }
 
-void DISPLAY_KEYS()
+void Game::DISPLAY_KEYS()
 {
     platform->clearRect(PLATFORM_SCREEN_WIDTH - 48, 106, 48, 14); // ERASE ALL 3 SPOTS
     if (KEYS & 0x01) { // %00000001 Spade key
@@ -1957,7 +2317,7 @@ void DISPLAY_KEYS()
     }
 }
 
-void GAME_OVER()
+void Game::GAME_OVER()
 {
     platform->renderFrame();
     // stop game clock
@@ -1970,9 +2330,7 @@ void GAME_OVER()
         KEYTIMER = 100;
     }
     while (KEYTIMER != 0) {
-        if (BGTIMER1 != 1) {
-            platform->renderFrame(true);
-        }
+        WAIT_FOR_TICK();
         PET_SCREEN_SHAKE();
         BACKGROUND_TASKS();
     }
@@ -1993,16 +2351,21 @@ void GAME_OVER()
     GOM4();
 }
 
-void GOM4()
+void Game::GOM4()
 {
+#ifdef PLATFORM_STATISTICS
+    REPORT_PAGES();
+#endif
     platform->clearKeyBuffer(); // CLEAR KEYBOARD BUFFER
     platform->stopModule();
     platform->startFadeScreen(0x000, 15);
-    platform->fadeScreen(0, false);
+    FADE_OUT();
+    CLEAR_INFO_QUEUE();
     DISPLAY_ENDGAME_SCREEN();
     DISPLAY_WIN_LOSE();
+    platform->prefetch(0, 0, 0, MUSIC_ON == 1 ? Platform::ModuleIntro : Platform::ModuleSoundFX);
     platform->renderFrame();
-    platform->fadeScreen(15, false);
+    FADE_IN();
     while (platform->readKeyboard() == 0xff && platform->readJoystick(CONTROL == 2 ? true : false) == 0 && !platform->quit) {
         platform->renderFrame(true);
     }
@@ -2014,7 +2377,7 @@ uint8_t GAMEOVER1[] = { 0x70, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x
 uint8_t GAMEOVER2[] = { 0x5d, 0x07, 0x01, 0x0d, 0x05, 0x20, 0x0f, 0x16, 0x05, 0x12, 0x5d };
 uint8_t GAMEOVER3[] = { 0x6d, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x7d };
 
-void DISPLAY_WIN_LOSE()
+void Game::DISPLAY_WIN_LOSE()
 {
     STOP_SONG();
     if (UNIT_TYPE[0] != 0) {
@@ -2039,7 +2402,7 @@ void DISPLAY_WIN_LOSE()
 char WIN_MSG[] = "you win!";
 char LOS_MSG[] = "you lose!";
 
-void PRINT_INTRO_MESSAGE()
+void Game::PRINT_INTRO_MESSAGE()
 {
     PRINT_INFO(INTRO_MESSAGE);
 }
@@ -2047,28 +2410,57 @@ void PRINT_INTRO_MESSAGE()
 // This routine will print something to the "information" window
 // at the bottom left of the screen.  You must first define the 
 // source of the text in $FB. The text should terminate with
-// a null character.
-void PRINT_INFO(const char *text)
+// a null character. The lines are queued and scrolled in one
+// each tick by UPDATE_TIMELINE.
+void Game::PRINT_INFO(const char *text)
 {
-    SCROLL_INFO(); // New text always causes a scroll
-    PRINTX = 0;
+    QUEUE_INFO(text); // New text always causes a scroll
     for (int Y = 0; text[Y] != 0; Y++) {
         if (text[Y] == -1) { // return
-            PRINTX = 0;
-            SCROLL_INFO();
-        } else {
-            writeToScreenMemory((SCREEN_HEIGHT_IN_CHARACTERS - 1) * SCREEN_WIDTH_IN_CHARACTERS + PRINTX, text[Y]);
-            PRINTX++;
+            QUEUE_INFO(text + Y + 1);
         }
     }
 }
 
-uint8_t PRINTX = 0; // used to store X-cursor location
+// Queues an empty line to scroll the info screen by one row
+void Game::SCROLL_INFO()
+{
+    QUEUE_INFO(0);
+}
+
+// Adds a line to the info queue. When it is full the oldest
+// line is shown right away to make room.
+void Game::QUEUE_INFO(const char *text)
+{
+    if (INFO_QUEUE_COUNT == INFO_QUEUE_SIZE) {
+        SHOW_INFO();
+    }
+    INFO_QUEUE[(INFO_QUEUE_HEAD + INFO_QUEUE_COUNT) % INFO_QUEUE_SIZE] = text;
+    INFO_QUEUE_COUNT++;
+}
+
+// Shows all the queued lines, for the routines that write to
+// the bottom row of the info screen themselves.
+void Game::FLUSH_INFO()
+{
+    while (INFO_QUEUE_COUNT != 0) {
+        SHOW_INFO();
+    }
+}
+
+void Game::CLEAR_INFO_QUEUE()
+{
+    INFO_QUEUE_HEAD = 0;
+    INFO_QUEUE_COUNT = 0;
+}
 
-// This routine scrolls the info screen by one row, clearing
-// a new row at the bottom.
-void SCROLL_INFO()
+// This routine scrolls the info screen by one row and prints
+// the oldest queued line on the new row at the bottom.
+void Game::SHOW_INFO()
 {
+    const char* text = INFO_QUEUE[INFO_QUEUE_HEAD];
+    INFO_QUEUE_HEAD = (INFO_QUEUE_HEAD + 1) % INFO_QUEUE_SIZE;
+    INFO_QUEUE_COUNT--;
     /*
     int X;
     for (X = 0; X != 33; X++) {
@@ -2083,10 +2475,30 @@ void SCROLL_INFO()
     platform->copyRect(0, PLATFORM_SCREEN_HEIGHT - 16, 0, PLATFORM_SCREEN_HEIGHT - 24, PLATFORM_SCREEN_WIDTH - 56, 16);
     // NOW CLEAR BOTTOM ROW
     platform->clearRect(0, PLATFORM_SCREEN_HEIGHT - 8, PLATFORM_SCREEN_WIDTH - 56, 8);
-    platform->renderFrame(true);
+    PRINTX = 0;
+    if (text == 0) {
+        return;
+    }
+    for (int Y = 0; text[Y] != 0 && text[Y] != -1; Y++) {
+        writeToScreenMemory((SCREEN_HEIGHT_IN_CHARACTERS - 1) * SCREEN_WIDTH_IN_CHARACTERS + PRINTX, text[Y]);
+        PRINTX++;
+    }
+}
+
+// Fades the screen out, stopping a fade in that is still going
+void Game::FADE_OUT()
+{
+    FADE_IN_LEVEL = 15;
+    platform->fadeScreen(0, false);
+}
+
+// Starts fading the screen in over the next ticks
+void Game::FADE_IN()
+{
+    FADE_IN_LEVEL = 0;
 }
 
-void RESET_KEYS_AMMO()
+void Game::RESET_KEYS_AMMO()
 {
     KEYS = 0;
     AMMO_PISTOL = 0;
@@ -2106,15 +2518,15 @@ void RESET_KEYS_AMMO()
     HOURS = 0;
 }
 
-void INTRO_SCREEN()
+void Game::INTRO_SCREEN()
 {
-    platform->fadeScreen(0, false);
+    FADE_OUT();
     DISPLAY_INTRO_SCREEN();
+    START_INTRO_MUSIC();
     DISPLAY_MAP_NAME();
     CHANGE_DIFFICULTY_LEVEL();
-    START_INTRO_MUSIC();
     platform->show();
-    platform->fadeScreen(15, false);
+    FADE_IN();
     MENUY = 0;
     REVERSE_MENU_OPTION(true);
     platform->renderFrame();
@@ -2148,18 +2560,19 @@ void INTRO_SCREEN()
                     MUSIC_ON = 1;
                 }
                 START_INTRO_MUSIC();
+                PREFETCH_LEVEL();
             }
         }
         platform->renderFrame(true);
     }
 }
 
-void START_INTRO_MUSIC()
+void Game::START_INTRO_MUSIC()
 {
     platform->playModule(MUSIC_ON == 1 ? Platform::ModuleIntro : Platform::ModuleSoundFX);
 }
 
-bool EXEC_COMMAND()
+bool Game::EXEC_COMMAND()
 {
     if (MENUY == 0) { // START GAME
         SET_CONTROLS();
@@ -2184,7 +2597,7 @@ bool EXEC_COMMAND()
     return false;
 }
 
-void CYCLE_CONTROLS()
+void Game::CYCLE_CONTROLS()
 {
     KEYS_DEFINED = 0;
     CONTROL++;
@@ -2202,7 +2615,7 @@ char CONTROLTEXT[] = "standard  "
                      "snes pad  ";
 uint8_t CONTROLSTART[] = { 0, 10, 20 };
 
-void CYCLE_MAP()
+void Game::CYCLE_MAP()
 {
     SELECTED_MAP++;
     if (SELECTED_MAP == MAP_COUNT) { // Maximum number of maps
@@ -2211,7 +2624,7 @@ void CYCLE_MAP()
     DISPLAY_MAP_NAME();
 }
 
-void DISPLAY_MAP_NAME()
+void Game::DISPLAY_MAP_NAME()
 {
     char* name = CALC_MAP_NAME();
     for (int Y = 0; Y != 16; Y++) {
@@ -2219,30 +2632,29 @@ void DISPLAY_MAP_NAME()
     }
     // now set the mapname for the filesystem load
     MAPNAME[6] = SELECTED_MAP + 65;
+    PREFETCH_LEVEL();
 }
 
-char* CALC_MAP_NAME()
+char* Game::CALC_MAP_NAME()
 {
     // FIND MAP NAME
     return MAP_NAMES + (SELECTED_MAP << 4); // multiply by 16 by shifting 4 times to left.
 }
 
-void REVERSE_MENU_OPTION(bool reverse)
+void Game::REVERSE_MENU_OPTION(bool reverse)
 {
     for (int Y = 0; Y != 10; Y++) {
         writeToScreenMemory(MENU_CHART[MENUY] + Y, SCREEN_MEMORY[MENU_CHART[MENUY] + Y], reverse ? 14 : 15, 5);
     }
 }
 
-uint8_t MENUY = 0; // CURRENT MENU SELECTION
 menu_chart_t MENU_CHART[] = { 2 * SCREEN_WIDTH_IN_CHARACTERS + 4, 3 * SCREEN_WIDTH_IN_CHARACTERS + 4, 4 * SCREEN_WIDTH_IN_CHARACTERS + 4 };
 
-void CHANGE_DIFFICULTY_LEVEL()
+void Game::CHANGE_DIFFICULTY_LEVEL()
 {
     platform->renderFace(DIFF_LEVEL, 234, 75);
 }
 
-uint8_t DIFF_LEVEL = 1; // default medium
 uint8_t ROBOT_FACE[] = {
     0x3A, 0x43, 0x49, 0x55, 0x43, 0x3A, 0x49, 0x55, // EASY LEVEL
     0x40, 0x40, 0x6E, 0x70, 0x40, 0x40, 0x49, 0x55, // MEDIUM LEVEL
@@ -2254,7 +2666,7 @@ uint8_t FACE_LEVEL[] = { 0, 8, 16 };
 // game starts.  If the diffulcty is set to normal, nothing 
 // actually happens.  But if it is set to easy or hard, then
 // some changes occur accordingly.
-void SET_DIFF_LEVEL()
+void Game::SET_DIFF_LEVEL()
 {
     if (DIFF_LEVEL == 0) { // easy
         SET_DIFF_EASY();
@@ -2263,10 +2675,10 @@ void SET_DIFF_LEVEL()
     }
 }
 
-void SET_DIFF_EASY()
+void Game::SET_DIFF_EASY()
 {
     // Find all hidden items and double the quantity.
-    for (int X = 48; X != 64; X++) {
+    for (int X = UNIT_HIDDEN; X != UNIT_COUNT; X++) {
         if (UNIT_TYPE[X] != 0 &&
             UNIT_TYPE[X] != 128) { // KEY
             UNIT_A[X] <<= 1; // item qty
@@ -2274,13 +2686,13 @@ void SET_DIFF_EASY()
     }
 }
 
-void SET_DIFF_HARD()
+void Game::SET_DIFF_HARD()
 {
     // Find all hoverbots and change AI
-    for (int X = 0; X != 28; X++) {
+    for (int X = 0; X != UNIT_WEAPONS; X++) {
         if (UNIT_TYPE[X] == 2 || // hoverbot left/right
             UNIT_TYPE[X] == 3) { // hoverbot up/down
-            UNIT_TYPE[X] = 4; // hoverbot attack mode
+            SET_UNIT_TYPE(X, 4); // hoverbot attack mode
         }
     }
 }
@@ -2296,7 +2708,7 @@ uint16_t MAP_CHART[PLATFORM_MAP_WINDOW_TILES_HEIGHT]
 ;
 
 
-void EMP_FLASH()
+void Game::EMP_FLASH()
 {
     BORDER_COLOR = 0x00f;
     BORDER = 10;
@@ -2304,7 +2716,7 @@ void EMP_FLASH()
 
 // This routine animates the tile #204 (water) 
 // and also tile 148 (trash compactor)
-void ANIMATE_WATER()
+void Game::ANIMATE_WATER()
 {
     if (ANIMATE != 1) {
         return;
@@ -2319,23 +2731,20 @@ void ANIMATE_WATER()
     if (CINEMA_STATE == 197) {
         CINEMA_STATE = 0;
     }
-    REDRAW_WINDOW = 1;
+    ANIMATE_WINDOW = 1;
 }
 
-uint8_t WATER_TIMER = 0;
-uint8_t ANIM_STATE = 0;
-uint8_t CINEMA_STATE = 0;
-
 // This is the routine that allows a person to select
 // a level and highlights the selection in the information
 // display. It is unique to each computer since it writes
 // to the screen directly.
-void ELEVATOR_SELECT()
+void Game::ELEVATOR_SELECT()
 {
     if (LIVE_MAP_ON == 0) {
         DRAW_MAP_WINDOW();
     }
     ELEVATOR_MAX_FLOOR = UNIT_D[UNIT]; // get max levels
+    FLUSH_INFO();
     // Now draw available levels on screen
     for (int Y = 0, A = 0x31; Y != ELEVATOR_MAX_FLOOR; A++, Y++) {
         writeToScreenMemory((SCREEN_HEIGHT_IN_CHARACTERS - 1) * SCREEN_WIDTH_IN_CHARACTERS + 6 + Y, A);
@@ -2380,15 +2789,12 @@ void ELEVATOR_SELECT()
     }
 }
 
-uint8_t ELEVATOR_MAX_FLOOR = 0;
-uint8_t ELEVATOR_CURRENT_FLOOR = 0;
-
-void ELEVATOR_INVERT()
+void Game::ELEVATOR_INVERT()
 {
     writeToScreenMemory((SCREEN_HEIGHT_IN_CHARACTERS - 1) * SCREEN_WIDTH_IN_CHARACTERS + 5 + ELEVATOR_CURRENT_FLOOR, SCREEN_MEMORY[(SCREEN_HEIGHT_IN_CHARACTERS - 1) * SCREEN_WIDTH_IN_CHARACTERS + 5 + ELEVATOR_CURRENT_FLOOR] ^ 0x80); // %10000000
 }
 
-void ELEVATOR_INC()
+void Game::ELEVATOR_INC()
 {
     if (ELEVATOR_CURRENT_FLOOR != ELEVATOR_MAX_FLOOR) {
         ELEVATOR_INVERT();
@@ -2399,7 +2805,7 @@ void ELEVATOR_INC()
     }
 }
 
-void ELEVATOR_DEC()
+void Game::ELEVATOR_DEC()
 {
     if (ELEVATOR_CURRENT_FLOOR != 1) {
         ELEVATOR_INVERT();
@@ -2410,33 +2816,30 @@ void ELEVATOR_DEC()
     }
 }
 
-void ELEVATOR_FIND_XY()
+void Game::ELEVATOR_FIND_XY()
 {
-    for (int X = 32; X != 48; X++) { // start of doors
-        if (UNIT_TYPE[X] == 19) { // elevator
-            if (UNIT_C[X] == ELEVATOR_CURRENT_FLOOR) {
+    int X = ELEVATOR_UNIT[ELEVATOR_CURRENT_FLOOR]; // elevator of the new floor
+    if (X == 255) {
+        return;
+    }
 #if (MAP_WINDOW_SIZE == 77)
-                UNIT_LOC_X[0] = UNIT_LOC_X[X]; // player location = new elevator location
-                MAP_WINDOW_X = UNIT_LOC_X[X] - 5;
-                UNIT_LOC_Y[0] = UNIT_LOC_Y[X] - 1; // player location = new elevator location
-                MAP_WINDOW_Y = UNIT_LOC_Y[X] - 4;
+    UNIT_LOC_X[0] = UNIT_LOC_X[X]; // player location = new elevator location
+    MAP_WINDOW_X = UNIT_LOC_X[X] - 5;
+    UNIT_LOC_Y[0] = UNIT_LOC_Y[X] - 1; // player location = new elevator location
+    MAP_WINDOW_Y = UNIT_LOC_Y[X] - 4;
 #else
-                UNIT_LOC_X[0] = UNIT_LOC_X[X]; // player location = new elevator location
-                MAP_WINDOW_X = MIN(MAX(UNIT_LOC_X[X] - PLATFORM_MAP_WINDOW_TILES_WIDTH / 2, 0), 128 - PLATFORM_MAP_WINDOW_TILES_WIDTH);
-                UNIT_LOC_Y[0] = UNIT_LOC_Y[X] - 1; // player location = new elevator location
-                MAP_WINDOW_Y = MIN(MAX(UNIT_LOC_Y[X] - PLATFORM_MAP_WINDOW_TILES_HEIGHT / 2 - 1, 0), 64 - PLATFORM_MAP_WINDOW_TILES_HEIGHT);
+    UNIT_LOC_X[0] = UNIT_LOC_X[X]; // player location = new elevator location
+    MAP_WINDOW_X = MIN(MAX(UNIT_LOC_X[X] - PLATFORM_MAP_WINDOW_TILES_WIDTH / 2, 0), PLATFORM_MAP_WIDTH - PLATFORM_MAP_WINDOW_TILES_WIDTH);
+    UNIT_LOC_Y[0] = UNIT_LOC_Y[X] - 1; // player location = new elevator location
+    MAP_WINDOW_Y = MIN(MAX(UNIT_LOC_Y[X] - PLATFORM_MAP_WINDOW_TILES_HEIGHT / 2 - 1, 0), PLATFORM_MAP_HEIGHT - PLATFORM_MAP_WINDOW_TILES_HEIGHT);
 #endif
-                if (LIVE_MAP_ON == 0) {
-                    DRAW_MAP_WINDOW();
-                }
-                PLAY_SOUND(17); // elevator sound SOUND PLAY
-                break;
-            }
-        }
+    if (LIVE_MAP_ON == 0) {
+        DRAW_MAP_WINDOW();
     }
+    PLAY_SOUND(17); // elevator sound SOUND PLAY
 }
 
-void SET_CONTROLS()
+void Game::SET_CONTROLS()
 {
     if (CONTROL == 1) { // CUSTOM KEYS
         SET_CUSTOM_KEYS();
@@ -2449,12 +2852,12 @@ void SET_CONTROLS()
     }
 }
 
-void SET_CUSTOM_KEYS()
+void Game::SET_CUSTOM_KEYS()
 {
     if (KEYS_DEFINED != 0) {
         return;
     }
-    platform->fadeScreen(0, false);
+    FADE_OUT();
     DECOMPRESS_SCREEN(SCR_CUSTOM_KEYS, 15);
     platform->renderFrame();
     platform->fadeScreen(15, false);
@@ -2473,9 +2876,7 @@ void SET_CUSTOM_KEYS()
     KEYS_DEFINED = 1;
 }
 
-uint8_t KEYS_DEFINED = 0; // DEFAULT 0
-
-void PET_SCREEN_SHAKE()
+void Game::PET_SCREEN_SHAKE()
 {
     if (BGTIMER1 != 1) {
         return;
@@ -2504,7 +2905,7 @@ void PET_SCREEN_SHAKE()
 
 // So, it doesn't really flash the PET border, instead it
 // flashes the health screen.
-void PET_BORDER_FLASH()
+void Game::PET_BORDER_FLASH()
 {
     if (BORDER != 0) {
         // border flash should be active
@@ -2520,11 +2921,9 @@ void PET_BORDER_FLASH()
     }
 }
 
-uint8_t FLASH_STATE = 0;
-
 // This is actually part of a background routine, but it has to be in the main
 // source because the screen effects used are unique on each system.
-void DEMATERIALIZE()
+void Game::DEMATERIALIZE()
 {
     UNIT_TILE[0] = 243; // dematerialize tile
     UNIT_TIMER_B[UNIT]++;
@@ -2535,44 +2934,65 @@ void DEMATERIALIZE()
     } else {
         // TRANSPORT COMPLETE
         if (UNIT_B[UNIT] != 1) { // transport somewhere
-            UNIT_TYPE[0] = 2; // this mean game over condition, player type
-            UNIT_TYPE[UNIT] = 7; // Normal transporter pad
+            SET_UNIT_TYPE(0, 2); // this mean game over condition, player type
+            SET_UNIT_TYPE(UNIT, 7); // Normal transporter pad
         } else {
             UNIT_TILE[0] = 97;
             UNIT_LOC_X[0] = UNIT_C[UNIT]; // target X coordinates
             UNIT_LOC_Y[0] = UNIT_D[UNIT]; // target Y coordinates
-            UNIT_TYPE[UNIT] = 7; // Normal transporter pad
+            SET_UNIT_TYPE(UNIT, 7); // Normal transporter pad
             CACULATE_AND_REDRAW();
         }
     }
 }
 
-void ANIMATE_PLAYER()
+void Game::ANIMATE_PLAYER()
 {
     UNIT_TILE[0] = 96;
     WALK_FRAME++;
     WALK_FRAME &= 3;
 }
 
-void PLAY_SOUND(int sound)
+void Game::PLAY_SOUND(int sound)
 {
     platform->playSample(sound);
 }
 
-void STOP_SONG()
+void Game::STOP_SONG()
 {
     platform->stopSample();
 }
 
-void BACKGROUND_TASKS()
+void Game::BACKGROUND_TASKS()
 {
-    if (BGTIMER1 == 1) {
+    if (BGTIMER1 == 1 && TURBO_COUNT != 0) {
+        // The changes are drawn with the last tick of the frame
+        if (MAP_JOURNAL_COUNT != 0 || MAP_JOURNAL_OVERFLOW == 1) {
+            TURBO_MAP_CHANGED = 1;
+        }
+    } else if (BGTIMER1 == 1) {
+        if (TURBO_MAP_CHANGED == 1) {
+            TURBO_MAP_CHANGED = 0;
+            if (LIVE_MAP_ON) {
+                RENDER_LIVE_MAP();
+            } else {
+                REDRAW_WINDOW = 1;
+            }
+        }
         if (LIVE_MAP_ON) {
             DRAW_LIVE_MAP();
         } else
         if (REDRAW_WINDOW == 1) {
             REDRAW_WINDOW = 0;
+#ifdef PLATFORM_PROFILE
+            platform->startProfile(PROFILE_DRAW_MAP_WINDOW);
             DRAW_MAP_WINDOW();
+            platform->stopProfile(PROFILE_DRAW_MAP_WINDOW);
+#else
+            DRAW_MAP_WINDOW();
+#endif
+        } else if (ANIMATE_WINDOW == 1 || MAP_JOURNAL_COUNT != 0 || MAP_JOURNAL_OVERFLOW == 1) {
+            DRAW_MAP_CHANGES();
         }
         platform->renderFrame();
     }
@@ -2581,7 +3001,20 @@ void BACKGROUND_TASKS()
         return;
     }
     BGTIMER1 = 0; // RESET BACKGROUND TIMER
-    for (UNIT = 1; UNIT != 64; UNIT++) {
+    if (TURBO_TICKS > 1) {
+        REPORT_TURBO_RATE();
+    }
+#if PLATFORM_REWIND_SECONDS > 0
+#ifdef PLATFORM_PROFILE
+    platform->startProfile(PROFILE_REWIND_RECORD);
+    REWIND_RECORD();
+    platform->stopProfile(PROFILE_REWIND_RECORD);
+#else
+    REWIND_RECORD();
+#endif
+#endif
+    CLEAR_MAP_JOURNAL();
+    for (UNIT = NEXT_UNIT(1, UNIT_COUNT); UNIT != UNIT_COUNT; UNIT = NEXT_UNIT(UNIT + 1, UNIT_COUNT)) {
         // ALL AI routines must JMP back to here at the end.
         if (UNIT_TYPE[UNIT] != 0) { // Does unit exist?
             // Unit found to exist, now check it's timer.
@@ -2592,48 +3025,58 @@ void BACKGROUND_TASKS()
                 // Unit exists and timer has triggered
                 // The unit type determines which AI routine is run.
                 if (UNIT_TYPE[UNIT] < 24) { // MAX DIFFERENT UNIT TYPES IN CHART, ABORT IF GREATER
-                    AI_ROUTINE_CHART[UNIT_TYPE[UNIT]]();
+#ifdef PLATFORM_PROFILE
+                    uint8_t ROUTINE = UNIT_TYPE[UNIT];
+                    platform->startProfile(ROUTINE);
+                    (this->*AI_ROUTINE_CHART[ROUTINE])();
+                    platform->stopProfile(ROUTINE);
+#else
+                    (this->*AI_ROUTINE_CHART[UNIT_TYPE[UNIT]])();
+#endif
                 }
             }
         }
     }
+#ifdef PLATFORM_CHECK_UNIT_COUNTS
+    CHECK_UNIT_COUNTS();
+#endif
 }
 
-void (*AI_ROUTINE_CHART[])(void) =
-{
-    DUMMY_ROUTINE,      // UNIT TYPE 00   ;non-existent unit
-    DUMMY_ROUTINE,      // UNIT TYPE 01   ;player unit - can't use
-    LEFT_RIGHT_DROID,   // UNIT TYPE 02
-    UP_DOWN_DROID,      // UNIT TYPE 03
-    HOVER_ATTACK,       // UNIT TYPE 04
-    WATER_DROID,        // UNIT TYPE 05
-    TIME_BOMB,      // UNIT TYPE 06
-    TRANSPORTER_PAD,    // UNIT TYPE 07
-    DEAD_ROBOT,     // UNIT TYPE 08
-    EVILBOT,        // UNIT TYPE 09 
-    AI_DOOR,        // UNIT TYPE 10
-    SMALL_EXPLOSION,    // UNIT TYPE 11
-    PISTOL_FIRE_UP,     // UNIT TYPE 12
-    PISTOL_FIRE_DOWN,   // UNIT TYPE 13
-    PISTOL_FIRE_LEFT,   // UNIT TYPE 14
-    PISTOL_FIRE_RIGHT,  // UNIT TYPE 15
-    TRASH_COMPACTOR,    // UNIT TYPE 16
-    UP_DOWN_ROLLERBOT,  // UNIT TYPE 17
-    LEFT_RIGHT_ROLLERBOT,   // UNIT TYPE 18
-    ELEVATOR,       // UNIT TYPE 19
-    MAGNET,         // UNIT TYPE 20
-    MAGNETIZED_ROBOT,   // UNIT TYPE 21
-    WATER_RAFT_LR,      // UNIT TYPE 22
-    DEMATERIALIZE      // UNIT TYPE 23
+void (Game::*Game::AI_ROUTINE_CHART[])() =
+{
+    &Game::DUMMY_ROUTINE,      // UNIT TYPE 00   ;non-existent unit
+    &Game::DUMMY_ROUTINE,      // UNIT TYPE 01   ;player unit - can't use
+    &Game::LEFT_RIGHT_DROID,   // UNIT TYPE 02
+    &Game::UP_DOWN_DROID,      // UNIT TYPE 03
+    &Game::HOVER_ATTACK,       // UNIT TYPE 04
+    &Game::WATER_DROID,        // UNIT TYPE 05
+    &Game::TIME_BOMB,      // UNIT TYPE 06
+    &Game::TRANSPORTER_PAD,    // UNIT TYPE 07
+    &Game::DEAD_ROBOT,     // UNIT TYPE 08
+    &Game::EVILBOT,        // UNIT TYPE 09 
+    &Game::AI_DOOR,        // UNIT TYPE 10
+    &Game::SMALL_EXPLOSION,    // UNIT TYPE 11
+    &Game::PISTOL_FIRE_UP,     // UNIT TYPE 12
+    &Game::PISTOL_FIRE_DOWN,   // UNIT TYPE 13
+    &Game::PISTOL_FIRE_LEFT,   // UNIT TYPE 14
+    &Game::PISTOL_FIRE_RIGHT,  // UNIT TYPE 15
+    &Game::TRASH_COMPACTOR,    // UNIT TYPE 16
+    &Game::UP_DOWN_ROLLERBOT,  // UNIT TYPE 17
+    &Game::LEFT_RIGHT_ROLLERBOT,   // UNIT TYPE 18
+    &Game::ELEVATOR,       // UNIT TYPE 19
+    &Game::MAGNET,         // UNIT TYPE 20
+    &Game::MAGNETIZED_ROBOT,   // UNIT TYPE 21
+    &Game::WATER_RAFT_LR,      // UNIT TYPE 22
+    &Game::DEMATERIALIZE      // UNIT TYPE 23
 };
 
 // Dummy routine does nothing, but I need it for development.
-void DUMMY_ROUTINE()
+void Game::DUMMY_ROUTINE()
 {
     return;
 }
 
-void WATER_RAFT_LR()
+void Game::WATER_RAFT_LR()
 {
     // First check which direction raft is moving.
     if (UNIT_A[UNIT] == 1) {
@@ -2683,7 +3126,7 @@ void WATER_RAFT_LR()
     }
 }
 
-void RAFT_DELETE()
+void Game::RAFT_DELETE()
 {
     MAP_X = UNIT_LOC_X[UNIT];
     MAP_Y = UNIT_LOC_Y[UNIT];
@@ -2691,7 +3134,7 @@ void RAFT_DELETE()
     PLOT_TILE_TO_MAP();
 }
 
-void RAFT_PLOT()
+void Game::RAFT_PLOT()
 {
     MAP_X = UNIT_LOC_X[UNIT];
     MAP_Y = UNIT_LOC_Y[UNIT];
@@ -2699,7 +3142,7 @@ void RAFT_PLOT()
     PLOT_TILE_TO_MAP();
 }
 
-void MAGNETIZED_ROBOT()
+void Game::MAGNETIZED_ROBOT()
 {
     CHECK_FOR_WINDOW_REDRAW();
     MOVE_TYPE = 0x01; // %00000001
@@ -2724,11 +3167,11 @@ void MAGNETIZED_ROBOT()
     UNIT_TIMER_A[UNIT] = 10;
     UNIT_TIMER_B[UNIT]--;
     if (UNIT_TIMER_B[UNIT] == 0) {
-        UNIT_TYPE[UNIT] = UNIT_D[UNIT];
+        SET_UNIT_TYPE(UNIT, UNIT_D[UNIT]);
     }
 }
 
-void GENERATE_RANDOM_NUMBER()
+void Game::GENERATE_RANDOM_NUMBER()
 {
     if (RANDOM != 0) { // added this
         if (RANDOM & 0x80) {
@@ -2741,7 +3184,7 @@ void GENERATE_RANDOM_NUMBER()
     }
 }
 
-void MAGNET()
+void Game::MAGNET()
 {
     // First let's take care of the timers.  This unit runs
     // every cycle so that it can detect contact with another
@@ -2752,7 +3195,7 @@ void MAGNET()
         UNIT_A[UNIT]--;
         if (UNIT_A[UNIT] == 0) {
             // Both timers have reached zero, time to deactivate.
-            UNIT_TYPE[UNIT] = 0;
+            RELEASE_UNIT(UNIT);
             MAGNET_ACT = 0;
             return;
         }
@@ -2770,19 +3213,19 @@ void MAGNET()
         // Collision with robot detected.
         PLAY_SOUND(4); // HAYWIRE SOUND, SOUND PLAY
         UNIT_D[UNIT_FIND] = UNIT_TYPE[UNIT_FIND]; // make backup of unit type
-        UNIT_TYPE[UNIT_FIND] = 21; // Crazy robot AI
+        SET_UNIT_TYPE(UNIT_FIND, 21); // Crazy robot AI
         UNIT_TIMER_B[UNIT_FIND] = 60;
     }
-    UNIT_TYPE[UNIT] = 0;
+    RELEASE_UNIT(UNIT);
     MAGNET_ACT = 0;
 }
 
-void DEAD_ROBOT()
+void Game::DEAD_ROBOT()
 {
-    UNIT_TYPE[UNIT] = 0;
+    RELEASE_UNIT(UNIT);
 }
 
-void UP_DOWN_ROLLERBOT()
+void Game::UP_DOWN_ROLLERBOT()
 {
     UNIT_TIMER_A[UNIT] = 7;
     ROLLERBOT_ANIMATE();
@@ -2806,7 +3249,7 @@ void UP_DOWN_ROLLERBOT()
     }
 }
 
-void LEFT_RIGHT_ROLLERBOT()
+void Game::LEFT_RIGHT_ROLLERBOT()
 {
     UNIT_TIMER_A[UNIT] = 7;
     ROLLERBOT_ANIMATE();
@@ -2830,9 +3273,9 @@ void LEFT_RIGHT_ROLLERBOT()
     }
 }
 
-void ROLLERBOT_FIRE_DETECT()
+void Game::ROLLERBOT_FIRE_DETECT()
 {
-    int X;
+    uint8_t X;
     TEMP_A = UNIT_LOC_X[UNIT];
     TEMP_B = UNIT_LOC_Y[UNIT];
     // See if we're lined up vertically
@@ -2842,24 +3285,20 @@ void ROLLERBOT_FIRE_DETECT()
             if (UNIT_LOC_X[UNIT] - UNIT_LOC_X[0] >= 6) { // robot, player
                 return;
             }
-            for (X = 28; X != 32; X++) {
-                if (UNIT_TYPE[X] == 0) {
-                    UNIT_TYPE[X] = 14; // pistol fire left AI
-                    ROLLERBOT_AFTER_FIRE(X, 245); // tile for horizontal weapons fire
-                    return;
-                }
+            X = ALLOCATE_UNIT(RANGE_WEAPONS, 14); // pistol fire left AI
+            if (X != 255) {
+                ROLLERBOT_AFTER_FIRE(X, 245); // tile for horizontal weapons fire
+                return;
             }
         } else {
             // Check to see if distance is less than 5
             if (UNIT_LOC_X[0] - UNIT_LOC_X[UNIT] >= 6) { // player, robot
                 return;
             }
-            for (X = 28; X != 32; X++) {
-                if (UNIT_TYPE[X] == 0) {
-                    UNIT_TYPE[X] = 15; // pistol fire right AI
-                    ROLLERBOT_AFTER_FIRE(X, 245); // tile for horizontal weapons fire
-                    return;
-                }
+            X = ALLOCATE_UNIT(RANGE_WEAPONS, 15); // pistol fire right AI
+            if (X != 255) {
+                ROLLERBOT_AFTER_FIRE(X, 245); // tile for horizontal weapons fire
+                return;
             }
         }
     } else if (UNIT_LOC_X[UNIT] == UNIT_LOC_X[0]) { // robot, player
@@ -2869,30 +3308,26 @@ void ROLLERBOT_FIRE_DETECT()
             if (UNIT_LOC_Y[UNIT] - UNIT_LOC_Y[0] >= 4) { // robot, player
                 return;
             }
-            for (X = 28; X != 32; X++) {
-                if (UNIT_TYPE[X] == 0) {
-                    UNIT_TYPE[X] = 12; // pistol fire UP AI
-                    ROLLERBOT_AFTER_FIRE(X, 244); // tile for horizontal weapons fire
-                    return;
-                }
+            X = ALLOCATE_UNIT(RANGE_WEAPONS, 12); // pistol fire UP AI
+            if (X != 255) {
+                ROLLERBOT_AFTER_FIRE(X, 244); // tile for horizontal weapons fire
+                return;
             }
         } else {
             // Check to see if distance is less than 5
             if (UNIT_LOC_Y[0] - UNIT_LOC_Y[UNIT] >= 4) { // player, robot
                 return;
             }
-            for (X = 28; X != 32; X++) {
-                if (UNIT_TYPE[X] == 0) {
-                    UNIT_TYPE[X] = 13; // pistol fire DOWN AI
-                    ROLLERBOT_AFTER_FIRE(X, 244); // tile for horizontal weapons fire
-                    return;
-                }
+            X = ALLOCATE_UNIT(RANGE_WEAPONS, 13); // pistol fire DOWN AI
+            if (X != 255) {
+                ROLLERBOT_AFTER_FIRE(X, 244); // tile for horizontal weapons fire
+                return;
             }
         }
     }
 }
 
-void ROLLERBOT_AFTER_FIRE(uint8_t unit, uint8_t tile)
+void Game::ROLLERBOT_AFTER_FIRE(uint8_t unit, uint8_t tile)
 {
     UNIT_TILE[unit] = tile;
     UNIT_A[unit] = 5; // travel distance.
@@ -2903,7 +3338,7 @@ void ROLLERBOT_AFTER_FIRE(uint8_t unit, uint8_t tile)
     PLAY_SOUND(9); // PISTOL SOUND SOUND PLAY
 }
 
-void ROLLERBOT_ANIMATE()
+void Game::ROLLERBOT_ANIMATE()
 {
     if (UNIT_TIMER_B[UNIT] != 0) {
         UNIT_TIMER_B[UNIT]--;
@@ -2928,7 +3363,7 @@ void ROLLERBOT_ANIMATE()
 // source for each individual computer, because the screen effects
 // are created uniquely for each one.
 
-void TRANSPORTER_PAD()
+void Game::TRANSPORTER_PAD()
 {
     // first determine if the player is standing here
     if (UNIT_LOC_X[UNIT] == UNIT_LOC_X[0] && UNIT_LOC_Y[UNIT] == UNIT_LOC_Y[0]) {
@@ -2939,11 +3374,9 @@ void TRANSPORTER_PAD()
             TRANS_ACTIVE();
         } else {
             // test if all robots are dead
-            for (int X = 1; X != 28; X++) {
-                if (UNIT_TYPE[X] != 0) {
-                    UNIT_TIMER_A[UNIT] = 30;
-                    return;
-                }
+            if (RANGE_UNITS[RANGE_ROBOTS] != 0) {
+                UNIT_TIMER_A[UNIT] = 30;
+                return;
             }
             UNIT_A[UNIT] = 0; // make unit active
             UNIT_TIMER_A[UNIT] = 30;
@@ -2951,7 +3384,7 @@ void TRANSPORTER_PAD()
     }
 }
 
-void TRANS_PLAYER_PRESENT()
+void Game::TRANS_PLAYER_PRESENT()
 {
     if (UNIT_A[UNIT] != 0) { // unit active
         PRINT_INFO(MSG_TRANS1);
@@ -2959,13 +3392,13 @@ void TRANS_PLAYER_PRESENT()
         UNIT_TIMER_A[UNIT] = 100;
     } else {
         // start transport process
-        UNIT_TYPE[UNIT] = 23; // Convert to different AI
+        SET_UNIT_TYPE(UNIT, 23); // Convert to different AI
         UNIT_TIMER_A[UNIT] = 5;
         UNIT_TIMER_B[UNIT] = 0;
     }
 }
 
-void TRANS_ACTIVE()
+void Game::TRANS_ACTIVE()
 {
     if (UNIT_TIMER_B[UNIT] != 1) {
         UNIT_TIMER_B[UNIT] = 1;
@@ -2981,7 +3414,7 @@ void TRANS_ACTIVE()
     UNIT_TIMER_A[UNIT] = 30;
 }
 
-void TIME_BOMB()
+void Game::TIME_BOMB()
 {
     if (UNIT_A[UNIT] == 0) {
         BIG_EXP_PHASE1();
@@ -2990,11 +3423,18 @@ void TIME_BOMB()
     }
 }
 
+// The step of each ray of the large explosion, in the order
+// north, south, east, west, northeast, northwest, southeast
+// and southwest. Each ray has PLATFORM_BLAST_RADIUS entries
+// in EXP_BUFFER.
+int8_t BLAST_RAY_X[BLAST_RAYS] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+int8_t BLAST_RAY_Y[BLAST_RAYS] = { -1, 1, 0, 0, -1, -1, 1, 1 };
+
 // This is the large explosion used by the time-bomb
 // and plasma gun, and maybe others.  This is the first
 // phase of the explosion, which stores the tiles to
 // a buffer and then changes each tile to an explosion.
-void BIG_EXP_PHASE1()
+void Game::BIG_EXP_PHASE1()
 {
     if (BIG_EXP_ACT != 0) { // Check that no other explosion active.
         UNIT_TIMER_A[UNIT] = 10;
@@ -3003,317 +3443,105 @@ void BIG_EXP_PHASE1()
     BIG_EXP_ACT = 1; // Set flag so no other explosions can begin until this one ends.
     SCREEN_SHAKE = 1;
     PLAY_SOUND(0); // explosion-sound SOUND PLAY
-    BEX_PART1(); // check center piece for unit
-    BEXCEN(); // check center piece for unit
-    if (LIVE_MAP_ON == 1) {
-        GET_TILE_FROM_MAP();
-        MAP_SOURCE[0] = 246;
-        platform->renderLiveMapTile(MAP, MAP_X, MAP_Y);
-        MAP_SOURCE[0] = TILE;
-    }
-    BEX1_NORTH();
-    BEX1_SOUTH();
-    BEX1_EAST();
-    BEX1_WEST();
-    BEX1_NE();
-    BEX1_NW();
-    BEX1_SE();
-    BEX1_SW();
+    uint8_t CENTER_X = UNIT_LOC_X[UNIT];
+    uint8_t CENTER_Y = UNIT_LOC_Y[UNIT];
+    if (LIVE_MAP_ON == 1 && CENTER_X < LIVE_MAP_WIDTH && CENTER_Y < LIVE_MAP_HEIGHT) {
+        // Only flashes the live map, so the map isn't changed through the journal
+        uint8_t* VIEW = LIVE_MAP_VIEW() + CENTER_Y * LIVE_MAP_WIDTH + CENTER_X;
+        uint8_t SHOWN = VIEW[0];
+        VIEW[0] = 246;
+        platform->renderLiveMapTile(LIVE_MAP_VIEW(), CENTER_X, CENTER_Y);
+        VIEW[0] = SHOWN;
+    }
+    // The "unit" itself changes the center tile to an explosion,
+    // so only the tiles along each ray are stored and changed.
+    for (int RAY = 0; RAY != BLAST_RAYS; RAY++) {
+        int X = CENTER_X;
+        int Y = CENTER_Y;
+        int STEP = 0;
+        while (STEP != PLATFORM_BLAST_RADIUS) {
+            X += BLAST_RAY_X[RAY];
+            Y += BLAST_RAY_Y[RAY];
+            if (X < 0 || X >= PLATFORM_MAP_WIDTH || Y < 0 || Y >= PLATFORM_MAP_HEIGHT) { // edge of the map?
+                break;
+            }
+            MAP_X = X;
+            MAP_Y = Y;
+            GET_TILE_FROM_MAP();
+            if (!MAP_PLANE(PLANE_SEE_THROUGH, MAP_X, MAP_Y)) { // can see through tile?
+                break;
+            }
+            EXP_BUFFER[RAY * PLATFORM_BLAST_RADIUS + STEP] = TILE;
+            WRITE_MAP_TILE(MAP_X, MAP_Y, 246);
+            STEP++;
+        }
+        EXP_REACH[RAY] = STEP;
+    }
+    BLAST_DAMAGE(CENTER_X, CENTER_Y, EXP_REACH);
     UNIT_TILE[UNIT] = 246; // explosion tile
     UNIT_A[UNIT] = 1; // move to next phase of explosion.
     UNIT_TIMER_A[UNIT] = 12;
     REDRAW_WINDOW = 1;
 }
 
-// There are 8 separate subroutines for the large explosion
-// with each one handling a specific outward direction of motion.
-// The "unit" itself changes tiles to an explosion, so we don't
-// need to mess with the center tile.
-void BEX1_NORTH()
-{
-    BEX_PART1();
-    // first tile
-    MAP_Y--;
-    if (!BEX_PART2()) {
-        return;
-    }
-    EXP_BUFFER[0] = TILE;
-    BEX_PART3();
-    // second tile
-    MAP_Y--;
-    if (!BEX_PART2()) {
-        return;
-    }
-    EXP_BUFFER[1] = TILE;
-    BEX_PART3();
-}
-
-void BEX1_SOUTH()
-{
-    BEX_PART1();
-    // first tile
-    MAP_Y++;
-    if (!BEX_PART2()) {
-        return;
-    }
-    EXP_BUFFER[2] = TILE;
-    BEX_PART3();
-    // second tile
-    MAP_Y++;
-    if (!BEX_PART2()) {
-        return;
-    }
-    EXP_BUFFER[3] = TILE;
-    BEX_PART3();
-}
-
-void BEX1_EAST()
-{
-    BEX_PART1();
-    // first tile
-    MAP_X++;
-    if (!BEX_PART2()) {
-        return;
-    }
-    EXP_BUFFER[4] = TILE;
-    BEX_PART3();
-    // second tile
-    MAP_X++;
-    if (!BEX_PART2()) {
-        return;
-    }
-    EXP_BUFFER[5] = TILE;
-    BEX_PART3();
-}
-
-void BEX1_WEST()
-{
-    BEX_PART1();
-    // first tile
-    MAP_X--;
-    if (!BEX_PART2()) {
-        return;
-    }
-    EXP_BUFFER[6] = TILE;
-    BEX_PART3();
-    // second tile
-    MAP_X--;
-    if (!BEX_PART2()) {
-        return;
-    }
-    EXP_BUFFER[7] = TILE;
-    BEX_PART3();
-}
-
-void BEX1_NE()
-{
-    BEX_PART1();
-    // first tile
-    MAP_X++;
-    MAP_Y--;
-    if (!BEX_PART2()) {
-        return;
-    }
-    EXP_BUFFER[8] = TILE;
-    BEX_PART3();
-    // second tile
-    MAP_X++;
-    MAP_Y--;
-    if (!BEX_PART2()) {
-        return;
-    }
-    EXP_BUFFER[9] = TILE;
-    BEX_PART3();
-}
-
-void BEX1_NW()
-{
-    BEX_PART1();
-    // first tile
-    MAP_X--;
-    MAP_Y--;
-    if (!BEX_PART2()) {
-        return;
-    }
-    EXP_BUFFER[10] = TILE;
-    BEX_PART3();
-    // second tile
-    MAP_X--;
-    MAP_Y--;
-    if (!BEX_PART2()) {
-        return;
-    }
-    EXP_BUFFER[11] = TILE;
-    BEX_PART3();
-}
-
-void BEX1_SE()
-{
-    BEX_PART1();
-    // first tile
-    MAP_X++;
-    MAP_Y++;
-    if (!BEX_PART2()) {
-        return;
-    }
-    EXP_BUFFER[12] = TILE;
-    BEX_PART3();
-    // second tile
-    MAP_X++;
-    MAP_Y++;
-    if (!BEX_PART2()) {
-        return;
-    }
-    EXP_BUFFER[13] = TILE;
-    BEX_PART3();
-}
-
-void BEX1_SW()
-{
-    BEX_PART1();
-    // first tile
-    MAP_X--;
-    MAP_Y++;
-    if (!BEX_PART2()) {
-        return;
-    }
-    EXP_BUFFER[14] = TILE;
-    BEX_PART3();
-    // second tile
-    MAP_X--;
-    MAP_Y++;
-    if (!BEX_PART2()) {
-        return;
-    }
-    EXP_BUFFER[15] = TILE;
-    BEX_PART3();
-}
-
-void BEX_PART1()
-{
-    MAP_X = UNIT_LOC_X[UNIT];
-    MAP_Y = UNIT_LOC_Y[UNIT];
-}
-
-bool BEX_PART2()
-{
-    GET_TILE_FROM_MAP();
-    return (TILE_ATTRIB[TILE] & 0x10) == 0x10; // can see through tile?
-}
-
-void BEX_PART3()
-{
-    MAP_SOURCE[0] = 246;
-    if (LIVE_MAP_ON == 1) {
-        platform->renderLiveMapTile(MAP, MAP_X, MAP_Y);
-    }
-    BEXCEN();
-}
-
-void BEXCEN()
+// Damages the units caught in the large explosion in one pass
+// over the units instead of searching for a unit on each tile.
+// As with CHECK_FOR_UNIT, only the first unit on a tile is hit.
+void Game::BLAST_DAMAGE(uint8_t x, uint8_t y, const uint8_t* reach)
 {
-    CHECK_FOR_UNIT();
-    if (UNIT_FIND != 255) {
-        TEMP_A = 11;
+    bool HIT[BLAST_CELLS] = { false };
+    TEMP_A = 11; // amount of damage it will inflict
+    for (uint8_t X = NEXT_UNIT(0, UNIT_WEAPONS); X != UNIT_WEAPONS; X = NEXT_UNIT(X + 1, UNIT_WEAPONS)) {
+        int DX = (int8_t)(UNIT_LOC_X[X] - x);
+        int DY = (int8_t)(UNIT_LOC_Y[X] - y);
+        int CELL = BLAST_CELLS;
+        if (DX == 0 && DY == 0) {
+            CELL = 0; // center piece
+        } else {
+            for (int RAY = 0; RAY != BLAST_RAYS; RAY++) {
+                int STEP = BLAST_RAY_X[RAY] != 0 ? DX / BLAST_RAY_X[RAY] : DY / BLAST_RAY_Y[RAY];
+                if (STEP > 0 && STEP <= reach[RAY] && BLAST_RAY_X[RAY] * STEP == DX && BLAST_RAY_Y[RAY] * STEP == DY) {
+                    CELL = 1 + RAY * PLATFORM_BLAST_RADIUS + STEP - 1;
+                    break;
+                }
+            }
+        }
+        if (CELL == BLAST_CELLS || HIT[CELL]) {
+            continue;
+        }
+        HIT[CELL] = true;
+        UNIT_FIND = X;
         INFLICT_DAMAGE();
     }
 }
 
-void BIG_EXP_PHASE2()
+void Game::BIG_EXP_PHASE2()
 {
     // Do the center tile first.
-    BEX_PART1();
+    MAP_X = UNIT_LOC_X[UNIT];
+    MAP_Y = UNIT_LOC_Y[UNIT];
     GET_TILE_FROM_MAP();
-    MAP_SOURCE[0] = 246;
+    WRITE_MAP_TILE(MAP_X, MAP_Y, 246);
     TEMP_A = TILE;
     RESTORE_TILE();
-    // tile #0 north 1
-    BEX_PART1();
-    MAP_Y--;
-    TEMP_A = EXP_BUFFER[0];
-    RESTORE_TILE();
-    // tile #1 north 2
-    MAP_Y--;
-    TEMP_A = EXP_BUFFER[1];
-    RESTORE_TILE();
-    // tile #2 south 1
-    BEX_PART1();
-    MAP_Y++;
-    TEMP_A = EXP_BUFFER[2];
-    RESTORE_TILE();
-    // tile #3 south 2
-    MAP_Y++;
-    TEMP_A = EXP_BUFFER[3];
-    RESTORE_TILE();
-    // tile #4 east 1
-    BEX_PART1();
-    MAP_X++;
-    TEMP_A = EXP_BUFFER[4];
-    RESTORE_TILE();
-    // tile #5 east 2
-    MAP_X++;
-    TEMP_A = EXP_BUFFER[5];
-    RESTORE_TILE();
-    // tile #6 west 1
-    BEX_PART1();
-    MAP_X--;
-    TEMP_A = EXP_BUFFER[6];
-    RESTORE_TILE();
-    // tile #7 west 2
-    MAP_X--;
-    TEMP_A = EXP_BUFFER[7];
-    RESTORE_TILE();
-    // tile #8 northeast 1
-    BEX_PART1();
-    MAP_Y--;
-    MAP_X++;
-    TEMP_A = EXP_BUFFER[8];
-    RESTORE_TILE();
-    // tile #9 northeast 2
-    MAP_Y--;
-    MAP_X++;
-    TEMP_A = EXP_BUFFER[9];
-    RESTORE_TILE();
-    // tile #10 northwest 1
-    BEX_PART1();
-    MAP_Y--;
-    MAP_X--;
-    TEMP_A = EXP_BUFFER[10];
-    RESTORE_TILE();
-    // tile #11 northwest 2
-    MAP_Y--;
-    MAP_X--;
-    TEMP_A = EXP_BUFFER[11];
-    RESTORE_TILE();
-    // tile #12 southeast 1
-    BEX_PART1();
-    MAP_Y++;
-    MAP_X++;
-    TEMP_A = EXP_BUFFER[12];
-    RESTORE_TILE();
-    // tile #13 southeast 2
-    MAP_Y++;
-    MAP_X++;
-    TEMP_A = EXP_BUFFER[13];
-    RESTORE_TILE();
-    // tile #14 southwest 1
-    BEX_PART1();
-    MAP_Y++;
-    MAP_X--;
-    TEMP_A = EXP_BUFFER[14];
-    RESTORE_TILE();
-    // tile #15 southwest 2
-    MAP_Y++;
-    MAP_X--;
-    TEMP_A = EXP_BUFFER[15];
-    RESTORE_TILE();
+    // Then every tile of every ray, as stored by phase 1.
+    for (int RAY = 0; RAY != BLAST_RAYS; RAY++) {
+        MAP_X = UNIT_LOC_X[UNIT];
+        MAP_Y = UNIT_LOC_Y[UNIT];
+        for (int STEP = 0; STEP != EXP_REACH[RAY]; STEP++) {
+            MAP_X += BLAST_RAY_X[RAY];
+            MAP_Y += BLAST_RAY_Y[RAY];
+            TEMP_A = EXP_BUFFER[RAY * PLATFORM_BLAST_RADIUS + STEP];
+            RESTORE_TILE();
+        }
+    }
     REDRAW_WINDOW = 1;
-    UNIT_TYPE[UNIT] = 0; // Deactivate this AI
+    RELEASE_UNIT(UNIT); // Deactivate this AI
     BIG_EXP_ACT = 0;
     SCREEN_SHAKE = 0;
 }
 
-void RESTORE_TILE()
+void Game::RESTORE_TILE()
 {
     GET_TILE_FROM_MAP();
     if (TILE != 246) {
@@ -3321,42 +3549,34 @@ void RESTORE_TILE()
     }
     if (TEMP_A != 131) { // Cannister tile
         if ((TILE_ATTRIB[TEMP_A] & 0x08) == 0x08) { // %00001000 can it be destroyed?
-            MAP_SOURCE[0] = DESTRUCT_PATH[TEMP_A];
+            WRITE_MAP_TILE(MAP_X, MAP_Y, DESTRUCT_PATH[TEMP_A]);
         } else {
-            MAP_SOURCE[0] = TEMP_A;
-        }
-        if (LIVE_MAP_ON == 1) {
-            platform->renderLiveMapTile(MAP, MAP_X, MAP_Y);
+            WRITE_MAP_TILE(MAP_X, MAP_Y, TEMP_A);
         }
     } else {
         // What to do if we encounter an explosive cannister
-        MAP_SOURCE[0] = 135; // Blown cannister
-        if (LIVE_MAP_ON == 1) {
-            platform->renderLiveMapTile(MAP, MAP_X, MAP_Y);
-        }
-        for (int X = 28; X != 32; X++) { // Start of weapons units
-            if (UNIT_TYPE[X] == 0) {
-                UNIT_TYPE[X] = 6; // bomb AI
-                UNIT_TILE[X] = 131; // Cannister tile
-                UNIT_LOC_X[X] = MAP_X;
-                UNIT_LOC_Y[X] = MAP_Y;
-                UNIT_TIMER_A[X] = 10; // How long until exposion?
-                UNIT_A[X] = 0;
-                return;
-            }
+        WRITE_MAP_TILE(MAP_X, MAP_Y, 135); // Blown cannister
+        uint8_t X = ALLOCATE_UNIT(RANGE_WEAPONS, 6); // bomb AI
+        if (X != 255) {
+            UNIT_TILE[X] = 131; // Cannister tile
+            UNIT_LOC_X[X] = MAP_X;
+            UNIT_LOC_Y[X] = MAP_Y;
+            UNIT_TIMER_A[X] = 10; // How long until exposion?
+            UNIT_A[X] = 0;
+            return;
         }
         // no slots available right now, abort.
     }
 }
 
-void TRASH_COMPACTOR()
+void Game::TRASH_COMPACTOR()
 {
     if (UNIT_A[UNIT] == 0) { // OPEN
         MAP_X = UNIT_LOC_X[UNIT];
         MAP_Y = UNIT_LOC_Y[UNIT];
         GET_TILE_FROM_MAP();
         if (TILE == 148) { // Usual tile for trash compactor danger zone
-            MAP_SOURCE[1] = TILE;
+            WRITE_MAP_TILE(MAP_X + 1, MAP_Y, TILE);
             UNIT_TIMER_A[UNIT] = 20;
             // now check for units in the compactor
             MAP_X = UNIT_LOC_X[UNIT];
@@ -3397,19 +3617,16 @@ void TRASH_COMPACTOR()
         // Found unit in compactor, kill it.
         PRINT_INFO(MSG_TERMINATED);
         PLAY_SOUND(0); // EXPLOSION sound SOUND PLAY
-        UNIT_TYPE[UNIT_FIND] = 0;
+        RELEASE_UNIT(UNIT_FIND);
         UNIT_HEALTH[UNIT_FIND] = 0;
-        for (int X = 28; X != 32; X++) { // start of weapons
-            if (UNIT_TYPE[X] == 0) {
-                UNIT_TYPE[X] = 11; // SMALL EXPLOSION
-                UNIT_TILE[X] = 248; // first tile for explosion
-                UNIT_LOC_X[X] = UNIT_LOC_X[UNIT];
-                UNIT_LOC_Y[X] = UNIT_LOC_Y[UNIT];
-                if (UNIT_FIND == 0) { // is it the player
-                    BORDER_COLOR = 0xf00;
-                    BORDER = 10;
-                }
-                break;
+        uint8_t X = ALLOCATE_UNIT(RANGE_WEAPONS, 11); // SMALL EXPLOSION
+        if (X != 255) {
+            UNIT_TILE[X] = 248; // first tile for explosion
+            UNIT_LOC_X[X] = UNIT_LOC_X[UNIT];
+            UNIT_LOC_Y[X] = UNIT_LOC_Y[UNIT];
+            if (UNIT_FIND == 0) { // is it the player
+                BORDER_COLOR = 0xf00;
+                BORDER = 10;
             }
         }
         CHECK_FOR_WINDOW_REDRAW();
@@ -3435,24 +3652,19 @@ void TRASH_COMPACTOR()
     }
 }
 
-void DRAW_TRASH_COMPACTOR()
+void Game::DRAW_TRASH_COMPACTOR()
 {
     MAP_Y = UNIT_LOC_Y[UNIT];
     MAP_Y--; // start one tile above
     MAP_X = UNIT_LOC_X[UNIT];
     TILE = TCPIECE1;
     PLOT_TILE_TO_MAP();
-    MAP_SOURCE[1] = TCPIECE2;
-    MAP_SOURCE[128] = TCPIECE3;
-    MAP_SOURCE[129] = TCPIECE4;
-    CHECK_FOR_WINDOW_REDRAW();
+    WRITE_MAP_TILE(MAP_X + 1, MAP_Y, TCPIECE2);
+    WRITE_MAP_TILE(MAP_X, MAP_Y + 1, TCPIECE3);
+    WRITE_MAP_TILE(MAP_X + 1, MAP_Y + 1, TCPIECE4);
 }
-uint8_t TCPIECE1 = 0;
-uint8_t TCPIECE2 = 0;
-uint8_t TCPIECE3 = 0;
-uint8_t TCPIECE4 = 0;
 
-void WATER_DROID()
+void Game::WATER_DROID()
 {
     // first rotate the tiles
     if (UNIT_TIMER_B[UNIT] != 0) {
@@ -3471,13 +3683,13 @@ void WATER_DROID()
     }
     // kill unit after countdown reaches zero. 
     UNIT_A[UNIT] = UNIT_TYPE[UNIT];
-    UNIT_TYPE[UNIT] = 8; // Dead robot type
+    SET_UNIT_TYPE(UNIT, 8); // Dead robot type
     UNIT_TIMER_A[UNIT] = 255;
     UNIT_TILE[UNIT] = 115; // dead robot tile
     CHECK_FOR_WINDOW_REDRAW();
 }
 
-void PISTOL_FIRE_UP()
+void Game::PISTOL_FIRE_UP()
 {
     // Check if it has reached limits.
     if (UNIT_A[UNIT] == 0) {
@@ -3491,7 +3703,7 @@ void PISTOL_FIRE_UP()
     }
 }
 
-void PISTOL_FIRE_DOWN()
+void Game::PISTOL_FIRE_DOWN()
 {
     // Check if it has reached limits.
     if (UNIT_A[UNIT] == 0) {
@@ -3505,7 +3717,7 @@ void PISTOL_FIRE_DOWN()
     }
 }
 
-void PISTOL_FIRE_LEFT()
+void Game::PISTOL_FIRE_LEFT()
 {
     // Check if it has reached limits.
     if (UNIT_A[UNIT] == 0) {
@@ -3519,7 +3731,7 @@ void PISTOL_FIRE_LEFT()
     }
 }
 
-void PISTOL_FIRE_RIGHT()
+void Game::PISTOL_FIRE_RIGHT()
 {
     // Check if it has reached limits.
     if (UNIT_A[UNIT] == 0) {
@@ -3533,16 +3745,16 @@ void PISTOL_FIRE_RIGHT()
     }
 }
 
-void DEACTIVATE_WEAPON()
+void Game::DEACTIVATE_WEAPON()
 {
-    UNIT_TYPE[UNIT] = 0;
+    RELEASE_UNIT(UNIT);
     if (UNIT_B[UNIT] == 1) {
         UNIT_B[UNIT] = 0;
         PLASMA_ACT = 0;
     }
 }
 
-void PISTOL_AI_COMMON()
+void Game::PISTOL_AI_COMMON()
 {
     if (UNIT_B[UNIT] == 0) { // is it pistol or plasma?
         UNIT_A[UNIT]--; // reduce range by one
@@ -3552,16 +3764,16 @@ void PISTOL_AI_COMMON()
         GET_TILE_FROM_MAP();
         if (TILE == 131) { // explosive cannister
             // hit an explosive cannister
-            MAP_SOURCE[0] = 135; // Blown cannister
-            UNIT_TYPE[UNIT] = 6; // bomb AI
+            WRITE_MAP_TILE(MAP_X, MAP_Y, 135); // Blown cannister
+            SET_UNIT_TYPE(UNIT, 6); // bomb AI
             UNIT_TILE[UNIT] = 131; // Cannister tile
             UNIT_LOC_X[UNIT] = MAP_X;
             UNIT_LOC_Y[UNIT] = MAP_Y;
             UNIT_TIMER_A[UNIT] = 5; // How long until exposion?
             UNIT_A[UNIT] = 0;
-        } else if ((TILE_ATTRIB[TILE] & 0x10) != 0x10) { // can see through tile?
+        } else if (!MAP_PLANE(PLANE_SEE_THROUGH, MAP_X, MAP_Y)) { // can see through tile?
             // Hit object that can't pass through, convert to explosion
-            UNIT_TYPE[UNIT] = 11; // SMALL EXPLOSION
+            SET_UNIT_TYPE(UNIT, 11); // SMALL EXPLOSION
             UNIT_TILE[UNIT] = 248; // first tile for explosion
             CHECK_FOR_WINDOW_REDRAW();
         } else {
@@ -3571,7 +3783,7 @@ void PISTOL_AI_COMMON()
                 CHECK_FOR_WINDOW_REDRAW();
             } else {
                 // struck a robot/human
-                UNIT_TYPE[UNIT] = 11; // SMALL EXPLOSION
+                SET_UNIT_TYPE(UNIT, 11); // SMALL EXPLOSION
                 UNIT_TILE[UNIT] = 248; // first tile for explosion
                 TEMP_A = 1; // set damage for pistol
                 INFLICT_DAMAGE();
@@ -3586,7 +3798,7 @@ void PISTOL_AI_COMMON()
         MAP_Y = UNIT_LOC_Y[UNIT];
         GET_TILE_FROM_MAP();
         if (TILE != 131) { // cannister tile
-            if ((TILE_ATTRIB[TILE] & 0x10) == 0x10) {
+            if (MAP_PLANE(PLANE_SEE_THROUGH, MAP_X, MAP_Y)) {
                 // check if it encountered a human/robot
                 CHECK_FOR_UNIT();
                 if (UNIT_FIND == 255) { // NO UNIT ENCOUNTERED.
@@ -3597,7 +3809,7 @@ void PISTOL_AI_COMMON()
             }
         }
         // impact detected. convert to explosion
-        UNIT_TYPE[UNIT] = 6; // bomb AI
+        SET_UNIT_TYPE(UNIT, 6); // bomb AI
         UNIT_TIMER_A[UNIT] = 1; // How long until exposion?
         UNIT_A[UNIT] = 0;
         PLASMA_ACT = 0;
@@ -3608,17 +3820,17 @@ void PISTOL_AI_COMMON()
 // This routine checks to see if the robot being shot
 // is a hoverbot, if so it will alter it's AI to attack 
 // mode.
-void ALTER_AI()
+void Game::ALTER_AI()
 {
     if (UNIT_TYPE[UNIT_FIND] == 2 || UNIT_TYPE[UNIT_FIND] == 3) { // hoverbot left/right UP/DOWN
-        UNIT_TYPE[UNIT_FIND] = 4; // Attack AI
+        SET_UNIT_TYPE(UNIT_FIND, 4); // Attack AI
     }
 }
 
 // This routine will inflict damage on whatever is defined in
 // UNIT_FIND in the amount set in TEMP_A.  If the damage is more
 // than the health of that unit, it will delete the unit.
-void INFLICT_DAMAGE()
+void Game::INFLICT_DAMAGE()
 {
     UNIT_HEALTH[UNIT_FIND] -= TEMP_A;
     if (UNIT_HEALTH[UNIT_FIND] > 0) {
@@ -3633,49 +3845,38 @@ void INFLICT_DAMAGE()
     if (UNIT_FIND != 0) { // Is it the player that is dead?
         if (UNIT_TYPE[UNIT_FIND] != 8) { // Dead robot type - is it a dead robot already?
             UNIT_A[UNIT_FIND] = UNIT_TYPE[UNIT_FIND];
-            UNIT_TYPE[UNIT_FIND] = 8;
+            SET_UNIT_TYPE(UNIT_FIND, 8);
             UNIT_TIMER_A[UNIT_FIND] = 255;
             UNIT_TILE[UNIT_FIND] = 115; // dead robot tile
         }
     } else {
-        UNIT_TYPE[UNIT_FIND] = 0;
+        RELEASE_UNIT(UNIT_FIND);
         DISPLAY_PLAYER_HEALTH();
         BORDER_COLOR = 0xf00;
         BORDER = 10;
     }
 }
 
-void SMALL_EXPLOSION()
+void Game::SMALL_EXPLOSION()
 {
     UNIT_TIMER_A[UNIT] = 0;
     UNIT_TILE[UNIT]++;
     if (UNIT_TILE[UNIT] != 252) {
         CHECK_FOR_WINDOW_REDRAW();
     } else {
-        UNIT_TYPE[UNIT] = 0;
+        RELEASE_UNIT(UNIT);
         CHECK_FOR_WINDOW_REDRAW();
     }
 }
 
-void HOVER_ATTACK()
+void Game::HOVER_ATTACK()
 {
     UNIT_TIMER_B[UNIT] = 0;
     HOVERBOT_ANIMATE(UNIT);
     UNIT_TIMER_A[UNIT] = 7;
     CHECK_FOR_WINDOW_REDRAW();
     MOVE_TYPE = 0x02; // %00000010 HOVER
-    // CHECK FOR HORIZONTAL MOVEMENT
-    if (UNIT_LOC_X[UNIT] > UNIT_LOC_X[0]) {
-        REQUEST_WALK_LEFT();
-    } else if (UNIT_LOC_X[UNIT] < UNIT_LOC_X[0]) {
-        REQUEST_WALK_RIGHT();
-    }
-    // NOW CHECK FOR VERITCAL MOVEMENT
-    if (UNIT_LOC_Y[UNIT] > UNIT_LOC_Y[0]) {
-        REQUEST_WALK_UP();
-    } else if (UNIT_LOC_Y[UNIT] < UNIT_LOC_Y[0]) {
-        REQUEST_WALK_DOWN();
-    }
+    MOVE_TOWARD_PLAYER();
     ROBOT_ATTACK_RANGE();
     if (PROX_DETECT == 1) { // 1=Robot next to player 0=not
         TEMP_A = 1; // amount of damage it will inflict
@@ -3689,21 +3890,18 @@ void HOVER_ATTACK()
     CHECK_FOR_WINDOW_REDRAW();
 }
 
-void CREATE_PLAYER_EXPLOSION()
+void Game::CREATE_PLAYER_EXPLOSION()
 {
-    for (int X = 28; X != 32; X++) { // max unit for weaponsfire
-        if (UNIT_TYPE[X] == 0) {
-            UNIT_TYPE[X] = 11; // Small explosion AI type
-            UNIT_TILE[X] = 248; // first tile for explosion
-            UNIT_TIMER_A[X] = 1;
-            UNIT_LOC_X[X] = UNIT_LOC_X[0];
-            UNIT_LOC_Y[X] = UNIT_LOC_Y[0];
-            break;
-        }
+    uint8_t X = ALLOCATE_UNIT(RANGE_WEAPONS, 11); // Small explosion AI type
+    if (X != 255) {
+        UNIT_TILE[X] = 248; // first tile for explosion
+        UNIT_TIMER_A[X] = 1;
+        UNIT_LOC_X[X] = UNIT_LOC_X[0];
+        UNIT_LOC_Y[X] = UNIT_LOC_Y[0];
     }
 }
 
-void EVILBOT()
+void Game::EVILBOT()
 {
     UNIT_TIMER_A[UNIT] = 5;
     // first animate evilbot
@@ -3724,18 +3922,7 @@ void EVILBOT()
         UNIT_TIMER_B[UNIT] = 1; // Reset timer B
         CHECK_FOR_WINDOW_REDRAW();
         MOVE_TYPE = 0x01; // %00000001 WALK
-        // CHECK FOR HORIZONTAL MOVEMENT
-        if (UNIT_LOC_X[UNIT] > UNIT_LOC_X[0]) {
-            REQUEST_WALK_LEFT();
-        } else if (UNIT_LOC_X[UNIT] < UNIT_LOC_X[0]) {
-            REQUEST_WALK_RIGHT();
-        }
-        // NOW CHECK FOR VERITCAL MOVEMENT
-        if (UNIT_LOC_Y[UNIT] > UNIT_LOC_Y[0]) {
-            REQUEST_WALK_UP();
-        } else if (UNIT_LOC_Y[UNIT] < UNIT_LOC_Y[0]) {
-            REQUEST_WALK_DOWN();
-        }
+        MOVE_TOWARD_PLAYER();
         ROBOT_ATTACK_RANGE();
         if (PROX_DETECT == 1) { // 1=Robot next to player 0=not
             TEMP_A = 5; // amount of damage it will inflict
@@ -3752,23 +3939,23 @@ void EVILBOT()
 // This routine handles automatic sliding doors.
 // UNIT_B register means:
 // 0=opening-A 1=opening-B 2=OPEN 3=closing-A 4=closing-B 5-CLOSED
-void AI_DOOR()
+void Game::AI_DOOR()
 {
     if (UNIT_B[UNIT] < 6) { // make sure number is in bounds
-        AIDB[UNIT_B[UNIT]]();
+        (this->*AIDB[UNIT_B[UNIT]])();
     }
     // -SHOULD NEVER NEED TO HAPPEN
 }
-void (*AIDB[])(void) = {
-    DOOR_OPEN_A,
-    DOOR_OPEN_B,
-    DOOR_OPEN_FULL,
-    DOOR_CLOSE_A,
-    DOOR_CLOSE_B,
-    DOOR_CLOSE_FULL
+void (Game::*Game::AIDB[])() = {
+    &Game::DOOR_OPEN_A,
+    &Game::DOOR_OPEN_B,
+    &Game::DOOR_OPEN_FULL,
+    &Game::DOOR_CLOSE_A,
+    &Game::DOOR_CLOSE_B,
+    &Game::DOOR_CLOSE_FULL
 };
 
-void DOOR_OPEN_A()
+void Game::DOOR_OPEN_A()
 {
     if (UNIT_A[UNIT] != 1) {
         // HORIZONTAL DOOR
@@ -3785,10 +3972,9 @@ void DOOR_OPEN_A()
     }
     UNIT_B[UNIT] = 1;
     UNIT_TIMER_A[UNIT] = 5;
-    CHECK_FOR_WINDOW_REDRAW();
 }
 
-void DOOR_OPEN_B()
+void Game::DOOR_OPEN_B()
 {
     if (UNIT_A[UNIT] != 1) {
         // HORIZONTAL DOOR
@@ -3805,10 +3991,9 @@ void DOOR_OPEN_B()
     }
     UNIT_B[UNIT] = 2;
     UNIT_TIMER_A[UNIT] = 30;
-    CHECK_FOR_WINDOW_REDRAW();
 }
 
-void DOOR_OPEN_FULL()
+void Game::DOOR_OPEN_FULL()
 {
     DOOR_CHECK_PROXIMITY();
     if (PROX_DETECT == 1) {
@@ -3841,10 +4026,9 @@ void DOOR_OPEN_FULL()
     }
     UNIT_B[UNIT] = 3;
     UNIT_TIMER_A[UNIT] = 5;
-    CHECK_FOR_WINDOW_REDRAW();
 }
 
-void DOOR_CLOSE_A()
+void Game::DOOR_CLOSE_A()
 {
     if (UNIT_A[UNIT] != 1) {
         // HORIZONTAL DOOR
@@ -3861,10 +4045,9 @@ void DOOR_CLOSE_A()
     }
     UNIT_B[UNIT] = 4;
     UNIT_TIMER_A[UNIT] = 5;
-    CHECK_FOR_WINDOW_REDRAW();
 }
 
-void DOOR_CLOSE_B()
+void Game::DOOR_CLOSE_B()
 {
     if (UNIT_A[UNIT] != 1) {
         // HORIZONTAL DOOR
@@ -3881,10 +4064,9 @@ void DOOR_CLOSE_B()
     }
     UNIT_B[UNIT] = 5;
     UNIT_TIMER_A[UNIT] = 5;
-    CHECK_FOR_WINDOW_REDRAW();
 }
 
-void DOOR_CLOSE_FULL()
+void Game::DOOR_CLOSE_FULL()
 {
     DOOR_CHECK_PROXIMITY();
     if (PROX_DETECT != 0) {
@@ -3911,47 +4093,35 @@ void DOOR_CLOSE_FULL()
             }
             UNIT_B[UNIT] = 0;
             UNIT_TIMER_A[UNIT] = 5;
-            CHECK_FOR_WINDOW_REDRAW();
             return;
         }
     }
     UNIT_TIMER_A[UNIT] = 20; // RESET TIMER
 }
 
-void DRAW_VERTICAL_DOOR()
+void Game::DRAW_VERTICAL_DOOR()
 {
     MAP_Y = UNIT_LOC_Y[UNIT];
     MAP_Y--;
     MAP_X = UNIT_LOC_X[UNIT];
     TILE = DOORPIECE1;
     PLOT_TILE_TO_MAP();
-    MAP_SOURCE += 128;
-    MAP_SOURCE[0] = DOORPIECE2;
-    MAP_SOURCE += 128;
-    MAP_SOURCE[0] = DOORPIECE3;
-    if (LIVE_MAP_ON == 1) {
-        platform->renderLiveMapTile(MAP, UNIT_LOC_X[UNIT], UNIT_LOC_Y[UNIT]);
-    }
+    WRITE_MAP_TILE(MAP_X, MAP_Y + 1, DOORPIECE2);
+    WRITE_MAP_TILE(MAP_X, MAP_Y + 2, DOORPIECE3);
 }
 
-void DRAW_HORIZONTAL_DOOR()
+void Game::DRAW_HORIZONTAL_DOOR()
 {
     MAP_X = UNIT_LOC_X[UNIT];
     MAP_X--;
     MAP_Y = UNIT_LOC_Y[UNIT];
     TILE = DOORPIECE1;
     PLOT_TILE_TO_MAP();
-    MAP_SOURCE[1] = DOORPIECE2;
-    MAP_SOURCE[2] = DOORPIECE3;
-    if (LIVE_MAP_ON == 1) {
-        platform->renderLiveMapTile(MAP, UNIT_LOC_X[UNIT], UNIT_LOC_Y[UNIT]);
-    }
+    WRITE_MAP_TILE(MAP_X + 1, MAP_Y, DOORPIECE2);
+    WRITE_MAP_TILE(MAP_X + 2, MAP_Y, DOORPIECE3);
 }
-uint8_t DOORPIECE1 = 0;
-uint8_t DOORPIECE2 = 0;
-uint8_t DOORPIECE3 = 0;
 
-void ROBOT_ATTACK_RANGE()
+void Game::ROBOT_ATTACK_RANGE()
 {
     /*
     // This is the original code that does not quite work as intended
@@ -3976,7 +4146,219 @@ void ROBOT_ATTACK_RANGE()
     PROX_DETECT = (X == 1 && Y == 0) || (X == 0 && Y == 1) ? 1 : 0;
 }
 
-void DOOR_CHECK_PROXIMITY()
+// Used by the EVILBOT and the attacking hoverbots, MOVE_TYPE must
+// be set first
+void Game::MOVE_TOWARD_PLAYER()
+{
+#ifdef PLATFORM_CHASE_FLOW_FIELD
+    if (CHASE_PLAYER()) {
+        return;
+    }
+#endif
+    // CHECK FOR HORIZONTAL MOVEMENT
+    if (UNIT_LOC_X[UNIT] > UNIT_LOC_X[0]) {
+        REQUEST_WALK_LEFT();
+    } else if (UNIT_LOC_X[UNIT] < UNIT_LOC_X[0]) {
+        REQUEST_WALK_RIGHT();
+    }
+    // NOW CHECK FOR VERITCAL MOVEMENT
+    if (UNIT_LOC_Y[UNIT] > UNIT_LOC_Y[0]) {
+        REQUEST_WALK_UP();
+    } else if (UNIT_LOC_Y[UNIT] < UNIT_LOC_Y[0]) {
+        REQUEST_WALK_DOWN();
+    }
+}
+
+#ifdef PLATFORM_CHASE_FLOW_FIELD
+// Starts a breadth first search for the number of steps to the player
+// over the tiles that a walking (FIELD 0) or hovering (FIELD 1) unit
+// can enter. The distances are shared by all chasing units and only
+// started again after the player has moved or the passability of a
+// tile has changed.
+void Game::RESET_CHASE_FIELD(uint8_t FIELD)
+{
+    uint16_t* DISTANCE = CHASE_DISTANCE[FIELD];
+    for (uint32_t i = 0; i != CHASE_CELLS; i++) {
+        DISTANCE[i] = 0xffff;
+    }
+    CHASE_X[FIELD] = UNIT_LOC_X[0];
+    CHASE_Y[FIELD] = UNIT_LOC_Y[0];
+    CHASE_VALID[FIELD] = 1;
+    uint16_t START = UNIT_LOC_Y[0] * MAP_UNIT_WIDTH + UNIT_LOC_X[0];
+    DISTANCE[START] = 0;
+    CHASE_QUEUE[FIELD][0] = START;
+    CHASE_HEAD[FIELD] = 0;
+    CHASE_TAIL[FIELD] = 1;
+}
+
+// Continues the search until the TARGET tile has its distance or
+// nothing more can be reached. When a tile gets its distance all the
+// tiles closer to the player already have theirs. The map limits are
+// the same as in the REQUEST_WALK routines.
+void Game::EXPAND_CHASE_FIELD(uint8_t FIELD, uint16_t TARGET)
+{
+    uint16_t* DISTANCE = CHASE_DISTANCE[FIELD];
+    uint16_t* QUEUE = CHASE_QUEUE[FIELD];
+    uint32_t (*PLANE)[PLANE_ROW_WORDS] = MAP_PLANES[FIELD]; // PLANE_WALK or PLANE_HOVER
+    uint16_t HEAD = CHASE_HEAD[FIELD];
+    uint16_t TAIL = CHASE_TAIL[FIELD];
+    while (DISTANCE[TARGET] == 0xffff && HEAD != TAIL) {
+        uint16_t CELL = QUEUE[HEAD++];
+        uint8_t X = CELL % MAP_UNIT_WIDTH;
+        uint8_t Y = CELL / MAP_UNIT_WIDTH;
+        uint16_t STEPS = DISTANCE[CELL] + 1;
+        if (Y != MAP_WALK_TOP && DISTANCE[CELL - MAP_UNIT_WIDTH] == 0xffff && ((PLANE[Y - 1][X >> 5] >> (X & 31)) & 1)) {
+            DISTANCE[CELL - MAP_UNIT_WIDTH] = STEPS;
+            QUEUE[TAIL++] = CELL - MAP_UNIT_WIDTH;
+        }
+        if (Y != MAP_WALK_BOTTOM && DISTANCE[CELL + MAP_UNIT_WIDTH] == 0xffff && ((PLANE[Y + 1][X >> 5] >> (X & 31)) & 1)) {
+            DISTANCE[CELL + MAP_UNIT_WIDTH] = STEPS;
+            QUEUE[TAIL++] = CELL + MAP_UNIT_WIDTH;
+        }
+        if (X != MAP_WALK_LEFT && DISTANCE[CELL - 1] == 0xffff && ((PLANE[Y][(X - 1) >> 5] >> ((X - 1) & 31)) & 1)) {
+            DISTANCE[CELL - 1] = STEPS;
+            QUEUE[TAIL++] = CELL - 1;
+        }
+        if (X != MAP_WALK_RIGHT && DISTANCE[CELL + 1] == 0xffff && ((PLANE[Y][(X + 1) >> 5] >> ((X + 1) & 31)) & 1)) {
+            DISTANCE[CELL + 1] = STEPS;
+            QUEUE[TAIL++] = CELL + 1;
+        }
+    }
+    CHASE_HEAD[FIELD] = HEAD;
+    CHASE_TAIL[FIELD] = TAIL;
+    if (HEAD == TAIL && CHASE_AREA_VALID[FIELD] == 0) {
+        // Everything reachable was found, remember the area
+        for (uint16_t Y = 0; Y != PLATFORM_MAP_HEIGHT; Y++) {
+            for (uint16_t WORD = 0; WORD != PLANE_ROW_WORDS; WORD++) {
+                CHASE_AREA[FIELD][Y][WORD] = 0;
+            }
+        }
+        for (uint16_t i = 0; i != TAIL; i++) {
+            uint8_t X = QUEUE[i] % MAP_UNIT_WIDTH;
+            uint8_t Y = QUEUE[i] / MAP_UNIT_WIDTH;
+            CHASE_AREA[FIELD][Y][X >> 5] |= 1UL << (X & 31);
+        }
+        CHASE_AREA_VALID[FIELD] = 1;
+    }
+}
+
+// Drops the distances and the area of FIELD if the change of
+// passability at X/Y can affect them
+void Game::CHASE_TILE_CHANGED(uint8_t FIELD, uint16_t X, uint16_t Y)
+{
+    if (X < MAP_WALK_LEFT || X > MAP_WALK_RIGHT || Y < MAP_WALK_TOP || Y > MAP_WALK_BOTTOM) { // Never searched
+        return;
+    }
+    uint16_t CELL = Y * MAP_UNIT_WIDTH + X;
+    uint16_t* DISTANCE = CHASE_DISTANCE[FIELD];
+    uint32_t (*AREA)[PLANE_ROW_WORDS] = CHASE_AREA[FIELD];
+    if (MAP_PLANE(FIELD, X, Y)) {
+        // Opened, matters if the search has already been next to it
+        if (DISTANCE[CELL - MAP_UNIT_WIDTH] != 0xffff || DISTANCE[CELL + MAP_UNIT_WIDTH] != 0xffff ||
+            DISTANCE[CELL - 1] != 0xffff || DISTANCE[CELL + 1] != 0xffff) {
+            CHASE_VALID[FIELD] = 0;
+        }
+        if (((AREA[Y - 1][X >> 5] | AREA[Y + 1][X >> 5]) >> (X & 31)) & 1 ||
+            (AREA[Y][(X - 1) >> 5] >> ((X - 1) & 31)) & 1 ||
+            (AREA[Y][(X + 1) >> 5] >> ((X + 1) & 31)) & 1) {
+            CHASE_AREA_VALID[FIELD] = 0;
+        }
+    } else {
+        // Closed, matters if the search has already been through it
+        if (DISTANCE[CELL] != 0xffff) {
+            CHASE_VALID[FIELD] = 0;
+        }
+        if ((AREA[Y][X >> 5] >> (X & 31)) & 1) {
+            CHASE_AREA_VALID[FIELD] = 0;
+        }
+    }
+}
+
+// Moves the unit up to one step vertically and one horizontally
+// downhill in the distance field, like the original moves up to one
+// step on each axis toward the player. Returns false if the player
+// can't be reached from where the unit is.
+bool Game::CHASE_PLAYER()
+{
+    uint8_t FIELD = MOVE_TYPE >> 1; // %01 walk or %10 hover
+    uint16_t* DISTANCE = CHASE_DISTANCE[FIELD];
+    uint16_t START = UNIT_LOC_Y[UNIT] * MAP_UNIT_WIDTH + UNIT_LOC_X[UNIT];
+    if (CHASE_AREA_VALID[FIELD] == 1) {
+        // If the player is still in the area the unit was cut off from, so is the unit
+        uint32_t (*AREA)[PLANE_ROW_WORDS] = CHASE_AREA[FIELD];
+        if (((AREA[UNIT_LOC_Y[0]][UNIT_LOC_X[0] >> 5] >> (UNIT_LOC_X[0] & 31)) & 1) &&
+            !((AREA[UNIT_LOC_Y[UNIT]][UNIT_LOC_X[UNIT] >> 5] >> (UNIT_LOC_X[UNIT] & 31)) & 1)) {
+            return false;
+        }
+    }
+#ifdef PLATFORM_PROFILE
+    platform->startProfile(PROFILE_CHASE_FIELD);
+#endif
+    if (CHASE_VALID[FIELD] == 0 || CHASE_X[FIELD] != UNIT_LOC_X[0] || CHASE_Y[FIELD] != UNIT_LOC_Y[0]) {
+        RESET_CHASE_FIELD(FIELD);
+    }
+    EXPAND_CHASE_FIELD(FIELD, START);
+#ifdef PLATFORM_PROFILE
+    platform->stopProfile(PROFILE_CHASE_FIELD);
+#endif
+    if (DISTANCE[START] == 0xffff) {
+        return false;
+    }
+    bool VERTICAL = true;
+    bool HORIZONTAL = true;
+    while (VERTICAL || HORIZONTAL) {
+        uint16_t CELL = UNIT_LOC_Y[UNIT] * MAP_UNIT_WIDTH + UNIT_LOC_X[UNIT];
+        uint16_t BEST = DISTANCE[CELL];
+        uint8_t BEST_DIRECTION = 255; // 0=UP 1=DOWN 2=LEFT 3=RIGHT
+        if (VERTICAL) {
+            if (DISTANCE[CELL - MAP_UNIT_WIDTH] < BEST) {
+                BEST = DISTANCE[CELL - MAP_UNIT_WIDTH];
+                BEST_DIRECTION = 0;
+            }
+            if (DISTANCE[CELL + MAP_UNIT_WIDTH] < BEST) {
+                BEST = DISTANCE[CELL + MAP_UNIT_WIDTH];
+                BEST_DIRECTION = 1;
+            }
+        }
+        if (HORIZONTAL) {
+            if (DISTANCE[CELL - 1] < BEST) {
+                BEST = DISTANCE[CELL - 1];
+                BEST_DIRECTION = 2;
+            }
+            if (DISTANCE[CELL + 1] < BEST) {
+                BEST = DISTANCE[CELL + 1];
+                BEST_DIRECTION = 3;
+            }
+        }
+        switch (BEST_DIRECTION) {
+        case 0:
+            REQUEST_WALK_UP();
+            VERTICAL = false;
+            break;
+        case 1:
+            REQUEST_WALK_DOWN();
+            VERTICAL = false;
+            break;
+        case 2:
+            REQUEST_WALK_LEFT();
+            HORIZONTAL = false;
+            break;
+        case 3:
+            REQUEST_WALK_RIGHT();
+            HORIZONTAL = false;
+            break;
+        default:
+            return true;
+        }
+        if (MOVE_RESULT != 1) { // Blocked by a unit
+            return true;
+        }
+    }
+    return true;
+}
+#endif
+
+void Game::DOOR_CHECK_PROXIMITY()
 {
     // First check horizontal proximity to door
     int A = ABS(UNIT_LOC_X[UNIT] - UNIT_LOC_X[0]); // DOOR UNIT, PLAYER UNIT
@@ -3993,28 +4375,27 @@ void DOOR_CHECK_PROXIMITY()
     // PLAYER DETECTED, CHANGE DOOR MODE.
     PROX_DETECT = 1;
 }
-uint8_t PROX_DETECT = 0; // 0=NO 1=YES
 
 // This routine handles automatic sliding doors.
 // UNIT_B register means:
 // 0=opening-A 1=opening-B 2=OPEN 3=closing-A 4=closing-B 5-CLOSED
-void ELEVATOR()
+void Game::ELEVATOR()
 {
     if (UNIT_B[UNIT] < 6) { // make sure number is in bounds
-        ELDB[UNIT_B[UNIT]]();
+        (this->*ELDB[UNIT_B[UNIT]])();
     }
     // -SHOULD NEVER NEED TO HAPPEN
 }
-void (*ELDB[])(void) = {
-    ELEV_OPEN_A,
-    ELEV_OPEN_B,
-    ELEV_OPEN_FULL,
-    ELEV_CLOSE_A,
-    ELEV_CLOSE_B,
-    ELEV_CLOSE_FULL
+void (Game::*Game::ELDB[])() = {
+    &Game::ELEV_OPEN_A,
+    &Game::ELEV_OPEN_B,
+    &Game::ELEV_OPEN_FULL,
+    &Game::ELEV_CLOSE_A,
+    &Game::ELEV_CLOSE_B,
+    &Game::ELEV_CLOSE_FULL
 };
 
-void ELEV_OPEN_A()
+void Game::ELEV_OPEN_A()
 {
     DOORPIECE1 = 181;
     DOORPIECE2 = 89;
@@ -4025,7 +4406,7 @@ void ELEV_OPEN_A()
     CHECK_FOR_WINDOW_REDRAW();
 }
 
-void ELEV_OPEN_B()
+void Game::ELEV_OPEN_B()
 {
     DOORPIECE1 = 182;
     DOORPIECE2 = 9;
@@ -4036,7 +4417,7 @@ void ELEV_OPEN_B()
     CHECK_FOR_WINDOW_REDRAW();
 }
 
-void ELEV_OPEN_FULL()
+void Game::ELEV_OPEN_FULL()
 {
     // CLOSE DOOR
     // check for object in the way first.
@@ -4065,7 +4446,7 @@ void ELEV_OPEN_FULL()
     CHECK_FOR_WINDOW_REDRAW();
 }
 
-void ELEV_CLOSE_A()
+void Game::ELEV_CLOSE_A()
 {
     DOORPIECE1 = 84;
     DOORPIECE2 = 85;
@@ -4076,7 +4457,7 @@ void ELEV_CLOSE_A()
     CHECK_FOR_WINDOW_REDRAW();
 }
 
-void ELEV_CLOSE_B()
+void Game::ELEV_CLOSE_B()
 {
     DOORPIECE1 = 80;
     DOORPIECE2 = 81;
@@ -4088,7 +4469,7 @@ void ELEV_CLOSE_B()
     ELEVATOR_PANEL();
 }
 
-void ELEV_CLOSE_FULL()
+void Game::ELEV_CLOSE_FULL()
 {
     DOOR_CHECK_PROXIMITY();
     if (PROX_DETECT == 0) {
@@ -4106,7 +4487,7 @@ void ELEV_CLOSE_FULL()
     CHECK_FOR_WINDOW_REDRAW();
 }
 
-void ELEVATOR_PANEL()
+void Game::ELEVATOR_PANEL()
 {
     // Check to see if player is standing in the
     // elevator first.
@@ -4120,25 +4501,101 @@ void ELEVATOR_PANEL()
     ELEVATOR_SELECT();
 }
 
-void PLOT_TILE_TO_MAP()
+void Game::PLOT_TILE_TO_MAP()
 {
-    MAP_SOURCE = MAP + (MAP_Y << 7) + MAP_X;
-    MAP_SOURCE[0] = TILE;
+    MAP_SOURCE = MAP + MAP_CELL(MAP_X, MAP_Y);
+    WRITE_MAP_TILE(MAP_X, MAP_Y, TILE);
 }
 
 // This routine will return the tile for a specific X/Y
 // on the map.  You must first define MAP_X and MAP-Y.
 // The result is stored in TILE.
-void GET_TILE_FROM_MAP()
+void Game::GET_TILE_FROM_MAP()
 {
-    MAP_SOURCE = MAP + ((MAP_Y << 7) + MAP_X);
+    MAP_SOURCE = MAP + MAP_CELL(MAP_X, MAP_Y);
     TILE = MAP_SOURCE[0];
 }
 
+// All changes to the map go through here, so that the map window,
+// the live map and the rewind history only need to look at the
+// tiles in the journal instead of the whole map.
+void Game::WRITE_MAP_TILE(uint16_t X, uint16_t Y, uint8_t NEW_TILE)
+{
+    uint8_t* DESTINATION = MAP + MAP_CELL(X, Y);
+    if (*DESTINATION == NEW_TILE) {
+        return;
+    }
+    if (MAP_JOURNAL_COUNT != PLATFORM_MAP_JOURNAL_SIZE) {
+        map_change_t& CHANGE = MAP_JOURNAL[MAP_JOURNAL_COUNT++];
+        CHANGE.x = X;
+        CHANGE.y = Y;
+        CHANGE.previous = *DESTINATION;
+        CHANGE.tile = NEW_TILE;
+    } else {
+        MAP_JOURNAL_OVERFLOW = 1;
+    }
+    MARK_PAGE_STALE(X, Y);
+    uint8_t CHANGED = (TILE_ATTRIB[*DESTINATION] ^ TILE_ATTRIB[NEW_TILE]) & ((1 << PLANE_COUNT) - 1);
+    *DESTINATION = NEW_TILE;
+    if (CHANGED == 0) {
+        return;
+    }
+    for (uint8_t PLANE = 0; PLANE != PLANE_COUNT; PLANE++) {
+        if (CHANGED & (1 << PLANE)) {
+            MAP_PLANES[PLANE][Y][X >> 5] ^= 1UL << (X & 31);
+        }
+    }
+#ifdef PLATFORM_CHASE_FLOW_FIELD
+    if (CHANGED & (1 << PLANE_WALK)) {
+        CHASE_TILE_CHANGED(0, X, Y);
+    }
+    if (CHANGED & (1 << PLANE_HOVER)) {
+        CHASE_TILE_CHANGED(1, X, Y);
+    }
+#endif
+}
+
+void Game::BUILD_MAP_PLANES()
+{
+    for (uint8_t PLANE = 0; PLANE != PLANE_COUNT; PLANE++) {
+        for (uint16_t Y = 0; Y != PLATFORM_MAP_HEIGHT; Y++) {
+            for (uint16_t WORD = 0; WORD != PLANE_ROW_WORDS; WORD++) {
+                uint32_t BITS = 0;
+                for (uint16_t X = WORD << 5; X != (WORD << 5) + 32 && X != PLATFORM_MAP_WIDTH; X++) {
+                    if (TILE_ATTRIB[MAP[MAP_CELL(X, Y)]] & (1 << PLANE)) {
+                        BITS |= 1UL << (X & 31);
+                    }
+                }
+                MAP_PLANES[PLANE][Y][WORD] = BITS;
+            }
+        }
+    }
+#ifdef PLATFORM_CHASE_FLOW_FIELD
+    CHASE_VALID[0] = 0;
+    CHASE_VALID[1] = 0;
+    CHASE_AREA_VALID[0] = 0;
+    CHASE_AREA_VALID[1] = 0;
+#endif
+}
+
+// Tests an attribute of the tile at X/Y, see the PLANE_ defines
+bool Game::MAP_PLANE(uint8_t PLANE, uint16_t X, uint16_t Y)
+{
+    return (MAP_PLANES[PLANE][Y][X >> 5] >> (X & 31)) & 1;
+}
+
+// Called once per tick after the map window, the live map and the
+// rewind history have seen the changes
+void Game::CLEAR_MAP_JOURNAL()
+{
+    MAP_JOURNAL_COUNT = 0;
+    MAP_JOURNAL_OVERFLOW = 0;
+}
+
 // In this AI routine, the droid simply goes left until it
 // hits an object, and then reverses direction and does the
 // same, bouncing back and forth.
-void LEFT_RIGHT_DROID()
+void Game::LEFT_RIGHT_DROID()
 {
     HOVERBOT_ANIMATE(UNIT);
     UNIT_TIMER_A[UNIT] = 10; // reset timer to 10
@@ -4164,7 +4621,7 @@ void LEFT_RIGHT_DROID()
 // In this AI routine, the droid simply goes UP until it
 // hits an object, and then reverses direction and does the
 // same, bouncing back and forth.
-void UP_DOWN_DROID()
+void Game::UP_DOWN_DROID()
 {
     HOVERBOT_ANIMATE(UNIT);
     UNIT_TIMER_A[UNIT] = 10; // reset timer to 10
@@ -4187,7 +4644,7 @@ void UP_DOWN_DROID()
     }
 }
 
-void HOVERBOT_ANIMATE(uint8_t X)
+void Game::HOVERBOT_ANIMATE(uint8_t X)
 {
     if (UNIT_TIMER_B[X] != 0) {
         UNIT_TIMER_B[X]--;
@@ -4206,15 +4663,14 @@ void HOVERBOT_ANIMATE(uint8_t X)
 // specific direction.  It checks for edge of map and also that
 // the tile you want to walk onto can allow that.  There is a
 // separate routine for hovering robots.
-void REQUEST_WALK_RIGHT()
+void Game::REQUEST_WALK_RIGHT()
 {
     UNIT_DIRECTION[UNIT] = 3;
-    if (UNIT_LOC_X[UNIT] != 122) {
+    if (UNIT_LOC_X[UNIT] != MAP_WALK_RIGHT) {
         MAP_X = UNIT_LOC_X[UNIT];
         MAP_X++;
         MAP_Y = UNIT_LOC_Y[UNIT];
-        GET_TILE_FROM_MAP();
-        if ((TILE_ATTRIB[TILE] & MOVE_TYPE) == MOVE_TYPE) { // Check, can walk on this tile?
+        if (MAP_PLANE(MOVE_TYPE >> 1, MAP_X, MAP_Y)) { // Check, can walk on this tile? MOVE_TYPE %01 walk or %10 hover
             CHECK_FOR_UNIT();
             if (UNIT_FIND == 255) {
                 UNIT_LOC_X[UNIT]++;
@@ -4226,15 +4682,14 @@ void REQUEST_WALK_RIGHT()
     MOVE_RESULT = 0; // Move fail
 }
 
-void REQUEST_WALK_LEFT()
+void Game::REQUEST_WALK_LEFT()
 {
     UNIT_DIRECTION[UNIT] = 2;
-    if (UNIT_LOC_X[UNIT] != 5) {
+    if (UNIT_LOC_X[UNIT] != MAP_WALK_LEFT) {
         MAP_X = UNIT_LOC_X[UNIT];
         MAP_X--;
         MAP_Y = UNIT_LOC_Y[UNIT];
-        GET_TILE_FROM_MAP();
-        if ((TILE_ATTRIB[TILE] & MOVE_TYPE) == MOVE_TYPE) { // Check, can walk on this tile?
+        if (MAP_PLANE(MOVE_TYPE >> 1, MAP_X, MAP_Y)) { // Check, can walk on this tile? MOVE_TYPE %01 walk or %10 hover
             CHECK_FOR_UNIT();
             if (UNIT_FIND == 255) {
                 UNIT_LOC_X[UNIT]--;
@@ -4246,15 +4701,14 @@ void REQUEST_WALK_LEFT()
     MOVE_RESULT = 0; // Move fail
 }
 
-void REQUEST_WALK_DOWN()
+void Game::REQUEST_WALK_DOWN()
 {
     UNIT_DIRECTION[UNIT] = 1;
-    if (UNIT_LOC_Y[UNIT] != 60) {
+    if (UNIT_LOC_Y[UNIT] != MAP_WALK_BOTTOM) {
         MAP_Y = UNIT_LOC_Y[UNIT];
         MAP_Y++;
         MAP_X = UNIT_LOC_X[UNIT];
-        GET_TILE_FROM_MAP();
-        if ((TILE_ATTRIB[TILE] & MOVE_TYPE) == MOVE_TYPE) { // Check, can walk on this tile?
+        if (MAP_PLANE(MOVE_TYPE >> 1, MAP_X, MAP_Y)) { // Check, can walk on this tile? MOVE_TYPE %01 walk or %10 hover
             CHECK_FOR_UNIT();
             if (UNIT_FIND == 255) {
                 UNIT_LOC_Y[UNIT]++;
@@ -4266,15 +4720,14 @@ void REQUEST_WALK_DOWN()
     MOVE_RESULT = 0; // Move fail
 }
 
-void REQUEST_WALK_UP()
+void Game::REQUEST_WALK_UP()
 {
     UNIT_DIRECTION[UNIT] = 0;
-    if (UNIT_LOC_Y[UNIT] != 3) {
+    if (UNIT_LOC_Y[UNIT] != MAP_WALK_TOP) {
         MAP_Y = UNIT_LOC_Y[UNIT];
         MAP_Y--;
         MAP_X = UNIT_LOC_X[UNIT];
-        GET_TILE_FROM_MAP();
-        if ((TILE_ATTRIB[TILE] & MOVE_TYPE) == MOVE_TYPE) { // Check, can walk on this tile?
+        if (MAP_PLANE(MOVE_TYPE >> 1, MAP_X, MAP_Y)) { // Check, can walk on this tile? MOVE_TYPE %01 walk or %10 hover
             CHECK_FOR_UNIT();
             if (UNIT_FIND == 255) {
                 UNIT_LOC_Y[UNIT]--;
@@ -4290,10 +4743,10 @@ void REQUEST_WALK_UP()
 // in MAP_X and MAP_Y to see if there is a unit present at 
 // that spot. If so, the unit# will be stored in UNIT_FIND
 // otherwise 255 will be stored. 
-void CHECK_FOR_UNIT()
+void Game::CHECK_FOR_UNIT()
 {
-    for (int X = 0; X != 28; X++) {
-        if (UNIT_TYPE[X] != 0 && UNIT_LOC_X[X] == MAP_X && UNIT_LOC_Y[X] == MAP_Y) {
+    for (uint8_t X = NEXT_UNIT(0, UNIT_WEAPONS); X != UNIT_WEAPONS; X = NEXT_UNIT(X + 1, UNIT_WEAPONS)) {
+        if (UNIT_LOC_X[X] == MAP_X && UNIT_LOC_Y[X] == MAP_Y) {
             UNIT_FIND = X; // unit found
             return;
         }
@@ -4305,11 +4758,14 @@ void CHECK_FOR_UNIT()
 // in MAP_X and MAP_Y to see if there is a hidden unit present 
 // at that spot. If so, the unit# will be stored in UNIT_FIND
 // otherwise 255 will be stored. 
-void CHECK_FOR_HIDDEN_UNIT()
+void Game::CHECK_FOR_HIDDEN_UNIT()
 {
-    for (int X = 48; X != 64; X++) {
-        if (UNIT_TYPE[X] != 0 &&
-            (UNIT_LOC_X[X] == MAP_X || // first compare horizontal position
+    if (!((HIDDEN_PLANE[MAP_Y][MAP_X >> 5] >> (MAP_X & 31)) & 1)) {
+        UNIT_FIND = 255; // nothing hidden near this spot
+        return;
+    }
+    for (uint8_t X = NEXT_UNIT(UNIT_HIDDEN, UNIT_COUNT); X != UNIT_COUNT; X = NEXT_UNIT(X + 1, UNIT_COUNT)) {
+        if ((UNIT_LOC_X[X] == MAP_X || // first compare horizontal position
              (UNIT_LOC_X[X] <= MAP_X && (UNIT_LOC_X[X] + UNIT_C[X]) >= MAP_X)) && // add hidden unit width
             (UNIT_LOC_Y[X] == MAP_Y || // now compare vertical position
              (UNIT_LOC_Y[X] <= MAP_Y && (UNIT_LOC_Y[X] + UNIT_D[X]) >= MAP_Y))) { // add hidden unit HEIGHT
@@ -4320,6 +4776,169 @@ void CHECK_FOR_HIDDEN_UNIT()
     UNIT_FIND = 255; // no units found
 }
 
+uint8_t UNIT_RANGE_START[UNIT_RANGES + 1] = { UNIT_ROBOTS, UNIT_WEAPONS, UNIT_DOORS, UNIT_HIDDEN, UNIT_COUNT };
+
+// Sets the bit of each existing unit and counts the units from the
+// unit types of a newly loaded or restored map
+void Game::BUILD_UNIT_SLOTS()
+{
+    for (uint8_t WORD = 0; WORD != UNIT_WORDS; WORD++) {
+        UNIT_SLOTS[WORD] = 0;
+    }
+    for (int TYPE = 0; TYPE != 256; TYPE++) {
+        TYPE_UNITS[TYPE] = 0;
+    }
+    for (uint8_t X = 0; X != UNIT_COUNT; X++) {
+        if (UNIT_TYPE[X] != 0) {
+            UNIT_SLOTS[X >> 5] |= 1UL << (X & 31);
+        }
+        TYPE_UNITS[UNIT_TYPE[X]]++;
+    }
+    for (uint8_t RANGE = 0; RANGE != UNIT_RANGES; RANGE++) {
+        RANGE_UNITS[RANGE] = 0;
+        for (uint8_t X = UNIT_RANGE_START[RANGE]; X != UNIT_RANGE_START[RANGE + 1]; X++) {
+            RANGE_UNITS[RANGE] += UNIT_TYPE[X] != 0;
+        }
+    }
+}
+
+// Finds the first elevator of each floor and the tiles the hidden
+// objects cover, for levels that come without the index
+void Game::BUILD_LEVEL_INDEX()
+{
+    for (int FLOOR = 0; FLOOR != 256; FLOOR++) {
+        ELEVATOR_UNIT[FLOOR] = 255;
+    }
+    for (uint8_t X = UNIT_DOORS; X != UNIT_HIDDEN; X++) {
+        if (UNIT_TYPE[X] == 19 && ELEVATOR_UNIT[UNIT_C[X]] == 255) { // elevator
+            ELEVATOR_UNIT[UNIT_C[X]] = X;
+        }
+    }
+    for (uint16_t Y = 0; Y != PLATFORM_MAP_HEIGHT; Y++) {
+        for (uint16_t WORD = 0; WORD != PLANE_ROW_WORDS; WORD++) {
+            HIDDEN_PLANE[Y][WORD] = 0;
+        }
+    }
+    for (uint8_t X = NEXT_UNIT(UNIT_HIDDEN, UNIT_COUNT); X != UNIT_COUNT; X = NEXT_UNIT(X + 1, UNIT_COUNT)) {
+        MARK_HIDDEN_UNIT(X);
+    }
+}
+
+// Sets the tiles hidden object X covers in HIDDEN_PLANE. Tiles are only
+// cleared by BUILD_LEVEL_INDEX, so a set tile still needs a closer look.
+void Game::MARK_HIDDEN_UNIT(uint8_t X)
+{
+    uint16_t RIGHT = MIN(UNIT_LOC_X[X] + UNIT_C[X], PLATFORM_MAP_WIDTH - 1);
+    uint16_t BOTTOM = MIN(UNIT_LOC_Y[X] + UNIT_D[X], PLATFORM_MAP_HEIGHT - 1);
+    for (uint16_t Y = UNIT_LOC_Y[X]; Y <= BOTTOM; Y++) {
+        for (uint16_t COLUMN = UNIT_LOC_X[X]; COLUMN <= RIGHT; COLUMN++) {
+            HIDDEN_PLANE[Y][COLUMN >> 5] |= 1UL << (COLUMN & 31);
+        }
+    }
+}
+
+// Takes the first free slot of a range, the same one the original
+// search for a unit type of 0 would find, for a new unit of TYPE.
+// Returns the unit number or 255 if all slots are in use.
+uint8_t Game::ALLOCATE_UNIT(uint8_t RANGE, uint8_t TYPE)
+{
+    uint16_t X = UNIT_RANGE_START[RANGE];
+    uint8_t END = UNIT_RANGE_START[RANGE + 1];
+    while (X < END) {
+        uint32_t FREE = ~UNIT_SLOTS[X >> 5] >> (X & 31);
+        if (FREE != 0) {
+            X += __builtin_ctz(FREE);
+            if (X >= END) {
+                break;
+            }
+            UNIT_SLOTS[X >> 5] |= 1UL << (X & 31);
+            UNIT_TYPE[X] = TYPE;
+            TYPE_UNITS[0]--;
+            TYPE_UNITS[TYPE]++;
+            RANGE_UNITS[RANGE]++;
+            return X;
+        }
+        X = (X | 31) + 1;
+    }
+    return 255;
+}
+
+// Changes the type of unit X, which removes the unit if TYPE is 0
+void Game::SET_UNIT_TYPE(uint8_t X, uint8_t TYPE)
+{
+    if (TYPE == 0) {
+        RELEASE_UNIT(X);
+        return;
+    }
+    if (UNIT_TYPE[X] == 0) { // the player at the start of a game
+        UNIT_SLOTS[X >> 5] |= 1UL << (X & 31);
+        if (X != 0) {
+            RANGE_UNITS[UNIT_RANGE(X)]++;
+        }
+    }
+    TYPE_UNITS[UNIT_TYPE[X]]--;
+    TYPE_UNITS[TYPE]++;
+    UNIT_TYPE[X] = TYPE;
+}
+
+// Removes a unit and frees its slot
+void Game::RELEASE_UNIT(uint8_t X)
+{
+    if (UNIT_TYPE[X] == 0) {
+        return;
+    }
+    TYPE_UNITS[UNIT_TYPE[X]]--;
+    TYPE_UNITS[0]++;
+    if (X != 0) {
+        RANGE_UNITS[UNIT_RANGE(X)]--;
+    }
+    UNIT_TYPE[X] = 0;
+    UNIT_SLOTS[X >> 5] &= ~(1UL << (X & 31));
+}
+
+// Compares the unit counts with the unit table
+void Game::CHECK_UNIT_COUNTS()
+{
+    uint8_t TYPES[256] = { 0 };
+    for (uint8_t X = 0; X != UNIT_COUNT; X++) {
+        TYPES[UNIT_TYPE[X]]++;
+        if (((UNIT_SLOTS[X >> 5] >> (X & 31)) & 1) != (UNIT_TYPE[X] != 0)) {
+            debug("Unit %d of type %d doesn't match its slot\n", X, UNIT_TYPE[X]);
+        }
+    }
+    for (int TYPE = 0; TYPE != 256; TYPE++) {
+        if (TYPES[TYPE] != TYPE_UNITS[TYPE]) {
+            debug("%d units of type %d, counted %d\n", TYPES[TYPE], TYPE, TYPE_UNITS[TYPE]);
+        }
+    }
+    for (uint8_t RANGE = 0; RANGE != UNIT_RANGES; RANGE++) {
+        uint8_t UNITS = 0;
+        for (uint8_t X = UNIT_RANGE_START[RANGE]; X != UNIT_RANGE_START[RANGE + 1]; X++) {
+            UNITS += UNIT_TYPE[X] != 0;
+        }
+        if (UNITS != RANGE_UNITS[RANGE]) {
+            debug("%d units in range %d, counted %d\n", UNITS, RANGE, RANGE_UNITS[RANGE]);
+        }
+    }
+}
+
+// Returns the first existing unit from X on, or END if there is none
+// before it. Going through the units this way costs one step for each
+// existing unit and for each 32 slots, and sees units that are added
+// or removed on the way just like checking every unit type does.
+uint8_t Game::NEXT_UNIT(uint16_t X, uint8_t END)
+{
+    while (X < END) {
+        uint32_t BITS = UNIT_SLOTS[X >> 5] >> (X & 31);
+        if (BITS != 0) {
+            X += __builtin_ctz(BITS);
+            return X < END ? X : END;
+        }
+        X = (X | 31) + 1;
+    }
+    return END;
+}
+
 uint8_t SCR_CUSTOM_KEYS[] = {
     0x55, 0x60, 0x40, 0x03, 0x73, 0x01, 0x14, 0x14, 0x01, 0x03, 0x0B, 0x20, 0x0F, 0x06, 0x20,
     0x14, 0x08, 0x05, 0x20, 0x10, 0x05, 0x14, 0x13, 0x03, 0x09, 0x09, 0x20, 0x12, 0x0F, 0x02,
@@ -4366,12 +4985,468 @@ void convertToPETSCII(char* string)
     }
 }
 
-void writeToScreenMemory(address_t address, uint8_t value, uint8_t color, uint8_t yOffset)
+void Game::writeToScreenMemory(address_t address, uint8_t value, uint8_t color, uint8_t yOffset)
 {
     SCREEN_MEMORY[address] = value;
     platform->writeToScreenMemory(address, value, color, yOffset);
 }
 
+// SAVE STATES
+// A snapshot starts with a 10 byte header: "PR" followed by the
+// version number, the number of state blocks, the number of units of
+// the build, the map width and height in two bytes each and 1 if the
+// map is stored in chunks, so that a snapshot of a build with another
+// map layout is not restored. Then comes the
+// map file data, the state blocks in the order of STATE_BLOCKS[]
+// and finally the platform specific audio state preceded by its
+// size in two bytes.
+#define STATE_BLOCK(member) { offsetof(GameState, member), sizeof(((GameState*)0)->member) }
+state_block_t STATE_BLOCKS[] = {
+    STATE_BLOCK(UNIT_TIMER_A),
+    STATE_BLOCK(UNIT_TIMER_B),
+    STATE_BLOCK(UNIT_TILE),
+    STATE_BLOCK(UNIT_DIRECTION),
+    STATE_BLOCK(EXP_BUFFER),
+    STATE_BLOCK(EXP_REACH),
+    STATE_BLOCK(MAPNAME),
+    STATE_BLOCK(SELECTED_MAP),
+    STATE_BLOCK(DIFF_LEVEL),
+    STATE_BLOCK(WALK_FRAME),
+    STATE_BLOCK(DEMATERIALIZE_FRAME),
+    STATE_BLOCK(MAP_WINDOW_X),
+    STATE_BLOCK(MAP_WINDOW_Y),
+    STATE_BLOCK(KEYS),
+    STATE_BLOCK(AMMO_PISTOL),
+    STATE_BLOCK(AMMO_PLASMA),
+    STATE_BLOCK(INV_BOMBS),
+    STATE_BLOCK(INV_EMP),
+    STATE_BLOCK(INV_MEDKIT),
+    STATE_BLOCK(INV_MAGNET),
+    STATE_BLOCK(SELECTED_WEAPON),
+    STATE_BLOCK(SELECTED_ITEM),
+    STATE_BLOCK(SELECT_TIMEOUT),
+    STATE_BLOCK(ANIMATE),
+    STATE_BLOCK(BIG_EXP_ACT),
+    STATE_BLOCK(MAGNET_ACT),
+    STATE_BLOCK(PLASMA_ACT),
+    STATE_BLOCK(RANDOM),
+    STATE_BLOCK(BORDER),
+    STATE_BLOCK(SCREEN_SHAKE),
+    STATE_BLOCK(BORDER_COLOR),
+    STATE_BLOCK(MUSIC_ON),
+    STATE_BLOCK(BGTIMER1),
+    STATE_BLOCK(BGTIMER2),
+    STATE_BLOCK(KEYTIMER),
+    STATE_BLOCK(KEY_FAST),
+    STATE_BLOCK(HOURS),
+    STATE_BLOCK(MINUTES),
+    STATE_BLOCK(SECONDS),
+    STATE_BLOCK(CYCLES),
+    STATE_BLOCK(CLOCK_ACTIVE),
+    STATE_BLOCK(LIVE_MAP_ON),
+    STATE_BLOCK(LIVE_MAP_ROBOTS_ON),
+    STATE_BLOCK(WATER_TIMER),
+    STATE_BLOCK(ANIM_STATE),
+    STATE_BLOCK(CINEMA_STATE),
+    STATE_BLOCK(FLASH_STATE),
+    STATE_BLOCK(ELEVATOR_MAX_FLOOR),
+    STATE_BLOCK(ELEVATOR_CURRENT_FLOOR)
+};
+#define STATE_BLOCK_COUNT (sizeof(STATE_BLOCKS) / sizeof(STATE_BLOCKS[0]))
+
+uint32_t Game::GAME_STATE_SIZE()
+{
+    uint32_t size = MAP_DATA_SIZE;
+    for (uint32_t i = 0; i != STATE_BLOCK_COUNT; i++) {
+        size += STATE_BLOCKS[i].size;
+    }
+    return size;
+}
+
+// Copies the map file data and the state blocks without the header
+uint32_t Game::SAVE_GAME_STATE(uint8_t* state)
+{
+    uint8_t* position = state;
+    for (int i = 0; i != MAP_DATA_SIZE; i++) {
+        *position++ = MAP_DATA[i];
+    }
+    for (uint32_t i = 0; i != STATE_BLOCK_COUNT; i++) {
+        for (int j = 0; j != STATE_BLOCKS[i].size; j++) {
+            *position++ = ((uint8_t*)(GameState*)this)[STATE_BLOCKS[i].offset + j];
+        }
+    }
+    return position - state;
+}
+
+void Game::RESTORE_GAME_STATE(uint8_t* state)
+{
+    uint8_t* position = state;
+    for (int i = 0; i != MAP_DATA_SIZE; i++) {
+        MAP_DATA[i] = *position++;
+    }
+    for (uint32_t i = 0; i != STATE_BLOCK_COUNT; i++) {
+        for (int j = 0; j != STATE_BLOCKS[i].size; j++) {
+            ((uint8_t*)(GameState*)this)[STATE_BLOCKS[i].offset + j] = *position++;
+        }
+    }
+    MAP_JOURNAL_OVERFLOW = 1; // The whole map may have changed
+    RESET_PAGES();
+    BUILD_MAP_PLANES();
+    BUILD_UNIT_SLOTS();
+    BUILD_LEVEL_INDEX();
+}
+
+uint32_t Game::SAVE_STATE(uint8_t* state)
+{
+    state[0] = 'P';
+    state[1] = 'R';
+    state[2] = SAVE_STATE_VERSION;
+    state[3] = STATE_BLOCK_COUNT;
+    state[4] = UNIT_COUNT;
+    state[5] = PLATFORM_MAP_WIDTH & 0xff;
+    state[6] = PLATFORM_MAP_WIDTH >> 8;
+    state[7] = PLATFORM_MAP_HEIGHT & 0xff;
+    state[8] = PLATFORM_MAP_HEIGHT >> 8;
+#ifdef PLATFORM_MAP_CHUNKS
+    state[9] = 1;
+#else
+    state[9] = 0;
+#endif
+    uint8_t* position = state + SAVE_STATE_HEADER_SIZE;
+    position += SAVE_GAME_STATE(position);
+    uint32_t audioSize = platform->saveAudioState(position + 2);
+    position[0] = audioSize & 0xff;
+    position[1] = audioSize >> 8;
+    position += 2 + audioSize;
+    return position - state;
+}
+
+bool Game::RESTORE_STATE(uint8_t* state, uint32_t size)
+{
+#ifdef PLATFORM_MAP_CHUNKS
+    uint8_t chunks = 1;
+#else
+    uint8_t chunks = 0;
+#endif
+    if (size < SAVE_STATE_HEADER_SIZE + GAME_STATE_SIZE() + 2 || state[0] != 'P' || state[1] != 'R' ||
+        state[2] != SAVE_STATE_VERSION || state[3] != STATE_BLOCK_COUNT || state[4] != UNIT_COUNT ||
+        (state[5] | (state[6] << 8)) != PLATFORM_MAP_WIDTH || (state[7] | (state[8] << 8)) != PLATFORM_MAP_HEIGHT ||
+        state[9] != chunks) {
+        return false;
+    }
+    uint8_t* position = state + SAVE_STATE_HEADER_SIZE;
+    RESTORE_GAME_STATE(position);
+    position += GAME_STATE_SIZE();
+    uint32_t audioSize = position[0] | (position[1] << 8);
+    if (!platform->restoreAudioState(position + 2, audioSize)) {
+        if (MUSIC_ON == 1) {
+            START_IN_GAME_MUSIC();
+        } else {
+            platform->playModule(Platform::ModuleSoundFX);
+        }
+    }
+    return true;
+}
+
+char SAVE_STATE_FILENAME[] = "petrobots.sav";
+char MSG_SAVED[] = "game saved.";
+char MSG_LOADED[] = "game loaded.";
+char MSG_NOSAVE[] = "no saved game found.";
+
+void Game::QUICK_SAVE()
+{
+    uint32_t size = SAVE_STATE(SAVE_STATE_BUFFER);
+    if (platform->save(SAVE_STATE_FILENAME, SAVE_STATE_BUFFER, size) == size) {
+        PRINT_INFO(MSG_SAVED);
+    } else {
+        PLAY_SOUND(11); // error sound
+    }
+}
+
+void Game::QUICK_LOAD()
+{
+    uint32_t size = platform->load(SAVE_STATE_FILENAME, SAVE_STATE_BUFFER, SAVE_STATE_SIZE);
+    if (!RESTORE_STATE(SAVE_STATE_BUFFER, size)) {
+        PRINT_INFO(MSG_NOSAVE);
+        PLAY_SOUND(11); // error sound
+        return;
+    }
+    REDRAW_AFTER_RESTORE();
+#if PLATFORM_REWIND_SECONDS > 0
+    REWIND_RESET();
+#endif
+    PRINT_INFO(MSG_LOADED);
+}
+
+// Redraws everything that was derived from the game state
+void Game::REDRAW_AFTER_RESTORE()
+{
+    if (LIVE_MAP_ON == 1) {
+        RENDER_LIVE_MAP();
+    } else {
+        INVALIDATE_PREVIOUS_MAP();
+    }
+    REDRAW_WINDOW = 1;
+    DRAW_MAP_WINDOW();
+    DISPLAY_PLAYER_HEALTH();
+    DISPLAY_KEYS();
+    DISPLAY_WEAPON();
+    DISPLAY_ITEM();
+}
+
+#if PLATFORM_REWIND_SECONDS > 0
+// REWIND
+// Every tick the game state is XORed with the state of the previous
+// tick and the difference is stored run length encoded into a ring
+// buffer. Stepping backwards XORs the newest difference back. A full
+// keyframe is stored every REWIND_KEYFRAME_INTERVAL ticks so that the
+// state can be resynchronized while rewinding. Each record is framed
+// by its 32 bit length and type at both ends so that the ring can be
+// walked in both directions.
+#define REWIND_DELTA 0
+#define REWIND_KEYFRAME 1
+#define REWIND_FRAMING 10
+
+void Game::REWIND_RESET()
+{
+    REWIND_HEAD = 0;
+    REWIND_TAIL = 0;
+    REWIND_USED = 0;
+    REWIND_TICKS = 0;
+    REWIND_BYTES = 0;
+#ifdef PLATFORM_STATISTICS
+    debug("Rewind buffer %lu bytes, %lu seconds at %lu bytes per second\n", (uint32_t)REWIND_BUFFER_SIZE, (uint32_t)PLATFORM_REWIND_SECONDS, (uint32_t)PLATFORM_REWIND_BYTES_PER_SECOND);
+#endif
+}
+
+// Adds the XOR of one state byte with the state of the newest record
+// to the record being encoded, as pairs of zero run and literal counts
+// followed by the literals. Positions have to be increasing.
+void Game::REWIND_COMPARE(uint32_t position, uint8_t value)
+{
+    uint8_t difference = value ^ REWIND_PREVIOUS[position];
+    if (difference == 0) {
+        return;
+    }
+    REWIND_PREVIOUS[position] = value;
+    uint32_t skip = position - REWIND_POSITION;
+    if (REWIND_COUNT == 0 || skip != 0 || *REWIND_COUNT == 255) {
+        while (skip > 255) {
+            *REWIND_OUTPUT++ = 255;
+            *REWIND_OUTPUT++ = 0;
+            skip -= 255;
+        }
+        REWIND_OUTPUT[0] = skip;
+        REWIND_OUTPUT[1] = 0;
+        REWIND_COUNT = REWIND_OUTPUT + 1;
+        REWIND_OUTPUT += 2;
+    }
+    *REWIND_OUTPUT++ = difference;
+    (*REWIND_COUNT)++;
+    REWIND_POSITION = position + 1;
+}
+
+// Encodes the changes of the game state since the newest record. With
+// the map journal only the map tiles written since then and the units
+// that exist are compared.
+uint32_t Game::REWIND_ENCODE(bool journal)
+{
+    REWIND_OUTPUT = REWIND_RECORD_DATA;
+    REWIND_COUNT = 0;
+    REWIND_POSITION = 0;
+    uint32_t mapStart = MAP - MAP_DATA;
+    if (journal) {
+        // Only units that exist now or did at the newest record can have changed
+        for (uint32_t ARRAY = 0; ARRAY != 8 * UNIT_COUNT; ARRAY += UNIT_COUNT) {
+            for (uint8_t WORD = 0; WORD != UNIT_WORDS; WORD++) {
+                for (uint32_t BITS = UNIT_SLOTS[WORD] | REWIND_UNITS[WORD]; BITS != 0; BITS &= BITS - 1) {
+                    uint32_t i = ARRAY + (WORD << 5) + __builtin_ctz(BITS);
+                    REWIND_COMPARE(i, MAP_DATA[i]);
+                }
+            }
+        }
+        for (uint32_t i = 8 * UNIT_COUNT; i != mapStart; i++) {
+            REWIND_COMPARE(i, MAP_DATA[i]);
+        }
+        // Sort the written tiles into map order
+        uint32_t cells[PLATFORM_MAP_JOURNAL_SIZE];
+        for (uint16_t i = 0; i != MAP_JOURNAL_COUNT; i++) {
+            uint32_t cell = MAP_CELL(MAP_JOURNAL[i].x, MAP_JOURNAL[i].y);
+            uint16_t j = i;
+            for (; j != 0 && cells[j - 1] > cell; j--) {
+                cells[j] = cells[j - 1];
+            }
+            cells[j] = cell;
+        }
+        for (uint16_t i = 0; i != MAP_JOURNAL_COUNT; i++) {
+            REWIND_COMPARE(mapStart + cells[i], MAP[cells[i]]);
+        }
+    } else {
+        for (uint32_t i = 0; i != MAP_DATA_SIZE; i++) {
+            REWIND_COMPARE(i, MAP_DATA[i]);
+        }
+    }
+    uint32_t position = MAP_DATA_SIZE;
+    for (uint32_t i = 0; i != STATE_BLOCK_COUNT; i++) {
+        for (int j = 0; j != STATE_BLOCKS[i].size; j++) {
+            REWIND_COMPARE(position++, ((uint8_t*)(GameState*)this)[STATE_BLOCKS[i].offset + j]);
+        }
+    }
+    for (uint8_t WORD = 0; WORD != UNIT_WORDS; WORD++) {
+        REWIND_UNITS[WORD] = UNIT_SLOTS[WORD];
+    }
+    return REWIND_OUTPUT - REWIND_RECORD_DATA;
+}
+
+void Game::REWIND_DECODE(uint8_t* state, uint32_t recordSize)
+{
+    uint8_t* input = REWIND_RECORD_DATA;
+    uint8_t* end = REWIND_RECORD_DATA + recordSize;
+    while (input != end) {
+        state += input[0];
+        uint8_t count = input[1];
+        input += 2;
+        for (uint8_t i = 0; i != count; i++) {
+            *state++ ^= *input++;
+        }
+    }
+}
+
+void Game::REWIND_WRITE(uint8_t value)
+{
+    REWIND_BUFFER[REWIND_HEAD] = value;
+    REWIND_HEAD = REWIND_HEAD + 1 != REWIND_BUFFER_SIZE ? REWIND_HEAD + 1 : 0;
+}
+
+uint8_t Game::REWIND_READ(uint32_t position)
+{
+    return REWIND_BUFFER[position % REWIND_BUFFER_SIZE];
+}
+
+void Game::REWIND_WRITE_SIZE(uint32_t size)
+{
+    REWIND_WRITE(size & 0xff);
+    REWIND_WRITE((size >> 8) & 0xff);
+    REWIND_WRITE((size >> 16) & 0xff);
+    REWIND_WRITE(size >> 24);
+}
+
+uint32_t Game::REWIND_READ_SIZE(uint32_t position)
+{
+    return REWIND_READ(position) | (REWIND_READ(position + 1) << 8) | (REWIND_READ(position + 2) << 16) | ((uint32_t)REWIND_READ(position + 3) << 24);
+}
+
+void Game::REWIND_STORE(uint8_t type, uint32_t recordSize)
+{
+    // Drop the oldest records until the new one fits
+    while (REWIND_USED != 0 && REWIND_USED + recordSize + REWIND_FRAMING > REWIND_BUFFER_SIZE) {
+        uint32_t size = REWIND_READ_SIZE(REWIND_TAIL) + REWIND_FRAMING;
+        REWIND_TAIL = (REWIND_TAIL + size) % REWIND_BUFFER_SIZE;
+        REWIND_USED -= size;
+    }
+    if (recordSize + REWIND_FRAMING > REWIND_BUFFER_SIZE) {
+        return;
+    }
+    REWIND_WRITE_SIZE(recordSize);
+    REWIND_WRITE(type);
+    for (uint32_t i = 0; i != recordSize; i++) {
+        REWIND_WRITE(REWIND_RECORD_DATA[i]);
+    }
+    REWIND_WRITE_SIZE(recordSize);
+    REWIND_WRITE(type);
+    REWIND_USED += recordSize + REWIND_FRAMING;
+    REWIND_BYTES += recordSize + REWIND_FRAMING;
+}
+
+// Called once per tick before the units are processed
+void Game::REWIND_RECORD()
+{
+    if (REWIND_USED == 0) {
+        for (uint32_t i = 0; i != GAME_STATE_MAX_SIZE; i++) {
+            REWIND_PREVIOUS[i] = 0;
+        }
+        REWIND_STORE(REWIND_KEYFRAME, REWIND_ENCODE(false));
+    } else {
+        REWIND_STORE(REWIND_DELTA, REWIND_ENCODE(MAP_JOURNAL_OVERFLOW == 0));
+        REWIND_TICKS++;
+        if (REWIND_TICKS == REWIND_KEYFRAME_INTERVAL) {
+            for (uint32_t i = 0; i != GAME_STATE_MAX_SIZE; i++) {
+                REWIND_PREVIOUS[i] = 0;
+            }
+            REWIND_STORE(REWIND_KEYFRAME, REWIND_ENCODE(false));
+#ifdef PLATFORM_STATISTICS
+            debug("Rewind %lu bytes per second, %lu of %lu bytes used\n", REWIND_BYTES * platform->framesPerSecond() / REWIND_KEYFRAME_INTERVAL, REWIND_USED, (uint32_t)REWIND_BUFFER_SIZE);
+#endif
+            REWIND_TICKS = 0;
+            REWIND_BYTES = 0;
+        }
+    }
+}
+
+// Removes the newest record from the ring and returns its type,
+// or 255 if the ring is empty
+uint8_t Game::REWIND_POP()
+{
+    if (REWIND_USED == 0) {
+        return 255;
+    }
+    uint32_t end = REWIND_HEAD + REWIND_BUFFER_SIZE;
+    uint8_t type = REWIND_READ(end - 1);
+    uint32_t recordSize = REWIND_READ_SIZE(end - 5);
+    uint32_t start = end - 5 - recordSize;
+    for (uint32_t i = 0; i != recordSize; i++) {
+        REWIND_RECORD_DATA[i] = REWIND_READ(start + i);
+    }
+    REWIND_HEAD = (start - 5) % REWIND_BUFFER_SIZE;
+    REWIND_USED -= recordSize + REWIND_FRAMING;
+    if (type == REWIND_KEYFRAME) {
+        for (uint32_t i = 0; i != GAME_STATE_MAX_SIZE; i++) {
+            REWIND_PREVIOUS[i] = 0;
+        }
+    }
+    REWIND_DECODE(REWIND_PREVIOUS, recordSize);
+    return type;
+}
+
+// Steps the game state one tick backwards
+bool Game::REWIND_STEP()
+{
+    uint8_t type = REWIND_POP();
+    if (type == REWIND_KEYFRAME) {
+        REWIND_TICKS = REWIND_KEYFRAME_INTERVAL;
+        type = REWIND_POP();
+    }
+    if (type != REWIND_DELTA) {
+        // Nothing older left, keep the state as the new starting point
+        REWIND_TAIL = REWIND_HEAD;
+        REWIND_USED = 0;
+        return false;
+    }
+    RESTORE_GAME_STATE(REWIND_PREVIOUS);
+    if (REWIND_TICKS != 0) {
+        REWIND_TICKS--;
+    }
+    return true;
+}
+
+// Rewinds for as long as the buttons are held down
+void Game::REWIND()
+{
+    while (!platform->quit) {
+        platform->keyRepeat();
+        uint16_t B = platform->readJoystick(true);
+        if ((B & Platform::JoystickPlay) == 0 || (B & Platform::JoystickUp) == 0) {
+            break;
+        }
+        if (REWIND_STEP()) {
+            REDRAW_AFTER_RESTORE();
+        }
+        platform->renderFrame(true);
+    }
+    CLEAR_KEY_BUFFER();
+}
+#endif
+
 // NOTES ABOUT UNIT TYPES
 // ----------------------
 // 000=no unit (does not exist)
@@ -4400,9 +5475,9 @@ void writeToScreenMemory(address_t address, uint8_t value, uint8_t color, uint8_
 // ---------------------------------
 // 0 = player unit
 // 1-27 = enemy robots    (max 28 units)
-// 28-31 = weapons fire
-// 32-47 = doors and other units that don't have sprites (max 16 units)
-// 48-63 = hidden objects to be found (max 16 units)
+// 28-31 = weapons fire (PLATFORM_WEAPON_SLOTS units, see UNIT_WEAPONS)
+// 32-47 = doors and other units that don't have sprites (max 16 units, see UNIT_DOORS)
+// 48-63 = hidden objects to be found (max 16 units, see UNIT_HIDDEN)
 
 // NOTES ABOUT DOORS.
 // -------------------
@@ -7,92 +7,10 @@
 #define MAP_WINDOW_WIDTH (PLATFORM_MAP_WINDOW_TILES_WIDTH * 24)
 #define MAP_WINDOW_HEIGHT (PLATFORM_MAP_WINDOW_TILES_HEIGHT * 24)
 
-extern uint8_t *DESTRUCT_PATH; // Destruct path array (256 bytes)
-extern uint8_t *TILE_ATTRIB;   // Tile attrib array (256 bytes)
-
-// These arrays can go anywhere in RAM
-extern uint8_t UNIT_TIMER_A[64];   // Primary timer for units (64 bytes)
-extern uint8_t UNIT_TIMER_B[64];   // Secondary timer for units (64 bytes)
-extern uint8_t UNIT_TILE[32];      // Current tile assigned to unit (32 bytes)
-extern uint8_t EXP_BUFFER[16];     // Explosion Buffer (16 bytes)
-extern uint8_t MAP_PRECALC[MAP_WINDOW_SIZE];    // Stores pre-calculated objects for map window (77 bytes)
-extern uint8_t MAP_PRECALC_DIRECTION[MAP_WINDOW_SIZE];    // Stores pre-calculated object directions for map window (77 bytes)
-extern uint8_t MAP_PRECALC_TYPE[MAP_WINDOW_SIZE];    // Stores pre-calculated object types for map window (77 bytes)
-extern uint8_t PREVIOUS_MAP_BACKGROUND[MAP_WINDOW_SIZE];
-extern uint8_t PREVIOUS_MAP_FOREGROUND[MAP_WINDOW_SIZE];
-extern uint8_t PREVIOUS_MAP_FOREGROUND_VARIANT[MAP_WINDOW_SIZE];
-
-// The following are the locations where the current
-// key controls are stored.  These must be set before
-// the game can start.
-extern uint8_t KEY_CONFIG[26];
-
-// MAP FILES CONSIST OF EVERYTHING FROM THIS POINT ON
-extern uint8_t MAP_DATA[8960];
-extern uint8_t* UNIT_TYPE;
-extern uint8_t* UNIT_LOC_X;
-extern uint8_t* UNIT_LOC_Y;
-extern uint8_t* UNIT_A;
-extern uint8_t* UNIT_B;
-extern uint8_t* UNIT_C;
-extern uint8_t* UNIT_D;
-extern int8_t* UNIT_HEALTH;
-extern uint8_t* MAP;
-// END OF MAP FILE
-
-extern uint8_t TILE;           // The tile number to be plotted
-extern uint8_t DIRECTION;      // The direction of the tile to be plotted
-extern uint8_t WALK_FRAME;     // Player walking animation frame
-extern uint8_t DEMATERIALIZE_FRAME; // Dematerialize animation frame
-extern uint8_t MAP_X;          // Current X location on map
-extern uint8_t MAP_Y;          // Current Y location on map
-extern uint8_t MAP_WINDOW_X;   // Top left location of what is displayed in map window
-extern uint8_t MAP_WINDOW_Y;   // Top left location of what is displayed in map window
-extern uint8_t DECNUM;         // a decimal number to be displayed onscreen as 3 digits.
-extern uint8_t ATTRIB;         // Tile attribute value
-extern uint8_t UNIT;           // Current unit being processed
-extern uint8_t TEMP_A;         // used within some routines
-extern uint8_t TEMP_B;         // used within some routines
-extern uint8_t TEMP_C;         // used within some routines
-extern uint8_t TEMP_D;         // used within some routines
-extern uint8_t CURSOR_X;       // For on-screen cursor
-extern uint8_t CURSOR_Y;       // For on-screen cursor
-extern uint8_t CURSOR_ON;      // Is cursor active or not? 1=yes 0=no
-extern uint8_t REDRAW_WINDOW;  // 1=yes 0=no
-extern uint8_t MOVE_RESULT;    // 1=Move request success, 0=fail.
-extern uint8_t UNIT_FIND;      // 255=no unit present.
-extern uint8_t MOVE_TYPE;      // %00000001=WALK %00000010=HOVER
-extern uint8_t* CUR_PATTERN;   // stores the memory location of the current musical pattern being played.
-
 //extern uint8_t LSTX;           // $97 Current Key Pressed: 255 = No Key
-extern uint8_t NDX;            // $9E No. of Chars. in Keyboard Buffer (Queue)
-extern uint8_t* MAP_SOURCE;    // $FD
-extern uint8_t SCREEN_MEMORY[SCREEN_WIDTH_IN_CHARACTERS * SCREEN_HEIGHT_IN_CHARACTERS]; // $8000
 extern bool quit;
 
-void INIT_GAME();
-
-extern char MAPNAME[];
 extern const char* LOADMSG1;
-extern uint8_t KEYS; // bit0=spade bit2=heart bit3=star
-extern uint8_t AMMO_PISTOL; // how much ammo for the pistol
-extern uint8_t AMMO_PLASMA; // how many shots of the plasmagun
-extern uint8_t INV_BOMBS; // How many bombs do we have
-extern uint8_t INV_EMP; // How many EMPs do we have
-extern uint8_t INV_MEDKIT; // How many medkits do we have?
-extern uint8_t INV_MAGNET; // How many magnets do we have?
-extern uint8_t SELECTED_WEAPON; // 0=none 1=pistol 2=plasmagun
-extern uint8_t SELECTED_ITEM; // 0=none 1=bomb 2=emp 3=medkit 4=magnet
-extern uint8_t SELECT_TIMEOUT; // can only change weapons once it hits zero
-extern uint8_t ANIMATE; // 0=DISABLED 1=ENABLED
-extern uint8_t BIG_EXP_ACT; // 0=No explosion active 1=big explosion active
-extern uint8_t MAGNET_ACT; // 0=no magnet active 1=magnet active
-extern uint8_t PLASMA_ACT; // 0=No plasma fire active 1=plasma fire active
-extern uint8_t RANDOM; // used for random number generation
-extern uint8_t BORDER; // Used for border flash timing
-extern uint8_t SCREEN_SHAKE; // 1=shake 0=no shake
-extern uint8_t CONTROL; // 0=keyboard 1=custom keys 2=snes
-extern uint16_t BORDER_COLOR; // Used for border flash coloring
 extern char INTRO_MESSAGE[];
 extern char MSG_CANTMOVE[];
 extern char MSG_BLOCKED[];
@@ -114,167 +32,31 @@ extern char MSG_LEVELS[];
 extern char MSG_PAUSED[];
 extern char MSG_MUSICON[];
 extern char MSG_MUSICOFF[];
-extern uint8_t SELECTED_MAP;
+extern char MSG_SAVED[];
+extern char MSG_LOADED[];
+extern char MSG_NOSAVE[];
 extern char MAP_NAMES[];
-extern uint8_t MUSIC_ON; // 0=off 1=on
-
-void DISPLAY_LOAD_MESSAGE1();
-void DISPLAY_LOAD_MESSAGE2();
 
 extern char LOAD_MSG2[];
 
-void SETUP_INTERRUPT();
-void RUNIRQ();
-
-extern uint8_t BGTIMER1;
-extern uint8_t BGTIMER2;
-extern uint8_t KEYTIMER; // Used for repeat of movement
-
-void UPDATE_GAME_CLOCK();
-
-extern uint8_t HOURS;
-extern uint8_t MINUTES;
-extern uint8_t SECONDS;
-extern uint8_t CYCLES;
-extern uint8_t CLOCK_ACTIVE;
-
-void SET_INITIAL_TIMERS();
-void MAIN_GAME_LOOP();
-void AFTER_MOVE_SNES();
-void TOGGLE_MUSIC();
-void START_IN_GAME_MUSIC();
-
 extern Platform::Module LEVEL_MUSIC[];
 
-void CHEATER();
-bool PAUSE_GAME();
-void CLEAR_KEY_BUFFER();
-void USE_ITEM();
-void USE_BOMB();
-void USE_MAGNET();
-bool BOMB_MAGNET_COMMON1();
-void BOMB_MAGNET_COMMON2();
-void USE_EMP();
-void USE_MEDKIT();
-void FIRE_UP();
-void FIRE_UP_PISTOL();
-void FIRE_UP_PLASMA();
-void FIRE_DOWN();
-void FIRE_DOWN_PISTOL();
-void FIRE_DOWN_PLASMA();
-void FIRE_LEFT();
-void FIRE_LEFT_PISTOL();
-void FIRE_LEFT_PLASMA();
-void FIRE_RIGHT();
-void FIRE_RIGHT_PISTOL();
-void FIRE_RIGHT_PLASMA();
-void AFTER_FIRE(int X);
-void KEY_REPEAT(bool keyDown);
-void AFTER_MOVE();
-
-extern uint8_t KEY_FAST; // 0=DEFAULT STATE
-
-void SEARCH_OBJECT();
-
-extern uint8_t SEARCHBAR; // to count how many periods to display.
-
-void CALC_COORDINATES();
-void USER_SELECT_OBJECT();
-void MOVE_OBJECT();
-
-extern uint8_t MOVTEMP_O; // origin tile
-extern uint8_t MOVTEMP_D; // destination tile
-extern uint8_t MOVTEMP_X; // x-coordinate
-extern uint8_t MOVTEMP_Y; // y-coordinate
-extern uint8_t MOVTEMP_U; // unit number (255=none)
-extern uint8_t MOVTEMP_UX;
-extern uint8_t MOVTEMP_UY;
-
-void CACULATE_AND_REDRAW();
-void MAP_PRE_CALCULATE();
-
 extern uint8_t PRECALC_ROWS[];
 
-void INVALIDATE_PREVIOUS_MAP();
-void DRAW_MAP_WINDOW();
-
-void TOGGLE_LIVE_MAP();
-void TOGGLE_LIVE_MAP_ROBOTS();
-void DRAW_LIVE_MAP();
-
-extern uint8_t LIVE_MAP_ON;
-extern uint8_t LIVE_MAP_ROBOTS_ON;
-extern uint8_t LIVE_MAP_PLAYER_BLINK;
-
-void PLOT_TILE(uint16_t destination, uint16_t x, uint16_t y);
-void PLOT_TRANSPARENT_TILE(uint16_t destination, uint16_t x, uint16_t y);
-void CHECK_FOR_WINDOW_REDRAW();
-void DECWRITE(uint16_t destination, uint8_t color = 10);
-
-void TILE_LOAD_ROUTINE();
-void MAP_LOAD_ROUTINE();
-void DISPLAY_GAME_SCREEN();
-
 extern char INTRO_OPTIONS[];
 
-void DISPLAY_INTRO_SCREEN();
-void DISPLAY_ENDGAME_SCREEN();
-
 extern char DIFF_LEVEL_WORDS[];
 
-void DECOMPRESS_SCREEN(uint8_t* source, uint8_t color = 10);
-
-extern uint8_t RPT; // repeat value
-
-void DISPLAY_PLAYER_HEALTH();
-void CYCLE_ITEM();
-void DISPLAY_ITEM();
-void PRESELECT_ITEM();
-void DISPLAY_TIMEBOMB();
-void DISPLAY_EMP();
-void DISPLAY_MEDKIT();
-void DISPLAY_MAGNET();
-void DISPLAY_BLANK_ITEM();
-void CYCLE_WEAPON();
-void DISPLAY_WEAPON();
-void PRESELECT_WEAPON();
-void DISPLAY_PLASMA_GUN();
-void DISPLAY_PISTOL();
-void DISPLAY_BLANK_WEAPON();
-void DISPLAY_KEYS();
-void GAME_OVER();
-void GOM4();
-
 extern uint8_t GAMEOVER1[];
 extern uint8_t GAMEOVER2[];
 extern uint8_t GAMEOVER3[];
 
-void DISPLAY_WIN_LOSE();
-
 extern char WIN_MSG[];
 extern char LOS_MSG[];
 
-void PRINT_INTRO_MESSAGE();
-void PRINT_INFO(const char *);
-
-extern uint8_t PRINTX;
-
-void SCROLL_INFO();
-void RESET_KEYS_AMMO();
-void INTRO_SCREEN();
-void START_INTRO_MUSIC();
-bool EXEC_COMMAND();
-void CYCLE_CONTROLS();
-
 extern char CONTROLTEXT[];
 extern uint8_t CONTROLSTART[];
 
-void CYCLE_MAP();
-void DISPLAY_MAP_NAME();
-char* CALC_MAP_NAME();
-void REVERSE_MENU_OPTION(bool reverse);
-
-extern uint8_t MENUY; // CURRENT MENU SELECTION
 #if (MAP_WINDOW_SIZE == 77)
 typedef uint8_t menu_chart_t;
 #else
@@ -282,148 +64,732 @@ typedef uint16_t menu_chart_t;
 #endif
 extern menu_chart_t MENU_CHART[];
 
-void CHANGE_DIFFICULTY_LEVEL();
+#if (MAP_WINDOW_SIZE <= 256)
+typedef uint8_t window_cell_t;
+#else
+typedef uint16_t window_cell_t;
+#endif
 
-extern uint8_t DIFF_LEVEL; // default medium
 extern uint8_t ROBOT_FACE[];
 extern uint8_t FACE_LEVEL[];
 
-void SET_DIFF_LEVEL();
-void SET_DIFF_EASY();
-void SET_DIFF_HARD();
-
 extern uint16_t MAP_CHART[PLATFORM_MAP_WINDOW_TILES_HEIGHT];
 
-void EMP_FLASH();
-void ANIMATE_WATER();
+extern uint8_t STANDARD_CONTROLS[];
+
+// Profiling routine numbers, the AI routines use their unit type
+#define PROFILE_DRAW_MAP_WINDOW 24
+#define PROFILE_REWIND_RECORD 25
+#define PROFILE_CHASE_FIELD 26
+#define PROFILE_ROUTINES 27
+
+extern uint8_t SCR_CUSTOM_KEYS[];
+extern char CINEMA_MESSAGE[];
+
+// The ranges of the unit table. Unit 0 is the player, the number of
+// units in each range can be changed from that of the original game.
+#ifndef PLATFORM_ROBOT_SLOTS
+#define PLATFORM_ROBOT_SLOTS 27
+#endif
+#ifndef PLATFORM_WEAPON_SLOTS
+#define PLATFORM_WEAPON_SLOTS 4
+#endif
+#ifndef PLATFORM_DOOR_SLOTS
+#define PLATFORM_DOOR_SLOTS 16
+#endif
+#ifndef PLATFORM_HIDDEN_SLOTS
+#define PLATFORM_HIDDEN_SLOTS 16
+#endif
+#define UNIT_ROBOTS 1       // enemy robots
+#define UNIT_WEAPONS (UNIT_ROBOTS + PLATFORM_ROBOT_SLOTS) // weapons fire, bombs and explosions
+#define UNIT_DOORS (UNIT_WEAPONS + PLATFORM_WEAPON_SLOTS) // doors and other units without sprites
+#define UNIT_HIDDEN (UNIT_DOORS + PLATFORM_DOOR_SLOTS) // hidden objects to be found
+#define UNIT_COUNT (UNIT_HIDDEN + PLATFORM_HIDDEN_SLOTS)
+#if UNIT_COUNT > 255
+#error There can be at most 255 units, unit 255 means none
+#endif
+#define UNIT_WORDS ((UNIT_COUNT + 31) / 32)
+
+#define RANGE_ROBOTS 0
+#define RANGE_WEAPONS 1
+#define RANGE_DOORS 2
+#define RANGE_HIDDEN 3
+#define UNIT_RANGES 4
+extern uint8_t UNIT_RANGE_START[UNIT_RANGES + 1];
+
+// The range of unit X, which mustn't be the player
+inline uint8_t UNIT_RANGE(uint8_t X)
+{
+    uint8_t RANGE = 0;
+    while (X >= UNIT_RANGE_START[RANGE + 1]) {
+        RANGE++;
+    }
+    return RANGE;
+}
+
+// The map size in tiles, 128x64 for the original levels. Smaller
+// levels are placed in the top left corner with tile 0 around them.
+// Unit locations are 8 bit, so units stay within the first 256x256.
+#ifndef PLATFORM_MAP_WIDTH
+#define PLATFORM_MAP_WIDTH 128
+#endif
+#ifndef PLATFORM_MAP_HEIGHT
+#define PLATFORM_MAP_HEIGHT 64
+#endif
+#if PLATFORM_MAP_WIDTH > 256 || PLATFORM_MAP_HEIGHT > 256
+typedef uint16_t map_coord_t;
+#else
+typedef uint8_t map_coord_t;
+#endif
 
-extern uint8_t WATER_TIMER;
-extern uint8_t ANIM_STATE;
-extern uint8_t CINEMA_STATE;
+// Define PLATFORM_MAP_CHUNKS to store the map in chunks of 16x16
+// tiles, so that the tiles around a location are close together
+// however wide the map is. Otherwise the map is stored row by row.
+#ifdef PLATFORM_MAP_CHUNKS
+#define MAP_CHUNKS_WIDE ((PLATFORM_MAP_WIDTH + 15) >> 4)
+#define MAP_CHUNKS_HIGH ((PLATFORM_MAP_HEIGHT + 15) >> 4)
+#define MAP_CELLS (MAP_CHUNKS_WIDE * MAP_CHUNKS_HIGH * 256)
+#else
+#define MAP_CELLS (PLATFORM_MAP_WIDTH * PLATFORM_MAP_HEIGHT)
+#endif
 
-void ELEVATOR_SELECT();
+// Offset of the tile at X/Y in MAP
+inline uint32_t MAP_CELL(uint16_t X, uint16_t Y)
+{
+#ifdef PLATFORM_MAP_CHUNKS
+    return ((uint32_t)((Y >> 4) * MAP_CHUNKS_WIDE + (X >> 4)) << 8) + ((Y & 15) << 4) + (X & 15);
+#else
+    return (uint32_t)Y * PLATFORM_MAP_WIDTH + X;
+#endif
+}
+
+// The walking units keep this far from the edges of the map
+#define MAP_UNIT_WIDTH (PLATFORM_MAP_WIDTH > 256 ? 256 : PLATFORM_MAP_WIDTH)
+#define MAP_UNIT_HEIGHT (PLATFORM_MAP_HEIGHT > 256 ? 256 : PLATFORM_MAP_HEIGHT)
+#define MAP_WALK_LEFT 5
+#define MAP_WALK_RIGHT (MAP_UNIT_WIDTH - 6)
+#define MAP_WALK_TOP 3
+#define MAP_WALK_BOTTOM (MAP_UNIT_HEIGHT - 4)
+#define CHASE_CELLS (MAP_UNIT_WIDTH * MAP_UNIT_HEIGHT)
+
+// The live map shows the top left 128x64 tiles row by row. Unless the
+// map is stored like that they are copied to LIVE_MAP_TILES.
+#define LIVE_MAP_WIDTH 128
+#define LIVE_MAP_HEIGHT 64
+#if defined(PLATFORM_MAP_CHUNKS) || PLATFORM_MAP_WIDTH != LIVE_MAP_WIDTH || PLATFORM_MAP_HEIGHT < LIVE_MAP_HEIGHT
+#define LIVE_MAP_COPY
+#endif
 
-extern uint8_t ELEVATOR_MAX_FLOOR;
-extern uint8_t ELEVATOR_CURRENT_FLOOR;
+// The original map files have 64 units: 27 robots, 4 weapons, 16 doors
+// and 16 hidden objects. Extended map files start with a header of
+// "PRX", a version and the number of units in each range. Version 2
+// adds the width and height of the map as 16 bit little endian, while
+// version 1 maps are 128x64. The header is followed by the unit arrays
+// with that many units. All then have 256 bytes that aren't used and
+// the map row by row. Version 3 files are written by Leveltool and
+// have the level index after the map: the number of floors, the
+// elevator of each floor as a unit of the door range (255=none) and
+// HIDDEN_PLANE row by row in 32 bit little endian words.
+#define MAP_FILE_SIZE 8960
+#define MAP_EXTENDED_HEADER_SIZE 12
+#define MAP_EXTENDED_VERSION 3
+#define MAP_DATA_SIZE (8 * UNIT_COUNT + 256 + MAP_CELLS)
+#define LEVEL_INDEX_MAX_SIZE (1 + 256 + PLATFORM_MAP_HEIGHT * PLANE_ROW_WORDS * 4)
+#define MAP_FILE_MAX_SIZE (MAP_EXTENDED_HEADER_SIZE + 8 * UNIT_COUNT + 256 + PLATFORM_MAP_WIDTH * PLATFORM_MAP_HEIGHT + LEVEL_INDEX_MAX_SIZE)
+// What UNPACK_MAP found in a map file
+#define MAP_INVALID 0   // Missing, truncated or too large, nothing was unpacked
+#define MAP_UNINDEXED 1 // Unpacked, the level index has to be built
+#define MAP_INDEXED 2   // Unpacked with the level index
+
+#define SAVE_STATE_VERSION 4
+#define SAVE_STATE_HEADER_SIZE 10
+// The map data, the unit timers, tiles and directions and room for the other state blocks
+#define GAME_STATE_MAX_SIZE (MAP_DATA_SIZE + 2 * UNIT_COUNT + 2 * UNIT_DOORS + 320)
+#define SAVE_STATE_SIZE (GAME_STATE_MAX_SIZE + 768)
+
+// Offset and size of a GameState member in a save state
+struct state_block_t {
+    uint32_t offset;
+    uint8_t size;
+};
+extern state_block_t STATE_BLOCKS[];
+
+// The rewind history length and the memory budget for each second of
+// it. Defining PLATFORM_REWIND_SECONDS=0 leaves rewind out.
+#ifndef PLATFORM_REWIND_SECONDS
+#define PLATFORM_REWIND_SECONDS 20
+#endif
+#ifndef PLATFORM_REWIND_BYTES_PER_SECOND
+#define PLATFORM_REWIND_BYTES_PER_SECOND 32768
+#endif
+#define REWIND_KEYFRAME_INTERVAL 300
+#define REWIND_BUFFER_SIZE (PLATFORM_REWIND_SECONDS * PLATFORM_REWIND_BYTES_PER_SECOND)
+// The largest encoded record: a state of bytes alternating between zero
+// and not takes 3 bytes for every 2, and each skip of 255 two more
+#define REWIND_RECORD_MAX_SIZE (GAME_STATE_MAX_SIZE * 3 / 2 + 2 * (GAME_STATE_MAX_SIZE / 255) + 4)
+
+// One tile written to the map, in the order of the writes
+struct map_change_t {
+    map_coord_t x;
+    map_coord_t y;
+    uint8_t previous;
+    uint8_t tile;
+};
+
+// Ticks run for each frame shown. With more than one, the ticks in
+// between run right away without drawing and the rate is reported.
+#ifndef PLATFORM_TURBO_TICKS
+#define PLATFORM_TURBO_TICKS 1
+#endif
 
-void ELEVATOR_INVERT();
-void ELEVATOR_INC();
-void ELEVATOR_DEC();
-void ELEVATOR_FIND_XY();
-void SET_CONTROLS();
+// Info window lines waiting to be scrolled in, one each tick
+#define INFO_QUEUE_SIZE 8
 
-extern uint8_t STANDARD_CONTROLS[];
+// The map window is drawn from background pages when the platform can
+// keep them. A page is PLATFORM_PAGE_TILES_WIDTH by PLATFORM_PAGE_TILES_HEIGHT
+// tiles of the map pre-rendered without units or animation, so that moving
+// the window takes a few page blits and the cells with units or animation.
+#ifndef PLATFORM_PAGE_TILES_WIDTH
+#define PLATFORM_PAGE_TILES_WIDTH (PLATFORM_MAP_WINDOW_TILES_WIDTH + 2)
+#endif
+#ifndef PLATFORM_PAGE_TILES_HEIGHT
+#define PLATFORM_PAGE_TILES_HEIGHT PLATFORM_MAP_WINDOW_TILES_HEIGHT
+#endif
+#define PAGE_COLUMNS ((PLATFORM_MAP_WIDTH + PLATFORM_PAGE_TILES_WIDTH - 1) / PLATFORM_PAGE_TILES_WIDTH)
+#define MAX_PAGES 16
+#define NO_PAGE 0xffff
 
-void SET_CUSTOM_KEYS();
-
-extern uint8_t KEYS_DEFINED; // DEFAULT 0
-
-void PET_SCREEN_SHAKE();
-void PET_BORDER_FLASH();
-
-extern uint8_t FLASH_STATE;
-
-void DEMATERIALIZE();
-void ANIMATE_PLAYER();
-void PLAY_SOUND(int);
-
-void STOP_SONG();
-void BACKGROUND_TASKS();
-
-extern void (*AI_ROUTINE_CHART[])(void);
-
-void DUMMY_ROUTINE();
-void WATER_RAFT_LR();
-void RAFT_DELETE();
-void RAFT_PLOT();
-void MAGNETIZED_ROBOT();
-void GENERATE_RANDOM_NUMBER();
-void MAGNET();
-void DEAD_ROBOT();
-void UP_DOWN_ROLLERBOT();
-void LEFT_RIGHT_ROLLERBOT();
-void ROLLERBOT_FIRE_DETECT();
-void ROLLERBOT_AFTER_FIRE(uint8_t unit, uint8_t tile);
-void ROLLERBOT_ANIMATE();
-void TRANSPORTER_PAD();
-void TRANS_PLAYER_PRESENT();
-void TRANS_ACTIVE();
-void TIME_BOMB();
-void BIG_EXP_PHASE1();
-void BEX1_NORTH();
-void BEX1_SOUTH();
-void BEX1_EAST();
-void BEX1_WEST();
-void BEX1_NE();
-void BEX1_NW();
-void BEX1_SE();
-void BEX1_SW();
-void BEX_PART1();
-bool BEX_PART2();
-void BEX_PART3();
-void BEXCEN();
-void BIG_EXP_PHASE2();
-void RESTORE_TILE();
-void TRASH_COMPACTOR();
-void DRAW_TRASH_COMPACTOR();
-extern uint8_t TCPIECE1;
-extern uint8_t TCPIECE2;
-extern uint8_t TCPIECE3;
-extern uint8_t TCPIECE4;
-void WATER_DROID();
-void PISTOL_FIRE_UP();
-void PISTOL_FIRE_DOWN();
-void PISTOL_FIRE_LEFT();
-void PISTOL_FIRE_RIGHT();
-void DEACTIVATE_WEAPON();
-void PISTOL_AI_COMMON();
-void ALTER_AI();
-void INFLICT_DAMAGE();
-void SMALL_EXPLOSION();
-void HOVER_ATTACK();
-void CREATE_PLAYER_EXPLOSION();
-void EVILBOT();
-void AI_DOOR();
-extern void (*AIDB[])(void);
-void DOOR_OPEN_A();
-void DOOR_OPEN_B();
-void DOOR_OPEN_FULL();
-void DOOR_CLOSE_A();
-void DOOR_CLOSE_B();
-void DOOR_CLOSE_FULL();
-void DRAW_VERTICAL_DOOR();
-void DRAW_HORIZONTAL_DOOR();
-extern uint8_t DOORPIECE1;
-extern uint8_t DOORPIECE2;
-extern uint8_t DOORPIECE3;
-void ROBOT_ATTACK_RANGE();
-void DOOR_CHECK_PROXIMITY();
-extern uint8_t PROX_DETECT;
-void ELEVATOR();
-extern void (*ELDB[])(void);
-void ELEV_OPEN_A();
-void ELEV_OPEN_B();
-void ELEV_OPEN_FULL();
-void ELEV_CLOSE_A();
-void ELEV_CLOSE_B();
-void ELEV_CLOSE_FULL();
-void ELEVATOR_PANEL();
-void PLOT_TILE_TO_MAP();
-void GET_TILE_FROM_MAP();
-void LEFT_RIGHT_DROID();
-void UP_DOWN_DROID();
-void HOVERBOT_ANIMATE(uint8_t X);
-void REQUEST_WALK_RIGHT();
-void REQUEST_WALK_LEFT();
-void REQUEST_WALK_DOWN();
-void REQUEST_WALK_UP();
-void CHECK_FOR_UNIT();
-void CHECK_FOR_HIDDEN_UNIT();
+// Map writes kept per tick before the consumers fall back to the whole map
+#ifndef PLATFORM_MAP_JOURNAL_SIZE
+#define PLATFORM_MAP_JOURNAL_SIZE 64
+#endif
 
-extern uint8_t SCR_CUSTOM_KEYS[];
-extern char CINEMA_MESSAGE[];
+// The big explosion walks BLAST_RAYS rays out of its center, each up to
+// PLATFORM_BLAST_RADIUS tiles and stopped by a tile that can't be seen
+// through or by the edge of the map. BLAST_RAY_X and BLAST_RAY_Y are the step of each ray, so the
+// shape of the explosion is only that table.
+#ifndef PLATFORM_BLAST_RADIUS
+#define PLATFORM_BLAST_RADIUS 2
+#endif
+#if PLATFORM_BLAST_RADIUS < 1 || PLATFORM_BLAST_RADIUS > 31
+#error "PLATFORM_BLAST_RADIUS must be 1 to 31, so that EXP_BUFFER fits a state block"
+#endif
+#define BLAST_RAYS 8
+#define BLAST_CELLS (1 + BLAST_RAYS * PLATFORM_BLAST_RADIUS)
+extern int8_t BLAST_RAY_X[BLAST_RAYS];
+extern int8_t BLAST_RAY_Y[BLAST_RAYS];
+
+// The map as one bit per tile for each bit of TILE_ATTRIB, so that
+// a tile can be tested without looking it up and a whole row of 32
+// tiles can be tested at once
+#define PLANE_WALK 0          // %00000001
+#define PLANE_HOVER 1         // %00000010
+#define PLANE_MOVABLE 2       // %00000100
+#define PLANE_DESTRUCTIBLE 3  // %00001000
+#define PLANE_SEE_THROUGH 4   // %00010000
+#define PLANE_PLACEABLE 5     // %00100000
+#define PLANE_SEARCHABLE 6    // %01000000
+#define PLANE_COUNT 7
+#define PLANE_ROW_WORDS ((PLATFORM_MAP_WIDTH + 31) / 32)
 
 void convertToPETSCII(char* string);
-void writeToScreenMemory(address_t address, uint8_t value, uint8_t color = 10, uint8_t yOffset = 0);
+
+#ifndef PLATFORM_CACHE_LINE_SIZE
+#define PLATFORM_CACHE_LINE_SIZE 64
+#endif
+
+// All mutable state of one game. The scratch variables and the map
+// pointers that the AI routines touch for every unit come first so
+// that they share the first cache lines, the large buffers come last.
+struct __attribute__((aligned(PLATFORM_CACHE_LINE_SIZE))) GameState {
+    uint8_t UNIT;           // Current unit being processed
+    uint8_t TEMP_A;         // used within some routines
+    uint8_t TEMP_B;         // used within some routines
+    uint8_t TEMP_C;         // used within some routines
+    uint8_t TEMP_D;         // used within some routines
+    uint8_t TILE;           // The tile number to be plotted
+    uint8_t DIRECTION;      // The direction of the tile to be plotted
+    uint8_t ATTRIB;         // Tile attribute value
+    map_coord_t MAP_X;      // Current X location on map
+    map_coord_t MAP_Y;      // Current Y location on map
+    uint8_t UNIT_FIND;      // 255=no unit present.
+    uint8_t MOVE_RESULT;    // 1=Move request success, 0=fail.
+    uint8_t MOVE_TYPE;      // %00000001=WALK %00000010=HOVER
+    uint8_t PROX_DETECT;    // 0=NO 1=YES
+    uint8_t RANDOM;         // used for random number generation
+    uint8_t MOVTEMP_O;      // origin tile
+    uint8_t MOVTEMP_D;      // destination tile
+    map_coord_t MOVTEMP_X;  // x-coordinate
+    map_coord_t MOVTEMP_Y;  // y-coordinate
+    uint8_t MOVTEMP_U;      // unit number (255=none)
+    map_coord_t MOVTEMP_UX;
+    map_coord_t MOVTEMP_UY;
+    map_coord_t MAP_WINDOW_X; // Top left location of what is displayed in map window
+    map_coord_t MAP_WINDOW_Y; // Top left location of what is displayed in map window
+    uint8_t REDRAW_WINDOW;  // 1=yes 0=no
+    uint8_t BGTIMER1;
+    uint8_t BGTIMER2;
+    uint8_t KEYTIMER;       // Used for repeat of movement
+    uint8_t BIG_EXP_ACT;    // 0=No explosion active 1=big explosion active
+    uint8_t MAGNET_ACT;     // 0=no magnet active 1=magnet active
+    uint8_t PLASMA_ACT;     // 0=No plasma fire active 1=plasma fire active
+    uint8_t DIFF_LEVEL;     // default medium
+
+    // MAP FILES CONSIST OF EVERYTHING FROM THIS POINT ON
+    uint8_t* MAP_DATA;
+    uint8_t* UNIT_TYPE;
+    uint8_t* UNIT_LOC_X;
+    uint8_t* UNIT_LOC_Y;
+    uint8_t* UNIT_A;
+    uint8_t* UNIT_B;
+    uint8_t* UNIT_C;
+    uint8_t* UNIT_D;
+    int8_t* UNIT_HEALTH;
+    uint8_t* MAP;
+    // END OF MAP FILE
+    uint8_t* DESTRUCT_PATH; // Destruct path array (256 bytes)
+    uint8_t* TILE_ATTRIB;   // Tile attrib array (256 bytes)
+
+    // These arrays can go anywhere in RAM
+    uint8_t UNIT_TIMER_A[UNIT_COUNT];   // Primary timer for units
+    uint8_t UNIT_TIMER_B[UNIT_COUNT];   // Secondary timer for units
+    uint8_t UNIT_TILE[UNIT_DOORS];      // Current tile assigned to unit
+    uint8_t UNIT_DIRECTION[UNIT_DOORS]; // Movement direction of unit
+    uint32_t UNIT_SLOTS[UNIT_WORDS];    // Bit per existing unit, rebuilt with the map
+    // Unit counts kept by ALLOCATE_UNIT, SET_UNIT_TYPE and RELEASE_UNIT. Define
+    // PLATFORM_CHECK_UNIT_COUNTS to compare them with the unit table every AI round.
+    uint8_t RANGE_UNITS[UNIT_RANGES];   // Existing units in each range
+    uint8_t TYPE_UNITS[256];            // Units of each type, type 0 being the free slots
+    uint8_t EXP_BUFFER[BLAST_RAYS * PLATFORM_BLAST_RADIUS]; // Explosion Buffer (tiles under each ray)
+    uint8_t EXP_REACH[BLAST_RAYS];      // Tiles stored in EXP_BUFFER for each ray
+
+    uint8_t WALK_FRAME;     // Player walking animation frame
+    uint8_t DEMATERIALIZE_FRAME; // Dematerialize animation frame
+    uint8_t DECNUM;         // a decimal number to be displayed onscreen as 3 digits.
+    uint8_t CURSOR_X;       // For on-screen cursor
+    uint8_t CURSOR_Y;       // For on-screen cursor
+    uint8_t CURSOR_ON;      // Is cursor active or not? 1=yes 0=no
+    uint8_t KEYS;           // bit0=spade bit2=heart bit3=star
+    uint8_t AMMO_PISTOL;    // how much ammo for the pistol
+    uint8_t AMMO_PLASMA;    // how many shots of the plasmagun
+    uint8_t INV_BOMBS;      // How many bombs do we have
+    uint8_t INV_EMP;        // How many EMPs do we have
+    uint8_t INV_MEDKIT;     // How many medkits do we have?
+    uint8_t INV_MAGNET;     // How many magnets do we have?
+    uint8_t SELECTED_WEAPON; // 0=none 1=pistol 2=plasmagun
+    uint8_t SELECTED_ITEM;  // 0=none 1=bomb 2=emp 3=medkit 4=magnet
+    uint8_t SELECT_TIMEOUT; // can only change weapons once it hits zero
+    uint8_t ANIMATE;        // 0=DISABLED 1=ENABLED
+    uint8_t BORDER;         // Used for border flash timing
+    uint8_t SCREEN_SHAKE;   // 1=shake 0=no shake
+    uint8_t CONTROL;        // 0=keyboard 1=custom keys 2=snes
+    uint16_t BORDER_COLOR;  // Used for border flash coloring
+    uint8_t SELECTED_MAP;
+    uint8_t MUSIC_ON;       // 0=off 1=on
+    uint8_t HOURS;
+    uint8_t MINUTES;
+    uint8_t SECONDS;
+    uint8_t CYCLES;
+    uint8_t CLOCK_ACTIVE;
+    uint8_t KEY_FAST;       // 0=DEFAULT STATE
+    uint8_t SEARCHBAR;      // to count how many periods to display.
+    uint8_t LIVE_MAP_ON;
+    uint8_t LIVE_MAP_ROBOTS_ON;
+    uint8_t LIVE_MAP_PLAYER_BLINK;
+    uint8_t RPT;            // repeat value
+    uint8_t PRINTX;         // used to store X-cursor location
+    uint8_t MENUY;          // CURRENT MENU SELECTION
+    uint8_t WATER_TIMER;
+    uint8_t ANIM_STATE;
+    uint8_t CINEMA_STATE;
+    uint8_t ELEVATOR_MAX_FLOOR;
+    uint8_t ELEVATOR_CURRENT_FLOOR;
+    uint8_t KEYS_DEFINED;   // DEFAULT 0
+    uint8_t FLASH_STATE;
+    uint8_t TCPIECE1;
+    uint8_t TCPIECE2;
+    uint8_t TCPIECE3;
+    uint8_t TCPIECE4;
+    uint8_t DOORPIECE1;
+    uint8_t DOORPIECE2;
+    uint8_t DOORPIECE3;
+    char MAPNAME[8];
+    uint8_t* CUR_PATTERN;   // stores the memory location of the current musical pattern being played.
+    uint8_t* MAP_SOURCE;    // $FD
+    uint32_t LOAD_START_TIME; // For measuring the time to first frame
+    uint32_t LOAD_TIME;
+    uint8_t TURBO_TICKS;    // Ticks for each frame shown, 1=normal speed
+    uint8_t TURBO_COUNT;    // Ticks left to run before the next frame
+    uint8_t TURBO_MAP_CHANGED; // 1=the map changed on a tick that wasn't drawn
+    uint32_t TURBO_TICK_COUNT; // Ticks since the rate was last reported
+    uint32_t TURBO_REPORT_TIME;
+    const char* INFO_QUEUE[INFO_QUEUE_SIZE]; // Lines to scroll in, 0=empty line
+    uint8_t INFO_QUEUE_HEAD;
+    uint8_t INFO_QUEUE_COUNT;
+    uint8_t FADE_IN_LEVEL;  // Screen intensity while fading in, 15=done
+
+    // The following are the locations where the current
+    // key controls are stored.  These must be set before
+    // the game can start.
+    uint8_t KEY_CONFIG[26];
+
+    uint8_t MAP_PRECALC[MAP_WINDOW_SIZE];    // Stores pre-calculated objects for map window (77 bytes)
+    uint8_t MAP_PRECALC_DIRECTION[MAP_WINDOW_SIZE];    // Stores pre-calculated object directions for map window (77 bytes)
+    uint8_t MAP_PRECALC_TYPE[MAP_WINDOW_SIZE];    // Stores pre-calculated object types for map window (77 bytes)
+    uint8_t PREVIOUS_MAP_BACKGROUND[MAP_WINDOW_SIZE];
+    uint8_t PREVIOUS_MAP_BACKGROUND_VARIANT[MAP_WINDOW_SIZE];
+    uint8_t PREVIOUS_MAP_FOREGROUND[MAP_WINDOW_SIZE];
+    uint8_t PREVIOUS_MAP_FOREGROUND_VARIANT[MAP_WINDOW_SIZE];
+    window_cell_t ANIMATED_CELLS[MAP_WINDOW_SIZE]; // Map window cells that change on animation ticks
+    uint16_t ANIMATED_CELL_COUNT;
+    map_coord_t ANIMATED_CELLS_X; // Map window location the cells were collected at
+    map_coord_t ANIMATED_CELLS_Y;
+    uint8_t ANIMATE_WINDOW;   // 1=animated cells need to be redrawn
+    uint8_t PAGE_COUNT;       // Background pages the platform keeps, 0=none
+    uint16_t PAGE_MAP[MAX_PAGES]; // Map page held by each background page, NO_PAGE=none
+    uint8_t PAGE_STALE[MAX_PAGES]; // 1=a tile of the page has changed since it was rendered
+    uint32_t PAGE_USED[MAX_PAGES]; // Value of PAGE_CLOCK when last drawn
+    uint32_t PAGE_CLOCK;
+    map_coord_t PAGE_WINDOW_X; // Map window location last drawn from pages
+    map_coord_t PAGE_WINDOW_Y;
+    uint32_t PAGE_HITS;
+    uint32_t PAGE_MISSES;
+    uint32_t PAGE_REBUILDS;
+    map_change_t MAP_JOURNAL[PLATFORM_MAP_JOURNAL_SIZE]; // Map writes since the last tick
+    uint16_t MAP_JOURNAL_COUNT;
+    uint8_t MAP_JOURNAL_OVERFLOW; // 1=more writes than fit, or the whole map changed
+    uint32_t MAP_PLANES[PLANE_COUNT][PLATFORM_MAP_HEIGHT][PLANE_ROW_WORDS]; // Kept up to date by WRITE_MAP_TILE
+    uint8_t ELEVATOR_UNIT[256]; // First elevator of each floor, 255=none
+    uint32_t HIDDEN_PLANE[PLATFORM_MAP_HEIGHT][PLANE_ROW_WORDS]; // Tiles a hidden object may cover
+#ifdef PLATFORM_CHASE_FLOW_FIELD
+    uint16_t CHASE_DISTANCE[2][CHASE_CELLS]; // Steps to the player for walking and hovering units
+    uint16_t CHASE_QUEUE[2][CHASE_CELLS];
+    uint16_t CHASE_HEAD[2]; // The search only goes as far as the chasing units need
+    uint16_t CHASE_TAIL[2];
+    uint8_t CHASE_X[2];     // Player location the distances were computed for
+    uint8_t CHASE_Y[2];
+    uint8_t CHASE_VALID[2]; // 0=passability changed since
+    uint32_t CHASE_AREA[2][PLATFORM_MAP_HEIGHT][PLANE_ROW_WORDS]; // Tiles connected to the player, from the last complete search
+    uint8_t CHASE_AREA_VALID[2];
+#endif
+    uint8_t SCREEN_MEMORY[SCREEN_WIDTH_IN_CHARACTERS * SCREEN_HEIGHT_IN_CHARACTERS]; // $8000
+
+    uint8_t MAP_BUFFER[MAP_DATA_SIZE]; // Unit table and map in the layout of the ranges
+    uint8_t MAP_FILE_BUFFER[MAP_FILE_MAX_SIZE]; // The next level is prefetched here
+#ifdef LIVE_MAP_COPY
+    uint8_t LIVE_MAP_TILES[LIVE_MAP_WIDTH * LIVE_MAP_HEIGHT];
+#endif
+    uint8_t SAVE_STATE_BUFFER[SAVE_STATE_SIZE];
+
+#if PLATFORM_REWIND_SECONDS > 0
+    uint32_t REWIND_HEAD;   // Where the next record is written
+    uint32_t REWIND_TAIL;   // The oldest record
+    uint32_t REWIND_USED;
+    uint32_t REWIND_BYTES;  // Bytes stored since the last keyframe
+    uint16_t REWIND_TICKS;  // Ticks since the last keyframe
+    uint8_t REWIND_PREVIOUS[GAME_STATE_MAX_SIZE]; // State of the newest record
+    uint32_t REWIND_UNITS[UNIT_WORDS]; // UNIT_SLOTS at the newest record
+    uint8_t* REWIND_OUTPUT; // Where the record being encoded continues
+    uint8_t* REWIND_COUNT;  // Literal count of the open run
+    uint32_t REWIND_POSITION; // State position after the open run
+    uint8_t REWIND_RECORD_DATA[REWIND_RECORD_MAX_SIZE];
+    uint8_t REWIND_BUFFER[REWIND_BUFFER_SIZE];
+#endif
+};
+
+// The routines of the original, operating on the state of one game.
+// Every game has its own Platform, callbacks from the platform are
+// given the game as their context.
+class Game : public GameState {
+public:
+    Game(Platform* platform);
+
+    static void CONVERT_MESSAGES();
+    static void INTERRUPT(void* game);
+
+    void INITIALIZE();
+    void INIT_GAME();
+
+    void DISPLAY_LOAD_MESSAGE1();
+    void DISPLAY_LOAD_MESSAGE2();
+
+    void SETUP_INTERRUPT();
+    void RUNIRQ();
+    void WAIT_FOR_TICK();
+    void UPDATE_TIMELINE();
+    void REPORT_TURBO_RATE();
+
+    void UPDATE_GAME_CLOCK();
+
+    void SET_INITIAL_TIMERS();
+    void MAIN_GAME_LOOP();
+    void AFTER_MOVE_SNES();
+    void TOGGLE_MUSIC();
+    void START_IN_GAME_MUSIC();
+
+    void CHEATER();
+    bool PAUSE_GAME();
+    void CLEAR_KEY_BUFFER();
+    void USE_ITEM();
+    void USE_BOMB();
+    void USE_MAGNET();
+    bool BOMB_MAGNET_COMMON1();
+    void BOMB_MAGNET_COMMON2();
+    void USE_EMP();
+    void USE_MEDKIT();
+    void FIRE_UP();
+    void FIRE_UP_PISTOL();
+    void FIRE_UP_PLASMA();
+    void FIRE_DOWN();
+    void FIRE_DOWN_PISTOL();
+    void FIRE_DOWN_PLASMA();
+    void FIRE_LEFT();
+    void FIRE_LEFT_PISTOL();
+    void FIRE_LEFT_PLASMA();
+    void FIRE_RIGHT();
+    void FIRE_RIGHT_PISTOL();
+    void FIRE_RIGHT_PLASMA();
+    void AFTER_FIRE(int X);
+    void KEY_REPEAT(bool keyDown);
+    void AFTER_MOVE();
+
+    void SEARCH_OBJECT();
+
+    void CALC_COORDINATES();
+    void USER_SELECT_OBJECT();
+    void MOVE_OBJECT();
+
+    void CACULATE_AND_REDRAW();
+    void MAP_PRE_CALCULATE();
+
+    void INVALIDATE_PREVIOUS_MAP();
+    void RESET_PAGES();
+    void MARK_PAGE_STALE(uint16_t X, uint16_t Y);
+    uint8_t FIND_PAGE(uint16_t PAGE);
+    void DRAW_PAGES();
+    void REPORT_PAGES();
+    void DRAW_MAP_WINDOW();
+    bool ANIMATED_TILE(uint8_t& VARIANT);
+    uint8_t FOREGROUND_TILE(uint16_t CELL, uint8_t& FG_VARIANT);
+    void DRAW_MAP_CELL(uint16_t X, uint16_t Y, uint16_t CELL, uint8_t VARIANT, uint8_t FG_TILE, uint8_t FG_VARIANT);
+    void DRAW_MAP_CHANGES();
+
+    void TOGGLE_LIVE_MAP();
+    void TOGGLE_LIVE_MAP_ROBOTS();
+    void DRAW_LIVE_MAP();
+    uint8_t* LIVE_MAP_VIEW();
+    void RENDER_LIVE_MAP();
+    void RENDER_LIVE_MAP_TILE(uint16_t X, uint16_t Y);
+
+    void PLOT_TILE(uint16_t destination, uint16_t x, uint16_t y);
+    void PLOT_TRANSPARENT_TILE(uint16_t destination, uint16_t x, uint16_t y);
+    void CHECK_FOR_WINDOW_REDRAW();
+    void DECWRITE(uint16_t destination, uint8_t color = 10);
+
+    void TILE_LOAD_ROUTINE();
+    bool MAP_LOAD_ROUTINE();
+    void SET_MAP_DATA(uint8_t* data);
+    void PREFETCH_LEVEL();
+    void DISPLAY_GAME_SCREEN();
+
+    void DISPLAY_INTRO_SCREEN();
+    void DISPLAY_ENDGAME_SCREEN();
+
+    void DECOMPRESS_SCREEN(uint8_t* source, uint8_t color = 10);
+
+    void DISPLAY_PLAYER_HEALTH();
+    void CYCLE_ITEM();
+    void DISPLAY_ITEM();
+    void PRESELECT_ITEM();
+    void DISPLAY_TIMEBOMB();
+    void DISPLAY_EMP();
+    void DISPLAY_MEDKIT();
+    void DISPLAY_MAGNET();
+    void DISPLAY_BLANK_ITEM();
+    void CYCLE_WEAPON();
+    void DISPLAY_WEAPON();
+    void PRESELECT_WEAPON();
+    void DISPLAY_PLASMA_GUN();
+    void DISPLAY_PISTOL();
+    void DISPLAY_BLANK_WEAPON();
+    void DISPLAY_KEYS();
+    void GAME_OVER();
+    void GOM4();
+
+    void DISPLAY_WIN_LOSE();
+
+    void PRINT_INTRO_MESSAGE();
+    void PRINT_INFO(const char *);
+
+    void SCROLL_INFO();
+    void QUEUE_INFO(const char *);
+    void SHOW_INFO();
+    void FLUSH_INFO();
+    void CLEAR_INFO_QUEUE();
+    void FADE_OUT();
+    void FADE_IN();
+    void RESET_KEYS_AMMO();
+    void INTRO_SCREEN();
+    void START_INTRO_MUSIC();
+    bool EXEC_COMMAND();
+    void CYCLE_CONTROLS();
+
+    void CYCLE_MAP();
+    void DISPLAY_MAP_NAME();
+    char* CALC_MAP_NAME();
+    void REVERSE_MENU_OPTION(bool reverse);
+
+    void CHANGE_DIFFICULTY_LEVEL();
+
+    void SET_DIFF_LEVEL();
+    void SET_DIFF_EASY();
+    void SET_DIFF_HARD();
+
+    void EMP_FLASH();
+    void ANIMATE_WATER();
+
+    void ELEVATOR_SELECT();
+
+    void ELEVATOR_INVERT();
+    void ELEVATOR_INC();
+    void ELEVATOR_DEC();
+    void ELEVATOR_FIND_XY();
+    void SET_CONTROLS();
+
+    void SET_CUSTOM_KEYS();
+
+    void PET_SCREEN_SHAKE();
+    void PET_BORDER_FLASH();
+
+    void DEMATERIALIZE();
+    void ANIMATE_PLAYER();
+    void PLAY_SOUND(int);
+
+    void STOP_SONG();
+    void BACKGROUND_TASKS();
+
+    static void (Game::*AI_ROUTINE_CHART[])();
+
+    void DUMMY_ROUTINE();
+    void WATER_RAFT_LR();
+    void RAFT_DELETE();
+    void RAFT_PLOT();
+    void MAGNETIZED_ROBOT();
+    void GENERATE_RANDOM_NUMBER();
+    void MAGNET();
+    void DEAD_ROBOT();
+    void UP_DOWN_ROLLERBOT();
+    void LEFT_RIGHT_ROLLERBOT();
+    void ROLLERBOT_FIRE_DETECT();
+    void ROLLERBOT_AFTER_FIRE(uint8_t unit, uint8_t tile);
+    void ROLLERBOT_ANIMATE();
+    void TRANSPORTER_PAD();
+    void TRANS_PLAYER_PRESENT();
+    void TRANS_ACTIVE();
+    void TIME_BOMB();
+    void BIG_EXP_PHASE1();
+    void BLAST_DAMAGE(uint8_t x, uint8_t y, const uint8_t* reach);
+    void BIG_EXP_PHASE2();
+    void RESTORE_TILE();
+    void TRASH_COMPACTOR();
+    void DRAW_TRASH_COMPACTOR();
+
+    void WATER_DROID();
+    void PISTOL_FIRE_UP();
+    void PISTOL_FIRE_DOWN();
+    void PISTOL_FIRE_LEFT();
+    void PISTOL_FIRE_RIGHT();
+    void DEACTIVATE_WEAPON();
+    void PISTOL_AI_COMMON();
+    void ALTER_AI();
+    void INFLICT_DAMAGE();
+    void SMALL_EXPLOSION();
+    void HOVER_ATTACK();
+    void CREATE_PLAYER_EXPLOSION();
+    void EVILBOT();
+    void AI_DOOR();
+    static void (Game::*AIDB[])();
+    void DOOR_OPEN_A();
+    void DOOR_OPEN_B();
+    void DOOR_OPEN_FULL();
+    void DOOR_CLOSE_A();
+    void DOOR_CLOSE_B();
+    void DOOR_CLOSE_FULL();
+    void DRAW_VERTICAL_DOOR();
+    void DRAW_HORIZONTAL_DOOR();
+
+    void ROBOT_ATTACK_RANGE();
+    void MOVE_TOWARD_PLAYER();
+#ifdef PLATFORM_CHASE_FLOW_FIELD
+    void RESET_CHASE_FIELD(uint8_t FIELD);
+    void EXPAND_CHASE_FIELD(uint8_t FIELD, uint16_t TARGET);
+    void CHASE_TILE_CHANGED(uint8_t FIELD, uint16_t X, uint16_t Y);
+    bool CHASE_PLAYER();
+#endif
+    void DOOR_CHECK_PROXIMITY();
+
+    void ELEVATOR();
+    static void (Game::*ELDB[])();
+    void ELEV_OPEN_A();
+    void ELEV_OPEN_B();
+    void ELEV_OPEN_FULL();
+    void ELEV_CLOSE_A();
+    void ELEV_CLOSE_B();
+    void ELEV_CLOSE_FULL();
+    void ELEVATOR_PANEL();
+    void PLOT_TILE_TO_MAP();
+    void GET_TILE_FROM_MAP();
+    void WRITE_MAP_TILE(uint16_t X, uint16_t Y, uint8_t NEW_TILE);
+    void CLEAR_MAP_JOURNAL();
+    void BUILD_MAP_PLANES();
+    uint8_t UNPACK_MAP(uint8_t* file, uint32_t size);
+    void BUILD_UNIT_SLOTS();
+    void BUILD_LEVEL_INDEX();
+    void MARK_HIDDEN_UNIT(uint8_t X);
+    uint8_t ALLOCATE_UNIT(uint8_t RANGE, uint8_t TYPE);
+    void SET_UNIT_TYPE(uint8_t X, uint8_t TYPE);
+    void RELEASE_UNIT(uint8_t X);
+    void CHECK_UNIT_COUNTS();
+    uint8_t NEXT_UNIT(uint16_t X, uint8_t END);
+    bool MAP_PLANE(uint8_t PLANE, uint16_t X, uint16_t Y);
+    void LEFT_RIGHT_DROID();
+    void UP_DOWN_DROID();
+    void HOVERBOT_ANIMATE(uint8_t X);
+    void REQUEST_WALK_RIGHT();
+    void REQUEST_WALK_LEFT();
+    void REQUEST_WALK_DOWN();
+    void REQUEST_WALK_UP();
+    void CHECK_FOR_UNIT();
+    void CHECK_FOR_HIDDEN_UNIT();
+
+    uint32_t SAVE_STATE(uint8_t* state);
+    bool RESTORE_STATE(uint8_t* state, uint32_t size);
+    void QUICK_SAVE();
+    void QUICK_LOAD();
+    void REDRAW_AFTER_RESTORE();
+    uint32_t GAME_STATE_SIZE();
+    uint32_t SAVE_GAME_STATE(uint8_t* state);
+    void RESTORE_GAME_STATE(uint8_t* state);
+
+#if PLATFORM_REWIND_SECONDS > 0
+    void REWIND_RESET();
+    void REWIND_COMPARE(uint32_t position, uint8_t value);
+    uint32_t REWIND_ENCODE(bool journal);
+    void REWIND_DECODE(uint8_t* state, uint32_t recordSize);
+    void REWIND_WRITE(uint8_t value);
+    uint8_t REWIND_READ(uint32_t position);
+    void REWIND_WRITE_SIZE(uint32_t size);
+    uint32_t REWIND_READ_SIZE(uint32_t position);
+    void REWIND_STORE(uint8_t type, uint32_t recordSize);
+    void REWIND_RECORD();
+    uint8_t REWIND_POP();
+    bool REWIND_STEP();
+    void REWIND();
+#endif
+
+    void writeToScreenMemory(address_t address, uint8_t value, uint8_t color = 10, uint8_t yOffset = 0);
+
+    Platform* platform;
+};
 
 #endif